@@ -0,0 +1,93 @@
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+#include "SearchEngine.h"
+
+// Entry of the open list, ordered by f = g + h, deeper entries first on ties
+struct OpenEntry
+{
+	int f;
+	int g;
+	int id;
+
+	bool operator<(const OpenEntry &other) const
+	{
+		return this->f != other.f ? this->f > other.f : this->g < other.g;
+	}
+};
+
+/*
+ * Binary heap of open cells. Entries are never updated in place: a cell whose
+ * cost improves is pushed again and the stale entry is skipped when popped.
+ */
+class OpenList
+{
+public:
+	void Clear()
+	{
+		this->m_heap.clear();
+	}
+
+	bool IsEmpty() const
+	{
+		return this->m_heap.empty();
+	}
+
+	std::size_t GetSize() const
+	{
+		return this->m_heap.size();
+	}
+
+	void Push(const OpenEntry &entry)
+	{
+		this->m_heap.push_back(entry);
+		std::push_heap(this->m_heap.begin(), this->m_heap.end());
+	}
+
+	OpenEntry Pop()
+	{
+		std::pop_heap(this->m_heap.begin(), this->m_heap.end());
+		const auto entry = this->m_heap.back();
+		this->m_heap.pop_back();
+		return entry;
+	}
+
+	std::size_t GetAllocatedBytes() const
+	{
+		return GetBufferBytes(this->m_heap);
+	}
+private:
+	std::vector<OpenEntry> m_heap;
+};
+
+/*
+ * A* on the uniform-cost grid. Straight moves cost STRAIGHT_COST and diagonal
+ * moves DIAGONAL_COST; the heuristic is the policy's open-grid distance
+ * (Manhattan, octile or hex), which is consistent, so every cell is expanded
+ * at most once and the path is optimal. Grid distances count moves.
+ */
+template <typename Conn>
+class AStarSearch final : public SearchEngine
+{
+public:
+	void Start(Grid *grid) override;
+	bool Step() override;
+	void Run() override;
+	std::size_t GetAllocatedBytes() const override;
+private:
+	bool Expand();
+
+	// Heuristic cost from a cell to the goal
+	int Heuristic(int id) const;
+
+	OpenList m_open;
+
+	// Best known cost from the start per cell
+	std::vector<int> m_cost;
+
+	// Goal position for the heuristic
+	int m_goalRow = 0;
+	int m_goalCol = 0;
+};
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <vector>
+
+#include "SearchEngine.h"
+
+/*
+ * BFS from the start and from the goal at the same time.
+ *
+ * Each step expands one whole level of the smaller frontier. When a level
+ * reaches cells of the other search, the shortest of the connections found in
+ * that level is kept and the search ends, which keeps the path shortest. The
+ * result is the cell where the searches met; Grid::GetPath stitches the
+ * forward and backward parent chains together there.
+ */
+template <typename Conn>
+class BidirectionalSearch final : public SearchEngine
+{
+public:
+	void Start(Grid *grid) override;
+	bool Step() override;
+	std::size_t GetAllocatedBytes() const override;
+private:
+	// Expand one level of either side
+	void ExpandForward();
+	void ExpandBackward();
+
+	// Frontiers of both searches and the level being built
+	std::vector<int> m_forward;
+	std::vector<int> m_backward;
+	std::vector<int> m_next;
+
+	// Distance of each frontier from its origin
+	int m_forwardDepth = 0;
+	int m_backwardDepth = 0;
+
+	// Best connection found so far
+	int m_meeting = NO_CELL;
+	int m_bestLength = 0;
+};
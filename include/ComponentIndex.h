@@ -0,0 +1,122 @@
+#pragma once
+
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "Connectivity.h"
+#include "ThreadPool.h"
+
+// Label of cells that belong to no component (walls)
+#define NO_COMPONENT -1
+
+/*
+ * Connected components of the open cells of a Grid, so a search can tell in
+ * O(1) that the goal is unreachable instead of flooding the start's region.
+ *
+ * Built with union-find: the rows are split into bands that worker threads
+ * label independently before the seams between bands are joined. Afterwards
+ * the index follows the grid's wall edits. Opening a cell unions it with its
+ * neighbors. Walling a cell off runs bounded local searches from its
+ * neighbors: pieces that turn out to be small are split off on the spot, and
+ * only a cut between two large pieces, or a resize or clear of the grid,
+ * falls back to a full build, done lazily by the next query.
+ */
+class ComponentIndex final : public GridObserver
+{
+public:
+	// Attaches to the grid, which must outlive the index
+	explicit ComponentIndex(Grid *grid, Connectivity connectivity = Connectivity::Four);
+	~ComponentIndex() override;
+
+	ComponentIndex(const ComponentIndex &) = delete;
+	ComponentIndex &operator=(const ComponentIndex &) = delete;
+
+	// Gets/sets the movement the components are computed for
+	Connectivity GetConnectivity() const;
+	void SetConnectivity(Connectivity connectivity);
+
+	// Sets the number of threads full builds run on, 0 picks one per core
+	void SetThreadCount(int threads);
+
+	// Checks if a path exists between two cells, false if either is a wall or NO_CELL
+	bool IsConnected(int a, int b);
+
+	// Label of the cell's component, NO_COMPONENT for walls; labels are only stable between edits
+	int GetComponent(int id);
+
+	// Number of cells in the cell's component, 0 for walls
+	int GetComponentSize(int id);
+
+	// Number of components
+	int GetComponentCount();
+
+	// Number of cells in the largest component, 0 without open cells; kept up to date by the edits
+	int GetLargestComponentSize();
+
+	// Sizes of every component, largest first; visits every cell
+	std::vector<int> GetComponentSizes();
+
+	// Number of full builds so far, edits applied in place don't count
+	int GetBuildCount() const;
+
+	void OnWallChanged(int id, bool wall) override;
+	void OnGridReset() override;
+private:
+	// Builds the index if an edit or a grid change invalidated it
+	void EnsureBuilt();
+	void Build();
+
+	// Labels rows [firstRow, lastRow] on their own, returns the number of successful unions
+	template <typename Conn>
+	int BuildBand(int firstRow, int lastRow);
+
+	// Joins the last row of a band with the first row of the next one
+	template <typename Conn>
+	int JoinSeam(int row);
+
+	// Applies a single wall edit
+	template <typename Conn>
+	void OpenCell(int id);
+	template <typename Conn>
+	void CloseCell(int id);
+
+	// Floods from a cell for at most a budget of cells, removing the targets it reaches, optionally
+	// stopping once none are left; returns true if the whole piece was flooded, its cells are then in m_queue
+	template <typename Conn>
+	bool Explore(int from, std::vector<int> *targets, bool stopWhenAllFound);
+
+	// Adds delta components of the given size to the size counts
+	void CountSize(int size, int delta);
+
+	// Union-find over nodes, every open cell points to one
+	int Find(int node);
+	bool Union(int a, int b);
+	int AddNode(int size);
+
+	Grid *m_grid;
+	Connectivity m_connectivity;
+
+	// Configured thread count, 0 for one per core
+	int m_threadCount = 0;
+	std::unique_ptr<ThreadPool> m_pool;
+
+	// Node of every cell, -1 for walls; a full build uses the cell id as node,
+	// cells opened or split off later get new nodes past the capacity
+	std::vector<int> m_node;
+	std::vector<int> m_parent;
+	std::vector<int> m_size;
+
+	int m_componentCount = 0;
+
+	// Number of components of every size, so the largest is known after splits
+	std::map<int, int> m_sizeCounts;
+
+	int m_buildCount = 0;
+	bool m_dirty = true;
+
+	// Scratch state of the local searches, a cell is flooded if its mark equals the stamp
+	std::vector<unsigned> m_mark;
+	unsigned m_stamp = 0;
+	std::vector<int> m_queue;
+};
@@ -0,0 +1,193 @@
+#pragma once
+
+#include <string>
+
+#include "Grid.h"
+
+/*
+ * Neighbor kernels, specialized at compile time per connectivity policy.
+ *
+ * Every policy iterates the open (non-wall) neighbors of a cell without
+ * allocating and without boundary checks: the Grid's sentinel border keeps
+ * every offset of an inner cell inside the grid. Engines are templated on the
+ * policy, so the 4-connected path contains no diagonal logic at all.
+ */
+
+// Movement allowed between cells
+enum class Connectivity
+{
+	Four,                   // North, South, East, West
+	Eight,                  // Plus diagonals, corners may be cut
+	EightNoCornerCutting,   // Plus diagonals, only if both adjacent sides are open
+	Hex,                    // Six neighbors, cells addressed by axial coordinates
+};
+
+// Short names used by the command line tools
+std::string GetConnectivityName(Connectivity connectivity);
+
+// Parses a short name ("4", "8", "8nc", "hex"), returns false if unknown
+bool ParseConnectivity(const std::string &name, Connectivity *connectivity);
+
+// Cost of a move in fixed point, so octile distances stay integers
+#define STRAIGHT_COST 10
+#define DIAGONAL_COST 14
+
+// Rule for diagonal moves past walls
+enum class CornerCutting
+{
+	Allow,
+	Forbid,
+};
+
+struct FourConnected
+{
+	static constexpr int Count = 4;
+	static constexpr bool HasDiagonals = false;
+
+	// Cost and number of moves between two cells on an open grid (Manhattan)
+	static int Cost(const int dRow, const int dCol)
+	{
+		return Steps(dRow, dCol) * STRAIGHT_COST;
+	}
+
+	static int Steps(const int dRow, const int dCol)
+	{
+		return (dRow < 0 ? -dRow : dRow) + (dCol < 0 ? -dCol : dCol);
+	}
+
+	// Calls fn(next, diagonal) for every open neighbor, stops early if fn returns false
+	template <typename Fn>
+	static bool ForEach(const Grid *grid, const int id, Fn &&fn)
+	{
+		const auto stride = grid->GetStride();
+
+		// South, North, East, West
+		if (!grid->IsWall(id + stride) && !fn(id + stride, false))
+			return false;
+		if (!grid->IsWall(id - stride) && !fn(id - stride, false))
+			return false;
+		if (!grid->IsWall(id + 1) && !fn(id + 1, false))
+			return false;
+		if (!grid->IsWall(id - 1) && !fn(id - 1, false))
+			return false;
+		return true;
+	}
+};
+
+template <CornerCutting Rule>
+struct EightConnected
+{
+	static constexpr int Count = 8;
+	static constexpr bool HasDiagonals = true;
+
+	// Octile distance
+	static int Cost(const int dRow, const int dCol)
+	{
+		const auto rows = dRow < 0 ? -dRow : dRow;
+		const auto cols = dCol < 0 ? -dCol : dCol;
+		const auto diagonal = rows < cols ? rows : cols;
+		return diagonal * DIAGONAL_COST + (rows + cols - 2 * diagonal) * STRAIGHT_COST;
+	}
+
+	static int Steps(const int dRow, const int dCol)
+	{
+		const auto rows = dRow < 0 ? -dRow : dRow;
+		const auto cols = dCol < 0 ? -dCol : dCol;
+		return rows > cols ? rows : cols;
+	}
+
+	template <typename Fn>
+	static bool ForEach(const Grid *grid, const int id, Fn &&fn)
+	{
+		const auto stride = grid->GetStride();
+		const auto south = !grid->IsWall(id + stride);
+		const auto north = !grid->IsWall(id - stride);
+		const auto east = !grid->IsWall(id + 1);
+		const auto west = !grid->IsWall(id - 1);
+
+		if (south && !fn(id + stride, false))
+			return false;
+		if (north && !fn(id - stride, false))
+			return false;
+		if (east && !fn(id + 1, false))
+			return false;
+		if (west && !fn(id - 1, false))
+			return false;
+
+		// A diagonal is open if the cell is, and, without corner cutting, both sides it passes are
+		const auto open = [&](const bool a, const bool b, const int next)
+		{
+			if (Rule == CornerCutting::Forbid && !(a && b))
+				return false;
+			return !grid->IsWall(next);
+		};
+
+		if (open(south, east, id + stride + 1) && !fn(id + stride + 1, true))
+			return false;
+		if (open(south, west, id + stride - 1) && !fn(id + stride - 1, true))
+			return false;
+		if (open(north, east, id - stride + 1) && !fn(id - stride + 1, true))
+			return false;
+		if (open(north, west, id - stride - 1) && !fn(id - stride - 1, true))
+			return false;
+		return true;
+	}
+};
+
+/*
+ * Hexagonal cells in axial coordinates: the row is r and the column is q, so
+ * the six neighbors are (q +- 1, r), (q, r +- 1), (q + 1, r - 1), (q - 1, r + 1),
+ * which are again constant offsets in the padded layout.
+ */
+struct HexConnected
+{
+	static constexpr int Count = 6;
+	static constexpr bool HasDiagonals = false;
+
+	// Hex distance in axial coordinates
+	static int Cost(const int dRow, const int dCol)
+	{
+		return Steps(dRow, dCol) * STRAIGHT_COST;
+	}
+
+	static int Steps(const int dRow, const int dCol)
+	{
+		const auto sum = dRow + dCol;
+		return ((dRow < 0 ? -dRow : dRow) + (dCol < 0 ? -dCol : dCol) + (sum < 0 ? -sum : sum)) / 2;
+	}
+
+	template <typename Fn>
+	static bool ForEach(const Grid *grid, const int id, Fn &&fn)
+	{
+		const auto stride = grid->GetStride();
+		const int offsets[Count] = { stride, -stride, 1, -1, -stride + 1, stride - 1 };
+
+		for (const auto offset : offsets)
+		{
+			if (!grid->IsWall(id + offset) && !fn(id + offset, false))
+				return false;
+		}
+		return true;
+	}
+};
+
+/*
+ * Calls fn with a default constructed policy matching the runtime connectivity,
+ * used to pick a specialized engine once per search.
+ */
+template <typename Fn>
+auto DispatchConnectivity(const Connectivity connectivity, Fn &&fn)
+{
+	switch (connectivity)
+	{
+	case Connectivity::Eight:
+		return fn(EightConnected<CornerCutting::Allow>());
+	case Connectivity::EightNoCornerCutting:
+		return fn(EightConnected<CornerCutting::Forbid>());
+	case Connectivity::Hex:
+		return fn(HexConnected());
+	case Connectivity::Four:
+	default:
+		return fn(FourConnected());
+	}
+}
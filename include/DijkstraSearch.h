@@ -0,0 +1,44 @@
+#pragma once
+
+#include <vector>
+
+#include "RadixHeap.h"
+#include "SearchEngine.h"
+
+/*
+ * Dijkstra on weighted terrain.
+ *
+ * Entering a cell costs its terrain cost times STRAIGHT_COST, or times
+ * DIAGONAL_COST for diagonal moves. Open cells are kept in a radix heap, since
+ * the weights are small integers and popped keys never decrease. When every
+ * cell has the default cost and moves have no diagonals, the search runs as a
+ * plain BFS with a FIFO queue, which expands the cells in the same order.
+ */
+template <typename Conn>
+class DijkstraSearch final : public SearchEngine
+{
+public:
+	void Start(Grid *grid) override;
+	bool Step() override;
+	void Run() override;
+	std::size_t GetAllocatedBytes() const override;
+
+	// Cost of the path found, 0 if none was found
+	long long GetPathCost() const;
+private:
+	// Expands one cell from the radix heap or from the FIFO queue
+	bool ExpandWeighted();
+	bool ExpandUniform();
+
+	// True if the costs can be ignored for this search
+	bool m_uniform = false;
+
+	RadixHeap m_open;
+
+	// FIFO queue of the uniform path, cells before m_head have been expanded
+	std::vector<int> m_queue;
+	std::size_t m_head = 0;
+
+	// Best known cost from the start per cell
+	std::vector<RadixHeap::Key> m_cost;
+};
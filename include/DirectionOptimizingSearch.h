@@ -0,0 +1,88 @@
+#pragma once
+
+#include <vector>
+
+#include "SearchEngine.h"
+
+// How a BFS level was expanded
+enum class LevelMode
+{
+	TopDown,    // Frontier cells push their unvisited neighbors
+	BottomUp,   // Unvisited cells look for a parent in the frontier
+};
+
+// One level of a direction-optimizing search
+struct LevelInfo
+{
+	LevelMode mode;
+	std::size_t frontier;
+};
+
+/*
+ * Switch points of the direction-optimizing search.
+ *
+ * Top-down switches to bottom-up once the frontier holds more than
+ * unvisited cells / alpha cells, and bottom-up switches back once the
+ * frontier is smaller than open cells / beta. Both counts are in cells: on a
+ * grid every cell has the same number of neighbor checks, so comparing the
+ * checks of the frontier and of the unvisited cells would give the same
+ * switch points.
+ */
+struct DirectionThresholds
+{
+	double alpha = 14.0;
+	double beta = 24.0;
+};
+
+// Parts of the direction-optimizing search shared by all connectivity policies
+class DirectionOptimizingBase : public SearchEngine
+{
+public:
+	// Sets the switch points, used by the next search
+	void SetThresholds(const DirectionThresholds &thresholds);
+	const DirectionThresholds &GetThresholds() const;
+
+	// Mode and frontier size of every level expanded so far
+	const std::vector<LevelInfo> &GetLevels() const;
+protected:
+	DirectionThresholds m_thresholds;
+	std::vector<LevelInfo> m_levels;
+};
+
+/*
+ * Level-synchronous BFS that switches between top-down queue expansion and
+ * bottom-up scanning of unvisited cells over a frontier bitmap. On open maps
+ * the frontier grows large and most top-down neighbor checks hit visited
+ * cells, bottom-up then touches every unvisited cell once per level instead.
+ * One step expands one whole level.
+ */
+template <typename Conn>
+class DirectionOptimizingSearch final : public DirectionOptimizingBase
+{
+public:
+	void Start(Grid *grid) override;
+	bool Step() override;
+	std::size_t GetAllocatedBytes() const override;
+private:
+	// Expands the frontier from its cells, returns true if the goal was found
+	bool TopDown(int distance);
+
+	// Finds frontier parents for unvisited cells, returns true if the goal was found
+	bool BottomUp(int distance);
+
+	// Cells of the current and the next level
+	std::vector<int> m_frontier;
+	std::vector<int> m_next;
+
+	// Bitmap of the current level, only filled for bottom-up levels
+	std::vector<GridWord> m_frontierBits;
+
+	// Open cells in total and not yet visited
+	long long m_openCells = 0;
+	long long m_unvisited = 0;
+
+	// Distance of the current frontier from the start
+	int m_distance = 0;
+
+	LevelMode m_mode = LevelMode::TopDown;
+};
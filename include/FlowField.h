@@ -0,0 +1,158 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <vector>
+
+#include "Connectivity.h"
+#include "SearchEngine.h"
+#include "ThreadPool.h"
+
+// Integration of cells the goal hasn't reached
+#define NO_INTEGRATION std::numeric_limits<int>::max()
+
+/*
+ * Integration and direction fields towards one goal, for crowds of units
+ * heading to the same place.
+ *
+ * A single reverse Dijkstra from the goal gives every reachable cell the cost
+ * of its cheapest path to the goal, with the move costs of DijkstraSearch:
+ * entering a cell costs its terrain cost times STRAIGHT_COST, or DIAGONAL_COST
+ * for diagonal moves. Since every move costs at least STRAIGHT_COST, the open
+ * cells are kept in buckets of equal cost, and all cells of a bucket are
+ * final when it's reached, so large buckets are expanded by a pool of worker
+ * threads that lower their neighbors' costs with an atomic minimum. Every cell
+ * then points to the neighbor on its cheapest path, so a unit's next move is
+ * one lookup.
+ *
+ * The field follows the grid's wall edits; cost edits are passed to
+ * UpdateCell. Refresh then only recomputes the cells whose path ran through
+ * an edited cell, from the costs of the cells around them, and the cells an
+ * opened cell brings closer to the goal. A resize or clear of the grid, or a
+ * new goal or connectivity, falls back to a full build.
+ */
+class FlowField final : public GridObserver
+{
+public:
+	// Attaches to the grid, which must outlive the field
+	explicit FlowField(Grid *grid, Connectivity connectivity = Connectivity::Four);
+	~FlowField() override;
+
+	FlowField(const FlowField &) = delete;
+	FlowField &operator=(const FlowField &) = delete;
+
+	// Gets/sets the movement the field is computed for
+	Connectivity GetConnectivity() const;
+	void SetConnectivity(Connectivity connectivity);
+
+	// Sets the number of threads full builds run on, 0 picks one per core
+	void SetThreadCount(int threads);
+
+	// Gets/sets the cell every unit heads to, NO_CELL leaves every cell unreachable
+	int GetGoal() const;
+	void SetGoal(int id);
+
+	// Marks a cell whose terrain cost changed, wall edits are noticed on their own
+	void UpdateCell(int id);
+
+	// Brings the fields up to date with the edits since the last refresh, returns the number of cells recomputed;
+	// the fields can be read once it ran
+	std::size_t Refresh();
+
+	// Checks if edits happened since the last refresh
+	bool IsStale() const;
+
+	// Cost of the cheapest path from the cell to the goal, NO_DISTANCE if the goal can't be reached
+	int GetIntegration(int id) const;
+
+	// Neighbor a unit on the cell moves to next, NO_CELL on the goal and on cells that can't reach it
+	int GetNext(int id) const;
+
+	// Counters of the last refresh
+	const SearchStats &GetStats() const;
+
+	// Number of full builds so far, incremental refreshes don't count
+	int GetBuildCount() const;
+
+	// Bytes of the fields and the buckets
+	std::size_t GetAllocatedBytes() const;
+
+	void OnWallChanged(int id, bool wall) override;
+	void OnGridReset() override;
+private:
+	// Computes both fields of every cell
+	template <typename Conn>
+	void Build();
+
+	// Recomputes the cells around the edits
+	template <typename Conn>
+	std::size_t Update();
+
+	// Adds the cells whose path runs through the cell to the affected cells, and forgets their costs
+	void Invalidate(int id);
+
+	// Lowers the cost of a cell to the cheapest move to a neighbor, seeds it if that helped
+	template <typename Conn>
+	void Reseed(int id);
+
+	// Expands the seeds and buckets until none is left, in parallel while buckets are large
+	template <typename Conn>
+	void Propagate();
+
+	// Expands bucket cells [begin, end) into the worker's list of lowered cells, counting into the stats
+	template <typename Conn>
+	void ExpandRange(int worker, std::size_t begin, std::size_t end, int cost, SearchStats *stats);
+
+	// Points the cells [begin, end) of a list, or of all ids without a list, to their cheapest neighbor
+	template <typename Conn>
+	void PointRange(const std::vector<int> *cells, std::size_t begin, std::size_t end);
+
+	// Queues a cell at a cost
+	void Push(int id, int cost);
+
+	Grid *m_grid;
+	Connectivity m_connectivity;
+	int m_goal = NO_CELL;
+
+	// Configured thread count, 0 for one per core
+	int m_threadCount = 0;
+	std::unique_ptr<ThreadPool> m_pool;
+
+	// Cost to the goal and next cell per id
+	std::vector<int> m_integration;
+	std::vector<int> m_next;
+
+	// Ring of buckets of equal cost, wider than the costliest move, and the number of queued cells
+	std::vector<std::vector<int>> m_buckets;
+	std::size_t m_queued = 0;
+	int m_cost = 0;
+
+	// Cells an update lowered with their costs, queued by Propagate in cost order
+	std::vector<std::pair<int, int>> m_seeds;
+
+	// Bucket being expanded, and each worker's cells lowered meanwhile with their new costs
+	std::vector<int> m_current;
+	std::vector<std::vector<std::pair<int, int>>> m_lowered;
+
+	// Edits since the last refresh, and the cells an update recomputes
+	std::vector<int> m_edits;
+	std::vector<int> m_changed;
+	bool m_dirty = true;
+
+	// Set while an update runs, queued cells are then recorded as changed
+	bool m_updating = false;
+
+	SearchStats m_stats;
+	int m_buildCount = 0;
+};
+
+inline int FlowField::GetIntegration(const int id) const
+{
+	return this->m_integration[id] == NO_INTEGRATION ? NO_DISTANCE : this->m_integration[id];
+}
+
+inline int FlowField::GetNext(const int id) const
+{
+	return this->m_next[id];
+}
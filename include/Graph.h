@@ -6,18 +6,27 @@
 #include <QFormLayout>
 #include <QLabel>
 #include <QComboBox>
+#include <QCheckBox>
+#include <QSpinBox>
 #include <QPushButton>
 #include <QMouseEvent>
 #include <QObject>
 #include <QStack>
 #include <QMessageBox>
+#include <QTimer>
+#include <QFileDialog>
 
 #include <iostream>
 
-#include "Vertex.h"
+#include "Grid.h"
+#include "GridItem.h"
 #include "PathFinder.h"
+#include "DirectionOptimizingSearch.h"
+#include "ComponentIndex.h"
+#include "FlowField.h"
+#include "MapGenerator.h"
 
-using SizeList = std::vector<std::pair<int, int>>;
+using SizeList = std::vector<std::pair<int, qreal>>;
 
 class Graph final : public QGraphicsView
 {
@@ -33,27 +42,48 @@ protected:
 	// Sets up the Graph group box
     void AddItemsToGroupBox(QGroupBox *groupBox);
 
-	// Set the start and goal vertices
+	// Places the start and goal in the corners unless the grid has them already
     void SetStartAndGoal() const;
 
 	// Default UI selections
     void SetDefaultSelections();
 
-	// Traces back a path from the exit (if it exists)
-    static int TracePath(Vertex *lastVertex, QStack<int> *stack);
+	// Traces back a path from the exit or the cell where a bidirectional search met (if it exists)
+    int TracePath(int lastVertex, QStack<int> *stack) const;
 
 	// Switches UI elements on and off
 	void UpdateUiState();
 
-	// Draws the Graph
+	// Sizes the grid to the selected cell size and redraws it
     void Render() const;
+
+	// Fits the view to the grid model's current size and redraws it
+	void DisplayGrid() const;
+
+	// Sets or removes a wall, the start and goal stay open
+	void SetWall(int id, bool wall) const;
+
+	// Engine specific details of the finished search, one line each
+	QString DescribeSearch() const;
+
+	// Shows the statistics of the current or last search
+	void UpdateStatistics() const;
+
+	// Appends the statistics of the finished search to the chosen log, if any
+	void LogStatistics();
 private:
     // UI Objects
     QWidget *m_currentTab;
     QGridLayout *m_tabLayout;
     QGraphicsScene *m_scene;
     QComboBox *m_algorithmSelection;
+    QComboBox *m_movementSelection;
     QComboBox *m_sizeSelection;
+	QComboBox *m_layoutSelection;
+	QSpinBox *m_seedSelection;
+    QLabel *m_regionsLabel;
+	QCheckBox *m_flowFieldCheck;
+	QLabel *m_statisticsLabel;
 
     // Buttons
     QPushButton *m_resetGraphButton;
@@ -61,25 +91,46 @@ private:
     QPushButton *m_stopTravelButton;
     QPushButton *m_clearGraphButton;
 	QPushButton *m_randomizeGraphButton;
+	QPushButton *m_openMapButton;
+	QPushButton *m_saveMapButton;
+	QPushButton *m_statisticsLogButton;
 
     // Graph attributes
     int m_sceneHeight;
     int m_sceneWidth;
-    int m_cellSize;
+    qreal m_cellSize;
     int m_vertexDescThreshold;
 	SizeList m_sizeList;
 
-	// A hash list to lookup vertices by their rendered shape
-	VertexHashShapeList *m_vertices;
+	// Grid model the vertices are a view of
+	Grid *m_grid;
 
-	// A hash list to lookup vertices by their unique ID
-	VertexHashIDList *m_vertexIdList;
+	// Connected regions of the grid, kept up to date with every wall edit
+	ComponentIndex *m_components;
+
+	// Moves of every cell towards the goal, refreshed around the edits while it's shown
+	FlowField *m_flowField;
+
+	// Single scene item drawing every cell
+	GridItem *m_gridItem;
+
+	// Applies the cell changes to the view once per frame
+	QTimer *m_frameTimer;
 
 	// Object for traversing the Graph
 	PathFinder *m_pathFinder;
 
-	// Flag to prevent wall set/un-setting during traversals
+	// Set while a search runs, the controls that reset the grid are disabled meanwhile
 	bool m_currentlyTraveling;
+
+	// Set while an incremental search repairs its path after an edit
+	bool m_replanning;
+
+	// Cells of the highlighted path, start first
+	std::vector<int> m_path;
+
+	// JSON-lines or CSV file every finished search is appended to, empty for none
+	QString m_statisticsLog;
 private slots:
 	// Sets a new Graph size
     void NewSize();
@@ -96,10 +147,31 @@ private slots:
 	// Resets Graph entirely
     void Clear() const;
 
-	// Place random walls on Graph
+	// Generates a map of the selected layout from the selected seed, then moves on to the next seed
 	void Randomize() const;
 
+	// Loads a binary or MovingAI map chosen by the user
+	void OpenMap();
+
+	// Saves the grid as a binary map, or as a MovingAI map for the .map extension
+	void SaveMap();
+
+	// Picks the file the statistics of finished searches are appended to
+	void ChooseStatisticsLog();
+
+	// Shows the number of connected regions and the size of the largest one
+	void UpdateRegions() const;
+
+	// Brings the flow field up to date with the grid and shows it, or hides it
+	void UpdateFlowField() const;
+
+	// Shows the cell changes since the last frame
+	void PresentFrame() const;
+
+	// Marks a vertex expanded by the search
+	void VisitVertex(int id) const;
+
 	// Displays the result of the search
-	void DisplayResults(Vertex *vertex);
+	void DisplayResults(int goal);
 };
 
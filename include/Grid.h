@@ -0,0 +1,395 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// Word type used by the wall/visited bitsets
+using GridWord = std::uint64_t;
+
+// Index of the lowest set bit, word must not be zero
+inline int LowestBit(const GridWord word)
+{
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward64(&index, word);
+	return static_cast<int>(index);
+#else
+	return __builtin_ctzll(word);
+#endif
+}
+
+// Number of set bits
+inline int CountBits(const GridWord word)
+{
+#ifdef _MSC_VER
+	return static_cast<int>(__popcnt64(word));
+#else
+	return __builtin_popcountll(word);
+#endif
+}
+
+// Marks "no cell" in parent links and start/goal ids
+#define NO_CELL -1
+
+// Marks a cell that has not been reached by a search
+#define NO_DISTANCE -1
+
+// Traversal cost of a cell, walls are stored separately
+using CellCost = std::uint8_t;
+
+// Cost of a cell nobody has set a terrain on
+#define DEFAULT_COST 1
+
+// Receives the wall edits of a Grid, used by indexes kept up to date alongside it
+class GridObserver
+{
+public:
+	virtual ~GridObserver() = default;
+
+	// A cell became a wall or was opened
+	virtual void OnWallChanged(int id, bool wall) = 0;
+
+	// The walls changed wholesale by a resize or a clear
+	virtual void OnGridReset() = 0;
+};
+
+/*
+ * Headless grid model, free of any Qt dependency.
+ *
+ * Wall and visited flags are stored as contiguous bitsets, parent links and
+ * distances as flat arrays indexed by cell id, so a search touches a few cache
+ * lines per expansion instead of chasing per-cell heap objects.
+ *
+ * The grid is stored with a one-cell border of sentinel walls, so a cell id is
+ * id = (row + 1) * stride + (col + 1) with stride = cols + 2. Every neighbor of
+ * an inner cell is then a constant offset away and search loops need no
+ * boundary checks.
+ */
+class Grid
+{
+public:
+	// Creates a grid with all cells open
+	Grid(int rows = 0, int cols = 0);
+
+	// Resizes the grid, clearing walls and search state
+	void Resize(int rows, int cols);
+
+	// Dimensions of the grid
+	int GetRows() const;
+	int GetCols() const;
+	int GetSize() const;
+
+	// Distance between vertically adjacent cell ids
+	int GetStride() const;
+
+	// Number of ids including the sentinel border, valid ids are below it
+	int GetCapacity() const;
+
+	// Converts between ids and row/column positions
+	int GetId(int row, int col) const;
+	int GetRow(int id) const;
+	int GetCol(int id) const;
+
+	// Position of the cell in row-major order without the border, as shown to users
+	int GetCellNumber(int id) const;
+
+	// Checks if the cell is a wall
+	bool IsWall(int id) const;
+
+	// Sets the cell to a wall, start and goal cells are never walled
+	void SetWall(int id);
+
+	// Removes the wall from a cell
+	void UnsetWall(int id);
+
+	// Removes all walls, the sentinel border stays
+	void ClearWalls();
+
+	// Replaces every wall from GetWordCount() words in the padded id layout, as returned by
+	// GetWallWords; the border is restored and start and goal stay open
+	void SetWallWords(const GridWord *words);
+
+	// Replaces count wall words from the first, which carry the border like GetWallWords does;
+	// start and goal stay open and observers hear of every cell that changed
+	void CopyWallWords(int first, int count, const GridWord *words);
+
+	// Gets/sets the cost of entering a cell, at least 1
+	CellCost GetCost(int id) const;
+	void SetCost(int id, CellCost cost);
+
+	// Sets the cost of every cell from rows * cols values in row-major order
+	void SetCosts(const CellCost *costs);
+
+	// Gets/sets the costs of all GetCapacity() ids in the padded layout at once
+	const CellCost *GetCostData() const;
+	void SetCostData(const CellCost *costs);
+
+	// Replaces the costs of count ids from the first in the padded layout
+	void CopyCostData(int first, int count, const CellCost *costs);
+
+	// Resets every cell to DEFAULT_COST
+	void ClearCosts();
+
+	// Checks if every cell has DEFAULT_COST, searches can then skip the costs
+	bool IsUniformCost() const;
+
+	// Checks if the cell has been reached by the current search
+	bool WasVisited(int id) const;
+
+	// Sets/clears the visited flag of a cell
+	void SetVisited(int id, bool visited);
+
+	// Atomically sets the visited flag, returns false if it was already set, safe across threads
+	bool ClaimVisited(int id);
+
+	// Gets/sets the cell the search reached this cell from
+	int GetPrevious(int id) const;
+	void SetPrevious(int id, int previous);
+
+	// Gets/sets the number of steps from the start, or to the goal for cells reached from the goal
+	int GetDistance(int id) const;
+	void SetDistance(int id, int distance);
+
+	/*
+	 * State of searches that also run backwards from the goal. Cells reached
+	 * from the goal link to the next cell towards it, the forward and backward
+	 * chains are stitched together at the cell where the two searches met.
+	 * The backward arrays are only allocated by PrepareBackwardSearch.
+	 */
+	void PrepareBackwardSearch();
+	bool WasVisitedFromGoal(int id) const;
+	void SetVisitedFromGoal(int id);
+	int GetNext(int id) const;
+	void SetNext(int id, int next);
+
+	// Cells from the start to the goal through the given cell, which is the goal or a meeting cell
+	std::vector<int> GetPath(int last) const;
+
+	// Start and goal cells
+	int GetStart() const;
+	int GetGoal() const;
+	void SetStart(int id);
+	void SetGoal(int id);
+
+	// Clears visited flags, parents and distances but leaves walls intact
+	void ResetSearch();
+
+	// Bytes of the per-cell search state: visited flags, parents, distances and the backward arrays
+	std::size_t GetSearchStateBytes() const;
+
+	// Raw bitsets for word-parallel engines, bit (id & 63) of word (id >> 6) belongs to id
+	int GetWordCount() const;
+	const GridWord *GetWallWords() const;
+	GridWord *GetVisitedWords();
+
+	// Registers an observer of wall edits, the observer must remove itself before it is destroyed
+	void AddObserver(GridObserver *observer);
+	void RemoveObserver(GridObserver *observer);
+private:
+	// Observers belong to one grid, a copy of the grid starts without any
+	struct ObserverList
+	{
+		ObserverList() = default;
+		ObserverList(const ObserverList &) {}
+		ObserverList &operator=(const ObserverList &) { return *this; }
+
+		std::vector<GridObserver*> observers;
+	};
+
+	// Walls the sentinel border
+	void SetBorder();
+
+	// N-rows and N-columns of the grid
+	int m_rows;
+	int m_cols;
+	int m_stride;
+
+	// Start and goal cell ids
+	int m_start;
+	int m_goal;
+
+	// Bitsets, one bit per cell
+	std::vector<GridWord> m_walls;
+	std::vector<GridWord> m_visited;
+
+	// Terrain cost per cell and the number of cells whose cost isn't DEFAULT_COST
+	std::vector<CellCost> m_costs;
+	int m_weightedCells;
+
+	// Per-cell search state
+	std::vector<int> m_previous;
+	std::vector<int> m_distance;
+
+	// Per-cell state of backward searches, empty until needed
+	std::vector<GridWord> m_visitedFromGoal;
+	std::vector<int> m_next;
+
+	ObserverList m_observers;
+};
+
+// Accessors used by the search loops are kept inline
+
+inline int Grid::GetRows() const
+{
+	return this->m_rows;
+}
+
+inline int Grid::GetCols() const
+{
+	return this->m_cols;
+}
+
+inline int Grid::GetSize() const
+{
+	return this->m_rows * this->m_cols;
+}
+
+inline int Grid::GetStride() const
+{
+	return this->m_stride;
+}
+
+inline int Grid::GetCapacity() const
+{
+	return (this->m_rows + 2) * this->m_stride;
+}
+
+inline int Grid::GetId(const int row, const int col) const
+{
+	return (row + 1) * this->m_stride + col + 1;
+}
+
+inline int Grid::GetRow(const int id) const
+{
+	return id / this->m_stride - 1;
+}
+
+inline int Grid::GetCol(const int id) const
+{
+	return id % this->m_stride - 1;
+}
+
+inline int Grid::GetCellNumber(const int id) const
+{
+	return GetRow(id) * this->m_cols + GetCol(id);
+}
+
+inline bool Grid::IsWall(const int id) const
+{
+	return (this->m_walls[id >> 6] >> (id & 63)) & 1;
+}
+
+inline CellCost Grid::GetCost(const int id) const
+{
+	return this->m_costs[id];
+}
+
+inline bool Grid::IsUniformCost() const
+{
+	return this->m_weightedCells == 0;
+}
+
+inline bool Grid::WasVisited(const int id) const
+{
+	return (this->m_visited[id >> 6] >> (id & 63)) & 1;
+}
+
+inline void Grid::SetVisited(const int id, const bool visited)
+{
+	const auto bit = GridWord(1) << (id & 63);
+	if (visited)
+		this->m_visited[id >> 6] |= bit;
+	else
+		this->m_visited[id >> 6] &= ~bit;
+}
+
+inline bool Grid::ClaimVisited(const int id)
+{
+	const auto bit = GridWord(1) << (id & 63);
+	auto word = &this->m_visited[id >> 6];
+#ifdef _MSC_VER
+	static_assert(sizeof(GridWord) == sizeof(__int64), "visited words must be 64-bit");
+	const auto volatileWord = reinterpret_cast<volatile __int64*>(word);
+	if (*volatileWord & bit)
+		return false;
+	return (_InterlockedOr64(volatileWord, static_cast<__int64>(bit)) & bit) == 0;
+#else
+	if (__atomic_load_n(word, __ATOMIC_RELAXED) & bit)
+		return false;
+	return (__atomic_fetch_or(word, bit, __ATOMIC_RELAXED) & bit) == 0;
+#endif
+}
+
+inline int Grid::GetPrevious(const int id) const
+{
+	return this->m_previous[id];
+}
+
+inline void Grid::SetPrevious(const int id, const int previous)
+{
+	this->m_previous[id] = previous;
+}
+
+inline int Grid::GetDistance(const int id) const
+{
+	return this->m_distance[id];
+}
+
+inline void Grid::SetDistance(const int id, const int distance)
+{
+	this->m_distance[id] = distance;
+}
+
+inline bool Grid::WasVisitedFromGoal(const int id) const
+{
+	return (this->m_visitedFromGoal[id >> 6] >> (id & 63)) & 1;
+}
+
+inline void Grid::SetVisitedFromGoal(const int id)
+{
+	this->m_visitedFromGoal[id >> 6] |= GridWord(1) << (id & 63);
+}
+
+inline int Grid::GetNext(const int id) const
+{
+	return this->m_next.empty() ? NO_CELL : this->m_next[id];
+}
+
+inline void Grid::SetNext(const int id, const int next)
+{
+	this->m_next[id] = next;
+}
+
+inline int Grid::GetStart() const
+{
+	return this->m_start;
+}
+
+inline int Grid::GetGoal() const
+{
+	return this->m_goal;
+}
+
+inline int Grid::GetWordCount() const
+{
+	return static_cast<int>(this->m_walls.size());
+}
+
+inline const CellCost *Grid::GetCostData() const
+{
+	return this->m_costs.data();
+}
+
+inline const GridWord *Grid::GetWallWords() const
+{
+	return this->m_walls.data();
+}
+
+inline GridWord *Grid::GetVisitedWords()
+{
+	return this->m_visited.data();
+}
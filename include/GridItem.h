@@ -0,0 +1,118 @@
+#pragma once
+
+#include <QGraphicsItem>
+#include <QImage>
+#include <QPainter>
+#include <QStyleOptionGraphicsItem>
+
+#include <cstdint>
+#include <vector>
+
+#include "FlowField.h"
+#include "Grid.h"
+
+// Terrain costs placed from the UI, plain road has DEFAULT_COST
+#define MUD_COST 3
+#define WATER_COST 5
+
+// Most screen updates per second, changes in between are applied as one batch
+#define FRAME_RATE 60
+
+/*
+ * The whole grid as a single scene item.
+ *
+ * Every cell is one pixel of a QImage that is scaled to the cell size when
+ * painted, so the scene holds one item however many cells there are. The
+ * colors follow the Grid's state plus the marks placed by the search. The
+ * pixels and marks live in buffers the item owns and reuses across resizes,
+ * so switching sizes allocates only when the grid outgrows them.
+ *
+ * Changes are only recorded in a change buffer; Flush, called once per frame,
+ * recolors the changed pixels and repaints the rectangle around them in one
+ * update, so painting costs at most one repaint per frame however many cells
+ * the search touches in between. Cell numbers are drawn only for the exposed
+ * cells.
+ */
+class GridItem final : public QGraphicsItem
+{
+public:
+	// Creates the item viewing the grid, cells are cellSize scene units wide
+	GridItem(Grid *grid, qreal cellSize);
+
+	// Sizes the image to the grid, clears all marks and redraws every cell
+	void Reset(qreal cellSize);
+
+	// Scene units per cell
+	qreal GetCellSize() const;
+
+	// Cell under a point in item coordinates, NO_CELL outside the grid
+	int GetCellAt(const QPointF &point) const;
+
+	// Marks a cell as expanded by the search
+	void SetVisited(int id, bool visited);
+
+	// Highlights a cell as part of the path
+	void SetPath(int id, bool path);
+
+	// Removes the marks of every cell, in time proportional to the marked cells
+	void ClearMarks();
+
+	// Redraws a cell with the next frame after its state in the grid changed
+	void Refresh(int id);
+
+	// Applies the changes since the last frame and schedules one repaint covering them
+	void Flush();
+
+	// Draws the cell numbers on top of the cells
+	void SetShowNumbers(bool show);
+
+	// Draws an arrow from every cell to its next move in the flow field, nullptr for none; repaints the cells
+	void SetFlowField(const FlowField *field);
+
+	QRectF boundingRect() const override;
+	void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget) override;
+private:
+	// Marks of a cell, combined as bits
+	enum CellMark : std::uint8_t
+	{
+		VisitedMark = 1,
+		PathMark = 2,
+		PendingMark = 4,    // In the change buffer
+		ListedMark = 8,     // In the list of marked cells
+	};
+
+	// Sets or clears a mark and redraws the cell if it changed
+	void SetMark(int id, std::uint8_t mark, bool set);
+
+	// Color of a cell from its grid state and marks
+	QRgb GetColor(int id) const;
+
+	// Rectangle of a cell in item coordinates
+	QRectF GetCellRect(int id) const;
+
+	// Recolors every pixel of the image
+	void RefreshAll();
+
+	// Grid model holding the state of the cells
+	Grid *m_grid;
+
+	// Scene units per cell
+	qreal m_cellSize;
+
+	// One pixel per cell, row-major; the image is a view of the pixel buffer
+	std::vector<QRgb> m_pixels;
+	QImage m_image;
+
+	// Marks per cell id, and the cells that were given a visited or path mark
+	std::vector<std::uint8_t> m_marks;
+	std::vector<int> m_marked;
+
+	// Cells changed since the last frame, and the rows and columns they span
+	std::vector<int> m_changes;
+	QRect m_dirty;
+
+	bool m_showNumbers;
+
+	// Flow field drawn on top of the cells, may be nullptr
+	const FlowField *m_flowField;
+};
@@ -0,0 +1,220 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "Grid.h"
+
+// Wall words per snapshot tile, a tile covers 64 times as many ids
+#define SNAPSHOT_TILE_WORDS 256
+
+// Ids covered by one snapshot tile
+#define SNAPSHOT_TILE_CELLS (SNAPSHOT_TILE_WORDS * 64)
+
+// Snapshots that can be pinned at the same time, Pin waits for a free slot beyond that
+#define SNAPSHOT_READERS 128
+
+// Walls and costs of a fixed range of ids in the padded layout, never changed once published
+struct SnapshotTile
+{
+	// Unique across the store, a copy-on-write gets a new one
+	std::uint64_t serial = 0;
+
+	std::array<GridWord, SNAPSHOT_TILE_WORDS> walls;
+	std::array<CellCost, SNAPSHOT_TILE_CELLS> costs;
+};
+
+// One published state of the map; versions share the tiles they didn't change
+struct GridVersion
+{
+	std::uint64_t number = 0;
+	int rows = 0;
+	int cols = 0;
+	std::vector<std::shared_ptr<const SnapshotTile>> tiles;
+};
+
+class GridStore;
+
+/*
+ * A pinned version of a GridStore.
+ *
+ * While the handle lives the version can't be reclaimed, so it may be read
+ * without any lock. Ids follow the padded layout of Grid with the dimensions
+ * of the version.
+ */
+class GridSnapshot
+{
+public:
+	GridSnapshot(GridSnapshot &&other) noexcept;
+	GridSnapshot &operator=(GridSnapshot &&other) noexcept;
+	~GridSnapshot();
+
+	GridSnapshot(const GridSnapshot &) = delete;
+	GridSnapshot &operator=(const GridSnapshot &) = delete;
+
+	// Number of the version, increasing with every publish
+	std::uint64_t GetVersion() const;
+
+	// Dimensions of the map in this version
+	int GetRows() const;
+	int GetCols() const;
+
+	// Converts a row/column position to an id of this version
+	int GetId(int row, int col) const;
+
+	// Walls and costs of this version
+	bool IsWall(int id) const;
+	CellCost GetCost(int id) const;
+
+	// Tiles of this version, the last may reach past the capacity
+	int GetTileCount() const;
+	const SnapshotTile &GetTile(int index) const;
+
+	// Lets go of the version before the handle is destroyed
+	void Release();
+private:
+	friend class GridStore;
+
+	GridSnapshot(const GridStore *store, int slot, const GridVersion *version);
+
+	const GridStore *m_store;
+	int m_slot;
+	const GridVersion *m_version;
+};
+
+/*
+ * Versioned map shared by concurrent searches and an editor.
+ *
+ * The walls and costs of a version are split into tiles of consecutive ids.
+ * Writers edit a draft that copies a tile on its first write and shares the
+ * others with the current version; Publish turns the draft into the next
+ * version with a single atomic pointer swap. Writers are serialized by a
+ * mutex, readers never take it.
+ *
+ * A reader pins the current version by storing its pointer into a slot of a
+ * fixed table and checking that it is still current, a hazard pointer: a
+ * writer frees a replaced version only when no slot holds it, so memory of old
+ * versions goes back at the first Publish or Reclaim after their last reader
+ * released them.
+ */
+class GridStore
+{
+public:
+	// Creates a store whose first version holds the walls and costs of the grid
+	explicit GridStore(const Grid &grid = Grid());
+	~GridStore();
+
+	GridStore(const GridStore &) = delete;
+	GridStore &operator=(const GridStore &) = delete;
+
+	// Replaces the draft by the walls and costs of the grid, tiles that didn't change stay shared
+	void Assign(const Grid &grid);
+
+	// Edits the draft, false if the cell is outside the map
+	bool SetWall(int row, int col, bool wall);
+	bool SetCost(int row, int col, CellCost cost);
+
+	// Publishes the draft as the next version unless it's unchanged, returns the current version number
+	std::uint64_t Publish();
+
+	// Frees replaced versions no reader holds anymore
+	void Reclaim();
+
+	// Pins the current version, lock-free
+	GridSnapshot Pin() const;
+
+	// Number of the current version
+	std::uint64_t GetVersion() const;
+
+	// Versions in memory, the current one included
+	std::size_t GetLiveVersionCount() const;
+private:
+	friend class GridSnapshot;
+
+	// A reader slot on a cache line of its own
+	struct alignas(64) ReaderSlot
+	{
+		std::atomic<const GridVersion*> version{ nullptr };
+	};
+
+	// Starts a draft on the current version, the writer mutex is held
+	void BeginDraft();
+
+	// Tile of the draft that may be written, copied from the current version first if shared
+	SnapshotTile *GetDraftTile(int index);
+
+	// Creates an empty tile with a new serial
+	std::shared_ptr<SnapshotTile> CreateTile();
+
+	// Frees replaced versions no slot holds, the writer mutex is held
+	void ReclaimRetired();
+
+	// Empties the slot of a released snapshot
+	void Release(int slot) const;
+
+	std::atomic<const GridVersion*> m_current;
+	std::atomic<std::uint64_t> m_number;
+
+	// Serializes the writers, guards everything below
+	mutable std::mutex m_writeMutex;
+
+	// Next version and the tiles only it holds, null while there's no edit
+	std::unique_ptr<GridVersion> m_draft;
+	std::vector<std::shared_ptr<SnapshotTile>> m_draftTiles;
+
+	// Versions replaced but maybe still pinned
+	std::vector<const GridVersion*> m_retired;
+
+	std::uint64_t m_nextSerial;
+
+	mutable std::array<ReaderSlot, SNAPSHOT_READERS> m_readers;
+};
+
+/*
+ * Private grid kept in step with the versions of a GridStore.
+ *
+ * A search runs on a replica, so its grid doesn't change under it while the
+ * map is edited. Loading a newer version copies only the tiles whose serials
+ * changed since the last load, and wall edits reach the grid's observers cell
+ * by cell, so indexes such as the cluster graph of HPA* rebuild only around
+ * them.
+ */
+class GridReplica
+{
+public:
+	GridReplica();
+
+	// Brings the grid to the version of the snapshot; start and goal are kept open if the dimensions didn't change.
+	// Adds the ids whose wall or cost changed to the list if given, none when the dimensions changed
+	void Load(const GridSnapshot &snapshot, std::vector<int> *changed = nullptr);
+
+	// The grid, searches may run on it between loads
+	Grid *GetGrid();
+	const Grid *GetGrid() const;
+
+	// Number of the version loaded last
+	std::uint64_t GetVersion() const;
+private:
+	Grid m_grid;
+	std::uint64_t m_version;
+
+	// Serials of the tiles loaded last, zero for none
+	std::vector<std::uint64_t> m_serials;
+};
+
+inline bool GridSnapshot::IsWall(const int id) const
+{
+	const auto &tile = *this->m_version->tiles[id / SNAPSHOT_TILE_CELLS];
+	const auto offset = id % SNAPSHOT_TILE_CELLS;
+	return (tile.walls[offset >> 6] >> (offset & 63)) & 1;
+}
+
+inline CellCost GridSnapshot::GetCost(const int id) const
+{
+	return this->m_version->tiles[id / SNAPSHOT_TILE_CELLS]->costs[id % SNAPSHOT_TILE_CELLS];
+}
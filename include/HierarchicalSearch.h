@@ -0,0 +1,179 @@
+#pragma once
+
+#include <array>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "AStarSearch.h"
+#include "ThreadPool.h"
+
+// Side of a cluster of the abstract graph in cells
+#define CLUSTER_SIZE 32
+
+// Entrances at least this wide get a transition at each end instead of one in the middle
+#define ENTRANCE_SPLIT_WIDTH 6
+
+// Buckets of the searches inside a cluster, a power of two
+#define HIERARCHICAL_BUCKETS 64
+
+/*
+ * Hierarchical path-finding A* (HPA*) on the uniform-cost grid.
+ *
+ * The grid is cut into CLUSTER_SIZE square clusters. Along every border
+ * between two clusters, each run of open cell pairs is an entrance with one
+ * or two transitions, and the cells of a transition are the nodes of an
+ * abstract graph. Nodes in the same cluster are linked by their distance
+ * inside the cluster, precomputed once, and the two nodes of a transition by
+ * one straight move. A query connects start and goal to the nodes of their
+ * clusters, runs A* over the abstract graph and refines only the chosen route
+ * cell by cell, one cluster at a time. Paths are near optimal: routes have to
+ * pass the transitions.
+ *
+ * The engine watches the grid it searches. A wall edit marks the edited
+ * cluster, plus the neighbor it shares a border with if the cell lies on one,
+ * and the next query rebuilds just the marked clusters. Resizes and clears
+ * rebuild everything, spread over the configured threads.
+ *
+ * Transitions are straight pairs, which keeps every route for 4-way moves and
+ * 8-way moves without corner cutting. Routes of the other policies that only
+ * cross a border diagonally are missed, so for them a query the abstract
+ * graph can't answer falls back to flat A*.
+ *
+ * A query runs in one step. Between its own queries the engine clears only
+ * the cells of its last path instead of the whole grid, and it writes the
+ * parent chain of the path alone. The grid has to outlive the engine.
+ */
+template <typename Conn>
+class HierarchicalSearch final : public SearchEngine, public GridObserver
+{
+public:
+	HierarchicalSearch();
+	~HierarchicalSearch() override;
+
+	HierarchicalSearch(const HierarchicalSearch &) = delete;
+	HierarchicalSearch &operator=(const HierarchicalSearch &) = delete;
+
+	void Start(Grid *grid) override;
+	bool Step() override;
+	void SetThreadCount(int threads) override;
+	std::size_t GetAllocatedBytes() const override;
+
+	// Number of full builds and of single cluster rebuilds so far
+	int GetBuildCount() const;
+	int GetClusterRebuildCount() const;
+
+	void OnWallChanged(int id, bool wall) override;
+	void OnGridReset() override;
+private:
+	// Nodes of a cluster and the distances between them
+	struct Cluster
+	{
+		// Node cells, and the cells across the borders they have transitions to, NO_CELL if unused
+		std::vector<int> nodes;
+		std::vector<std::array<int, 4>> partners;
+
+		// Distance inside the cluster from node i to node j at i * nodes + j, INT_MAX if unreachable
+		std::vector<int> distances;
+
+		// Costs and parents of the nodes during a query, valid if the stamp is the query's
+		std::vector<int> cost;
+		std::vector<int> parent;
+		unsigned stamp = 0;
+	};
+
+	// Scratch state of a search confined to one cluster, indexed by the cell's position in it
+	struct LocalSearch
+	{
+		std::vector<int> cost;
+		std::vector<int> parent;
+		std::vector<unsigned> mark;
+		unsigned stamp = 0;
+
+		// Queued cells by f, modulo the number of buckets
+		std::array<std::vector<int>, HIERARCHICAL_BUCKETS> buckets;
+
+		// Neighbors looked at by the searches since the counter was cleared
+		std::uint64_t checks = 0;
+
+		// Cost of a position, INT_MAX if the last search didn't reach it
+		int GetCost(int local) const;
+	};
+
+	// Builds every cluster, or rebuilds the marked ones
+	void EnsureBuilt();
+
+	// Builds the listed clusters, in parallel if there are many
+	void BuildClusters(const std::vector<int> &clusters);
+
+	// Finds the transitions of a cluster and the distances between them
+	void BuildCluster(int cluster, LocalSearch *search);
+
+	// Adds the transitions of one border, first and across are the first cells inside and outside, step walks along it
+	void AddEntrances(Cluster *cluster, int first, int across, int step, int length);
+
+	// Marks a cluster to be rebuilt by the next query
+	void MarkDirty(int cluster);
+
+	// Searches the cluster from source, A* towards target, or without one a flood that stops once
+	// the nodes numbered firstNode and up are settled, past the last node it floods everything;
+	// returns the number of expanded cells
+	int SearchCluster(int cluster, int source, int target, int firstNode, LocalSearch *search, std::vector<int> *trace) const;
+
+	// Cluster of a cell and the rows and columns it spans
+	int GetCluster(int id) const;
+	void GetClusterBounds(int cluster, int *top, int *left, int *bottom, int *right) const;
+
+	// Position of a cell in a cluster's local search arrays
+	int GetLocalIndex(int cluster, int id) const;
+
+	// Lowers the cost of a node during a query, queues it if it improved
+	void Relax(int node, int cost, int parent);
+
+	// Abstract search followed by the refinement of its route
+	void Query();
+
+	// Links the refined route into the grid's parent chain
+	void WritePath(std::vector<int> *path);
+
+	// Grid the clusters belong to, the engine observes it
+	Grid *m_attached;
+
+	int m_clusterRows;
+	int m_clusterCols;
+	std::vector<Cluster> m_clusters;
+
+	// Node number of every cell in its cluster, -1 if the cell isn't a node
+	std::vector<std::int16_t> m_nodeIndex;
+
+	// Clusters edited since the last build
+	std::vector<int> m_dirty;
+	std::vector<std::uint8_t> m_isDirty;
+	bool m_built;
+
+	int m_buildCount;
+	int m_rebuildCount;
+
+	// Configured thread count, 0 for one per core, and one scratch per thread
+	int m_threadCount;
+	std::unique_ptr<ThreadPool> m_pool;
+	std::vector<LocalSearch> m_scratch;
+
+	// Abstract search; costs from the start to the start cluster's nodes and from the goal cluster's nodes to the goal
+	OpenList m_open;
+	unsigned m_stamp;
+	std::vector<int> m_startCost;
+	std::vector<int> m_goalCost;
+	int m_goalCostTotal;
+	int m_goalParent;
+
+	// Cells the last query wrote into the grid, false until a full reset made the grid ours
+	std::vector<int> m_lastPath;
+	bool m_ownsState;
+
+	// Position of every cell on the path being written
+	std::unordered_map<int, std::size_t> m_pathPositions;
+
+	// Fallback for routes the transitions can't express
+	AStarSearch<Conn> m_flat;
+};
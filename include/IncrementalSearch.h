@@ -0,0 +1,88 @@
+#pragma once
+
+#include <vector>
+
+#include "SearchEngine.h"
+
+// Entry of the LPA* queue, ordered by the smaller key (k1, k2) first
+struct IncrementalEntry
+{
+	long long k1;
+	int k2;
+	int id;
+
+	bool operator<(const IncrementalEntry &other) const
+	{
+		return this->k1 != other.k1 ? this->k1 > other.k1 : this->k2 > other.k2;
+	}
+};
+
+// Parts of the incremental search used without knowing the connectivity policy
+class IncrementalSearchBase : public SearchEngine
+{
+public:
+	// Tells the search that a cell's wall or cost changed since the last search
+	virtual void UpdateCell(int id) = 0;
+
+	// Repairs the path after UpdateCell calls, returns false if the goal is no longer reachable
+	virtual bool Replan() = 0;
+};
+
+/*
+ * Lifelong Planning A* (LPA*) between the grid's start and goal.
+ *
+ * Keeps g (cost of the last expansion) and rhs (one-step lookahead from the
+ * neighbors) for every cell between searches. A wall or cost edit changes the
+ * rhs of the edited cell and its ring of neighbors only, and the following
+ * Replan expands just the cells whose costs became inconsistent, instead of
+ * searching the whole map again. Moves cost like in the Dijkstra engine, the
+ * entered cell's terrain cost times STRAIGHT_COST or DIAGONAL_COST, and the
+ * heuristic is the policy's open-grid distance.
+ *
+ * The first search can be stepped one expansion at a time like the other
+ * engines; replans run to completion. The grid's parent chain and distances
+ * are written for the cells of the current path only, so a replan doesn't
+ * pay for resetting the whole grid.
+ */
+template <typename Conn>
+class IncrementalSearch final : public IncrementalSearchBase
+{
+public:
+	void Start(Grid *grid) override;
+	bool Step() override;
+	void Run() override;
+	std::size_t GetAllocatedBytes() const override;
+
+	void UpdateCell(int id) override;
+	bool Replan() override;
+private:
+	// Pops and expands one cell, returns false once the goal's cost is final
+	bool Expand();
+
+	// Recomputes rhs of a cell from its neighbors and queues it if inconsistent
+	void UpdateVertex(int id);
+
+	// Key of a cell in the queue
+	IncrementalEntry GetKey(int id) const;
+
+	// Heuristic cost from a cell to the goal
+	int Heuristic(int id) const;
+
+	// Clears the old path and links the new one from the goal back to the start
+	void FillPath();
+
+	// Cost of moving into a cell
+	int GetMoveCost(int id, bool diagonal) const;
+
+	// Binary heap with lazy deletion, entries whose key is outdated are skipped
+	std::vector<IncrementalEntry> m_open;
+
+	std::vector<int> m_g;
+	std::vector<int> m_rhs;
+
+	// Cells of the current path, start first
+	std::vector<int> m_path;
+
+	int m_goalRow = 0;
+	int m_goalCol = 0;
+};
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <vector>
+
+#include "AStarSearch.h"
+
+/*
+ * Jump Point Search on the uniform-cost grid.
+ *
+ * A* over jump points only: from each expanded cell the search scans straight
+ * and diagonal lines and stops at cells with forced neighbors, so the many
+ * symmetric paths of open areas are never put on the open list. Works for 4-
+ * and 8-connected movement with or without corner cutting; the hexagonal
+ * grid has no jump rules, CreateSearchEngine falls back to A* there.
+ *
+ * Only jump points are expanded. Once the goal is reached the cells between
+ * consecutive jump points are linked, so the grid holds a full parent chain.
+ */
+template <typename Conn>
+class JumpPointSearch final : public SearchEngine
+{
+public:
+	void Start(Grid *grid) override;
+	bool Step() override;
+	void Run() override;
+	std::size_t GetAllocatedBytes() const override;
+private:
+	bool Expand();
+
+	// Heuristic cost from a cell to the goal
+	int Heuristic(int id) const;
+
+	// Links the cells between the jump points of the path to the goal
+	void FillPath(int goal);
+
+	OpenList m_open;
+
+	// Best known cost from the start per cell
+	std::vector<int> m_cost;
+
+	int m_goalRow = 0;
+	int m_goalCol = 0;
+};
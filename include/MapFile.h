@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "Grid.h"
+
+/*
+ * Map files.
+ *
+ * The binary format stores the walls bit-packed in the Grid's own padded word
+ * layout, so loading maps the file and hands the words to the grid in one
+ * block copy, without parsing a cell. All fields are little-endian and every
+ * section starts on a 64 byte boundary:
+ *
+ *   MapHeader
+ *   walls       GetWordCount() 64-bit words
+ *   costs       GetCapacity() bytes, only if MAP_SECTION_COSTS is set
+ *   metadata    metadataSize bytes of free text, only if MAP_SECTION_METADATA is set
+ *
+ * MovingAI .map text files are parsed while streaming over the mapped text,
+ * '.', 'G' and 'S' are open and every other terrain is a wall.
+ */
+
+// Version written by SaveMap, older versions stay loadable
+#define MAP_FORMAT_VERSION 1
+
+// Optional sections of a binary map
+#define MAP_SECTION_COSTS 1u
+#define MAP_SECTION_METADATA 2u
+
+// Fixed 64 byte header of a binary map
+struct MapHeader
+{
+	char magic[8];              // "GRIDMAP" and a zero byte
+	std::uint32_t version;
+	std::uint32_t sections;     // MAP_SECTION_* bits
+	std::int32_t rows;
+	std::int32_t cols;
+	std::int32_t start;         // Cell number of the start, -1 if unset
+	std::int32_t goal;          // Cell number of the goal, -1 if unset
+	std::uint64_t wallsOffset;
+	std::uint64_t costsOffset;
+	std::uint64_t metadataOffset;
+	std::uint64_t metadataSize;
+};
+
+static_assert(sizeof(MapHeader) == 64, "map header must stay 64 bytes");
+
+// Loads a binary or MovingAI map, detected by its content; the metadata may be nullptr.
+// Start and goal missing from the file are placed on the first and last open cell
+bool LoadMap(const std::string &path, Grid *grid, std::string *metadata, std::string *error);
+
+// Saves the grid as a binary map, costs are only stored if they aren't uniform
+bool SaveMap(const std::string &path, const Grid &grid, const std::string &metadata, std::string *error);
+
+// Reads and writes MovingAI .map files, costs are not part of the format
+bool ImportMovingAiMap(const std::string &path, Grid *grid, std::string *error);
+bool ExportMovingAiMap(const std::string &path, const Grid &grid, std::string *error);
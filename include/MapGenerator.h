@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Grid.h"
+
+// Kinds of generated maps
+enum class MapLayout
+{
+	Uniform,    // Independent walls at a given density
+	Maze,       // Maze by recursive division, walls on odd rows and columns
+	Caves,      // Noise smoothed by a cellular automaton
+	Rooms,      // One room per sector, joined by L-shaped corridors
+};
+
+// Short names used by the command line tools and the GUI
+std::string GetMapLayoutName(MapLayout layout);
+
+// Parses a short name ("uniform", "maze", "caves", "rooms"), returns false if unknown
+bool ParseMapLayout(const std::string &name, MapLayout *layout);
+
+// Every layout, in the order of MapLayout
+const std::vector<MapLayout> &GetMapLayouts();
+
+// Parameters of GenerateMap
+struct GeneratorOptions
+{
+	MapLayout layout = MapLayout::Uniform;
+	std::uint64_t seed = 1;
+
+	// Probability of a wall in uniform maps
+	double density = 0.33;
+
+	// Probability of a wall before the caves are smoothed, and the number of smoothing passes
+	double caveDensity = 0.45;
+	int caveSteps = 4;
+
+	// Side of the square sectors that hold one room each
+	int roomSector = 16;
+
+	// Threads to spread the work over, 0 for one per core; small maps use one
+	int threads = 0;
+};
+
+/*
+ * Seeded map generators.
+ *
+ * Walls are drawn straight into a bitset, one word per 64 cells of a row, and
+ * copied into the grid in one go. Random numbers come from a counter-based
+ * generator: every value is a hash of the seed and its position, so threads
+ * can draw any part of the map in any order, the loops over words carry no
+ * generator state and vectorize, and a seed gives the same map for every
+ * thread count. Rows are split into bands over a thread pool; mazes and rooms
+ * hand out independent chambers and sectors instead.
+ *
+ * Replaces every wall of the grid. Start and goal stay open, and corridors
+ * lead to them in rooms layouts; costs are left untouched.
+ */
+void GenerateMap(Grid *grid, const GeneratorOptions &options);
+
+// Random word at a position of a seeded stream, the splitmix64 output function applied to the counter
+inline std::uint64_t GetRandomWord(const std::uint64_t seed, const std::uint64_t counter)
+{
+	auto value = seed + (counter + 1) * 0x9e3779b97f4a7c15ULL;
+	value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	value = (value ^ (value >> 27)) * 0x94d049bb133111ebULL;
+	return value ^ (value >> 31);
+}
+
+// 64 random walls at a density of level / 256. Combines eight random words, one per bit of the
+// level from the least significant up, each either widening or narrowing the set
+inline GridWord GetRandomWallWord(const std::uint64_t seed, const std::uint64_t counter, const unsigned level)
+{
+	if (level >= 256)
+		return ~GridWord(0);
+
+	GridWord word = 0;
+	for (auto bit = 0; bit < 8; bit++)
+	{
+		const auto random = GetRandomWord(seed, counter * 8 + bit);
+		word = (level >> bit) & 1 ? word | random : word & random;
+	}
+	return word;
+}
+
+// Density in 1/256 steps as taken by GetRandomWallWord
+inline unsigned GetWallLevel(const double density)
+{
+	const auto clamped = density < 0 ? 0.0 : density > 1 ? 1.0 : density;
+	return static_cast<unsigned>(clamped * 256.0 + 0.5);
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "SearchEngine.h"
+#include "ThreadPool.h"
+
+// Sources sharing one pass of a multi-source search, one bit lane each
+#define SOURCES_PER_PASS 64
+
+// BFS distances from several sources to every cell of a grid
+class DistanceFields
+{
+public:
+	DistanceFields() = default;
+
+	// Creates fields of NO_DISTANCE for the given number of sources over cell ids [0, capacity)
+	DistanceFields(int sources, int capacity);
+
+	int GetSourceCount() const;
+	int GetCapacity() const;
+
+	// Gets/sets the distance from a source, by index, to a cell, NO_DISTANCE if unreachable
+	int GetDistance(int source, int id) const;
+	void SetDistance(int source, int id, int distance);
+
+	// Distances from every source to every target, row-major sources x targets
+	std::vector<int> GetMatrix(const std::vector<int> &targets) const;
+private:
+	int m_sources = 0;
+	int m_capacity = 0;
+
+	// Index of a distance: sources are grouped per pass and the group's distances to
+	// one cell are adjacent, so a pass writes the lanes reaching a cell to one place
+	std::size_t GetIndex(int source, int id) const;
+
+	std::vector<int> m_distances;
+};
+
+/*
+ * Multi-source BFS (MS-BFS) over a batch of source cells.
+ *
+ * Up to SOURCES_PER_PASS searches run in one pass with one bit lane each:
+ * every cell holds a word of the sources that have seen it and a word of the
+ * sources whose frontier it is in. Expanding a cell pushes all of its lanes to
+ * a neighbor with a single AND-NOT, so sources that reach the same cells at
+ * the same level share the neighbor checks. Batches of sources run on a pool
+ * of worker threads, each with its own lane arrays.
+ *
+ * The grid is only read, its search state is left untouched. Holds
+ * sources x capacity distances, so very many sources on a large grid take a
+ * lot of memory.
+ */
+class MultiSourceSearch
+{
+public:
+	explicit MultiSourceSearch(Connectivity connectivity = Connectivity::Four);
+
+	// Sets the number of threads to run batches on, 0 picks one per core
+	void SetThreadCount(int threads);
+
+	// Runs BFS from every source, walls and NO_CELL sources reach nothing
+	DistanceFields Run(const Grid *grid, const std::vector<int> &sources);
+
+	// Counters of the last run, expansions count cells once per pass, not per source
+	const SearchStats &GetStats() const;
+private:
+	// Lane words and frontiers of one worker
+	struct LaneState
+	{
+		std::vector<GridWord> seen;
+		std::vector<GridWord> visit;
+		std::vector<GridWord> visitNext;
+		// Bitmaps of the cells with lanes in visit and in visitNext
+		std::vector<GridWord> frontier;
+		std::vector<GridWord> next;
+		SearchStats stats;
+	};
+
+	// Runs one pass for sources [first, first + count)
+	template <typename Conn>
+	void RunBatch(const Grid *grid, const std::vector<int> &sources, int first, int count, LaneState *state, DistanceFields *fields) const;
+
+	// Movement allowed between cells
+	Connectivity m_connectivity;
+
+	// Configured thread count, 0 for one per core
+	int m_threadCount = 0;
+
+	std::unique_ptr<ThreadPool> m_pool;
+	std::vector<LaneState> m_states;
+
+	SearchStats m_stats;
+};
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "SearchEngine.h"
+#include "ThreadPool.h"
+
+/*
+ * Level-synchronous BFS spread over a pool of worker threads.
+ *
+ * Each level's frontier is cut into chunks. Workers start on an even share of
+ * the chunks and steal from other workers once their own share runs out, so
+ * levels with uneven shapes stay balanced. Cells are claimed with an atomic
+ * OR on the visited bitset and collected in per-thread next frontiers, so
+ * every cell gets exactly one parent from the previous level and path lengths
+ * are exact. One step expands one whole level.
+ */
+template <typename Conn>
+class ParallelSearch final : public SearchEngine
+{
+public:
+	void SetThreadCount(int threads) override;
+	void Start(Grid *grid) override;
+	bool Step() override;
+	std::size_t GetAllocatedBytes() const override;
+private:
+	// Expands frontier cells [begin, end) into the worker's next frontier, returns the neighbor checks
+	std::uint64_t ExpandRange(int worker, std::size_t begin, std::size_t end, int distance);
+
+	// Claims the next chunk for a worker, stealing if its own share is done, returns false if none is left
+	bool ClaimChunk(int worker, std::size_t *chunk);
+
+	// Share of the frontier's chunks, padded so workers don't share cache lines
+	struct alignas(64) ChunkRange
+	{
+		std::atomic<std::size_t> next;
+		std::size_t end;
+	};
+
+	// Requested threads, 0 picks one per core
+	int m_threadCount = 0;
+
+	std::unique_ptr<ThreadPool> m_pool;
+	std::unique_ptr<ChunkRange[]> m_ranges;
+
+	// Cells of the current level and each worker's part of the next one
+	std::vector<int> m_frontier;
+	std::vector<std::vector<int>> m_local;
+
+	// Distance of the current frontier from the start
+	int m_distance = 0;
+
+	std::atomic<bool> m_goalFound { false };
+};
@@ -2,53 +2,151 @@
 
 #include <QTimer>
 #include <QElapsedTimer>
-#include <QQueue>
-#include <QStack>
 
-#include "Vertex.h"
+#include <memory>
+#include <string>
+#include <vector>
 
-// Tick-rate at which the algorithm runs
+#include "ComponentIndex.h"
+#include "Grid.h"
+#include "GridStore.h"
+#include "IncrementalSearch.h"
+#include "SearchEngine.h"
+#include "SearchReport.h"
+#include "SearchWorker.h"
+
+// Milliseconds between the steps of the algorithm, and between polls of its progress
 #define TICK_RATE 1
 
+/*
+ * Runs the search engines for the GUI.
+ *
+ * A search runs on a SearchWorker thread, one step per TICK_RATE so it can be
+ * watched. The GUI thread polls the worker's lock-free queues on a timer and
+ * turns the expanded cells and the final result into signals, so a long step
+ * on a big map never blocks the window.
+ *
+ * Every search publishes the grid to a GridStore and runs on a private
+ * replica of that version, so the grid may be edited while a search is in
+ * flight; the edits reach the next search, or the next repair of a finished
+ * incremental one. The replica's search state belongs to the worker until the
+ * search has finished or was interrupted.
+ */
 class PathFinder : public QObject
 {
 	Q_OBJECT
 public:
-	explicit PathFinder(QHash<int, Vertex*> *listOfIds, int rows, int cols, QObject *parent = nullptr);
+	explicit PathFinder(Grid *grid, QObject *parent = nullptr);
+
+	// Sets the grid to run traversals on and the allowed movement
+	void Setup(Grid *grid, Connectivity connectivity);
 
-	// Sets the needed values for solving traversals
-	void Setup(VertexHashIDList *listOfIds, int rows, int cols);
+	// Sets the index used to answer unreachable goals without searching, nullptr for none
+	void SetComponentIndex(ComponentIndex *components);
 
-	// Starts the BFS algorithm on the list of vertices
+	// Starts the BFS algorithm on the grid
 	void StartBreadthFirstSearch();
 
-	// Starts the DFS algorithm on the list of vertices
+	// Starts the DFS algorithm on the grid
 	void StartDepthFirstSearch();
 
+	// Starts Dijkstra's algorithm, which follows the terrain costs
+	void StartDijkstraSearch();
+
+	// Starts the A* algorithm with the open-grid distance as heuristic
+	void StartAStarSearch();
+
+	// Starts the Jump Point Search algorithm, A* on hexagonal grids
+	void StartJumpPointSearch();
+
+	// Starts the direction-optimizing BFS algorithm on the grid
+	void StartDirectionOptimizingSearch();
+
+	// Starts the multi-threaded BFS algorithm on the grid
+	void StartParallelSearch();
+
+	// Starts the BFS algorithm from both the start and the goal
+	void StartBidirectionalSearch();
+
+	// Starts the bit-parallel BFS, which expands whole levels as bitmaps
+	void StartWavefrontSearch();
+
+	// Starts the incremental A* algorithm, which can repair its path after wall edits
+	void StartIncrementalSearch();
+
+	// Starts hierarchical A*, which plans over precomputed cluster entrances and refines the route
+	void StartHierarchicalSearch();
+
+	// Engine of the current or last search, nullptr before the first one
+	const SearchEngine *GetEngine() const;
+
+	// Checks if the last search finished with an engine that can repair its path
+	bool CanReplan() const;
+
+	// Repairs the path of the last search after cells changed, the new path is passed to DisplayGoal
+	void Replan();
+
+	// Cells from the start to the goal through the given cell, on the version the last search ran on
+	std::vector<int> GetPath(int last) const;
+
+	// Forgets the last search, its engine state no longer matches the grid; a hierarchical
+	// engine is kept for the next one, which brings its abstract graph up to date
+	void Release();
+
 	// Gets the time elapsed during search
 	quint64 GetElapsedTime() const;
 
-	// Stops the algorithm, triggered from the UI
+	// Statistics of the current or last search, the counters follow every step; phase times leave out
+	// the waits between ticks
+	const SearchRecord &GetRecord() const;
+
+	// Stops the algorithm after its current step, triggered from the UI; the result is reported before returning
 	void TriggerInterrupt();
 protected:
-	// Gets the adjacent vertexs which have not been visited
-	QList<Vertex*> *GetNeighbors(int id) const;
+	// Starts stepping the engine with the given short name on every tick
+	void StartSearch(const std::string &name);
 
 	// Stops a algorithm
-	void Stop(Vertex *vertex);
+	void Stop(int goal);
+
+	// Takes the counters and phase times the worker reported, returns true with the result once it finished
+	bool DrainProgress(int *result);
+
+	// Emits the cells the worker expanded since the last poll
+	void EmitVisitedCells();
+
+	// Publishes the grid as a new version and brings the replica up to it, the worker must be idle;
+	// adds the ids whose wall or cost changed to the list if given
+	void LoadVersion(std::vector<int> *changed = nullptr);
 private:
-	// Used to get vertices by ID
-	VertexHashIDList *m_hash;
+	// Grid model the engines run on
+	Grid *m_grid;
+
+	// Movement allowed between cells
+	Connectivity m_connectivity;
 
-	// Queue for BFS
-	QQueue<Vertex*> *m_queue;
+	// Connected regions of the grid, may be nullptr
+	ComponentIndex *m_components;
 
-	// Stack for DFS
-	QStack<Vertex*> *m_stack;
+	// Published versions of the grid and the copy searches run on, declared before the engine observing it
+	GridStore m_store;
+	GridReplica m_replica;
 
-	// Timers that triggers a step DFS, BFS algorithm
-	QTimer *m_dfsTick;
-	QTimer *m_bfsTick;
+	// Engine performing the current traversal
+	std::unique_ptr<SearchEngine> m_engine;
+
+	// Engine of a released search whose cancelled step may still run, or a hierarchical engine kept for the
+	// next search; taken back or freed once the worker is joined
+	std::unique_ptr<SearchEngine> m_retired;
+
+	// Thread stepping the engine, declared after it so it's joined first
+	SearchWorker m_worker;
+
+	// Cells expanded by a repair of the path
+	std::vector<int> m_trace;
+
+	// Timer that polls the progress of the worker
+	QTimer *m_tick;
 
 	// Measures elapsed time when performing an algorithm
 	QElapsedTimer *m_timer;
@@ -56,17 +154,15 @@ private:
 	// Time elapsed during an algorithm
 	quint64 m_timeElapsed;
 
-	// N-rows and N-columns to use in the algorithm
-	int m_rows;
-	int m_cols;
-
-	// Flag to interrupt performing an algorithm
-	bool m_interrupted;
+	// Statistics of the current or last search
+	SearchRecord m_record;
 private slots:
-	// These functions perform one step in the BFS, DFS search algorithms
-	void RouteBFS();
-	void RouteDFS();
+	// Passes on the cells and counters the worker reported since the last poll
+	void Route();
 signals:
-	// Display the path/goal
-	void DisplayGoal(Vertex *goal);
-};
\ No newline at end of file
+	// A cell has been expanded by the search
+	void CellVisited(int id);
+
+	// Display the path/goal, NO_CELL if the goal hasn't been found; bidirectional searches pass the meeting cell
+	void DisplayGoal(int goal);
+};
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+/*
+ * Monotone priority queue for integer keys.
+ *
+ * Keys pushed must not be smaller than the last key popped, which holds for
+ * Dijkstra with non-negative weights. Entries sit in 65 buckets by the highest
+ * bit in which their key differs from the last popped key, so each entry is
+ * moved at most 64 times in total and no comparisons between entries are
+ * needed, which beats a binary heap for the small integer weights of terrain.
+ * Keys are 64-bit: a path of 2^31 cells at the costliest move stays below 2^44.
+ */
+class RadixHeap
+{
+public:
+	using Key = std::uint64_t;
+	using Entry = std::pair<Key, int>;
+
+	RadixHeap();
+
+	void Clear();
+	bool IsEmpty() const;
+	std::size_t GetSize() const;
+
+	// Adds a value, key must be at least the last popped key
+	void Push(Key key, int value);
+
+	// Removes an entry with the smallest key
+	Entry Pop();
+
+	// Bytes of the bucket buffers
+	std::size_t GetAllocatedBytes() const;
+private:
+	// Bucket of a key relative to the last popped key
+	static int BucketOf(Key key, Key last);
+
+	std::vector<Entry> m_buckets[65];
+	Key m_last;
+	std::size_t m_size;
+};
+
+inline bool RadixHeap::IsEmpty() const
+{
+	return this->m_size == 0;
+}
+
+inline std::size_t RadixHeap::GetSize() const
+{
+	return this->m_size;
+}
+
+inline int RadixHeap::BucketOf(const Key key, const Key last)
+{
+	if (key == last)
+		return 0;
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanReverse64(&index, key ^ last);
+	return static_cast<int>(index) + 1;
+#else
+	return 64 - __builtin_clzll(key ^ last);
+#endif
+}
+
+inline void RadixHeap::Push(const Key key, const int value)
+{
+	this->m_buckets[BucketOf(key, this->m_last)].emplace_back(key, value);
+	this->m_size++;
+}
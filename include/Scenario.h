@@ -0,0 +1,41 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "Connectivity.h"
+#include "Grid.h"
+
+/*
+ * MovingAI scenario (.scen) files: batches of start/goal queries on one map,
+ * grouped into buckets by difficulty, each with the length of an optimal
+ * 8-connected path without corner cutting. Straight moves count 1 and
+ * diagonal moves sqrt(2).
+ *
+ * The engines price diagonals at DIAGONAL_COST / STRAIGHT_COST = 1.4 instead,
+ * so a path they find optimal may be a little longer in octile length. Such a
+ * path still costs them no more than the scenario's optimal path does.
+ */
+
+// One start/goal query
+struct Scenario
+{
+	int bucket;
+	int startRow;
+	int startCol;
+	int goalRow;
+	int goalCol;
+	double optimalLength;
+};
+
+// Reads every query of a version 1 scenario file
+bool LoadScenarios(const std::string &path, std::vector<Scenario> *scenarios, std::string *error);
+
+// Length of a path measured the way scenario files do
+double GetOctileLength(const Grid &grid, const std::vector<int> &path);
+
+// Cost of a path the way the engines price it, the entered cell's terrain cost times STRAIGHT_COST or DIAGONAL_COST
+long long GetPathCost(const Grid &grid, const std::vector<int> &path);
+
+// Cost the engines give a path of the optimal length on uniform terrain, false if the length isn't made of whole moves
+bool GetOptimalCost(double optimalLength, long long *cost);
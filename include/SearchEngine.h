@@ -0,0 +1,138 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Connectivity.h"
+#include "Grid.h"
+
+// Counters collected by an engine during one search
+struct SearchStats
+{
+	// Number of cells expanded
+	std::uint64_t expansions = 0;
+
+	// Open neighbors looked at while expanding cells one at a time, word-parallel levels add none
+	std::uint64_t neighborChecks = 0;
+
+	// Cells pushed while an earlier entry of theirs was still waiting: repeated DFS pushes and the
+	// lazy decrease-keys of the heap based engines
+	std::uint64_t duplicatePushes = 0;
+
+	// Largest number of cells waiting in the queue/stack at once
+	std::size_t peakFrontier = 0;
+};
+
+// Bytes of a vector's buffer
+template <typename T>
+std::size_t GetBufferBytes(const std::vector<T> &buffer)
+{
+	return buffer.capacity() * sizeof(T);
+}
+
+/*
+ * Base class of the headless search engines.
+ *
+ * An engine searches a Grid from its start cell towards its goal cell and
+ * records its progress (visited flags, parents, distances) in the grid itself.
+ * It can be stepped one expansion at a time, which is what PathFinder uses to
+ * animate a traversal, or run to completion.
+ */
+class SearchEngine
+{
+public:
+	SearchEngine();
+	virtual ~SearchEngine() = default;
+
+	// Prepares a search on the grid, the grid's search state is reset
+	virtual void Start(Grid *grid);
+
+	// Performs one expansion, returns false once the search has finished
+	virtual bool Step() = 0;
+
+	// Runs the search to completion
+	virtual void Run();
+
+	// Checks if the search has finished
+	bool IsFinished() const;
+
+	// Gets the goal cell if it was reached, NO_CELL otherwise
+	int GetResult() const;
+
+	// Records the id of every expanded cell into the given list, nullptr disables recording
+	void SetTrace(std::vector<int> *trace);
+
+	// Sets the number of threads to search with, 0 picks one per core; single-threaded engines ignore it
+	virtual void SetThreadCount(int threads);
+
+	// Gets the counters of the current search
+	const SearchStats &GetStats() const;
+
+	// Bytes held for the current search, the engine's buffers and the grid's search state
+	virtual std::size_t GetAllocatedBytes() const;
+protected:
+	// Ends the search with the given result
+	void Finish(int result);
+
+	// Grid being searched
+	Grid *m_grid;
+
+	// Optional list of expanded cells
+	std::vector<int> *m_trace;
+
+	// Search status
+	bool m_finished;
+	int m_result;
+
+	// Counters of the current search
+	SearchStats m_stats;
+};
+
+// Breadth-First Search, returns a path with the fewest moves
+template <typename Conn>
+class BreadthFirstSearch final : public SearchEngine
+{
+public:
+	void Start(Grid *grid) override;
+	bool Step() override;
+	void Run() override;
+	std::size_t GetAllocatedBytes() const override;
+private:
+	// Expands one cell, shared by Step and Run so the kernel is inlined into the loop
+	bool Expand();
+
+	// FIFO queue, cells before m_head have already been expanded
+	std::vector<int> m_queue;
+	std::size_t m_head = 0;
+};
+
+// Depth-First Search, returns some path
+template <typename Conn>
+class DepthFirstSearch final : public SearchEngine
+{
+public:
+	void Start(Grid *grid) override;
+	bool Step() override;
+	void Run() override;
+	std::size_t GetAllocatedBytes() const override;
+private:
+	bool Expand();
+
+	// LIFO stack of cells to expand
+	std::vector<int> m_stack;
+};
+
+// Explicitly instantiates an engine template for every connectivity policy
+#define INSTANTIATE_ENGINE(Engine) \
+	template class Engine<FourConnected>; \
+	template class Engine<EightConnected<CornerCutting::Allow>>; \
+	template class Engine<EightConnected<CornerCutting::Forbid>>; \
+	template class Engine<HexConnected>;
+
+// Creates the engine with the given short name, nullptr if the name is unknown
+SearchEngine *CreateSearchEngine(const std::string &name, Connectivity connectivity = Connectivity::Four);
+
+// Short names of all available engines
+const std::vector<std::string> &GetSearchEngineNames();
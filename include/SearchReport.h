@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "SearchEngine.h"
+
+/*
+ * Statistics of one search run, for tracking engine efficiency across
+ * releases.
+ *
+ * A record holds the engine's counters, the bytes it held and the time spent
+ * in each phase: Start, the steps of the search alone and the reconstruction
+ * of the path. Records are appended to a log file, one JSON object per line,
+ * or one comma separated row under a header if the file name ends in ".csv".
+ */
+struct SearchRecord
+{
+	// Short engine name as taken by CreateSearchEngine, and the movement it ran with
+	std::string engine;
+	std::string connectivity;
+
+	int rows = 0;
+	int cols = 0;
+
+	// Whether the goal was reached, and the cells of the path including both ends
+	bool found = false;
+	std::size_t pathCells = 0;
+
+	// Counters of the engine and the bytes it held at the end of the search
+	SearchStats stats;
+	std::size_t allocatedBytes = 0;
+
+	// Nanoseconds spent in Start, in the steps and in the reconstruction of the path
+	std::uint64_t setupNs = 0;
+	std::uint64_t searchNs = 0;
+	std::uint64_t pathNs = 0;
+
+	// Seconds since the Unix epoch when the record was collected
+	std::int64_t timestamp = 0;
+
+	// Step time per expanded cell, 0 without expansions
+	double GetNsPerExpansion() const;
+};
+
+// Copies the counters and allocated bytes of an engine into a record and stamps it with the current time
+void CollectSearchRecord(const SearchEngine &engine, SearchRecord *record);
+
+// One JSON object on a single line, without the line break
+std::string FormatSearchRecordJson(const SearchRecord &record);
+
+// Column names and one row of comma separated values, without the line break
+std::string GetSearchRecordCsvHeader();
+std::string FormatSearchRecordCsv(const SearchRecord &record);
+
+// Appends a record to a log file, as CSV if the path ends in ".csv" (with a header if the file is new), as JSON lines otherwise
+bool AppendSearchRecord(const std::string &path, const SearchRecord &record, std::string *error);
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "SearchEngine.h"
+#include "SpscQueue.h"
+
+// Expanded cells the worker may be ahead of its owner
+#define WORKER_CELL_QUEUE 65536
+
+// Progress reports the worker may be ahead of its owner, later steps skip theirs while it's full
+#define WORKER_PROGRESS_QUEUE 256
+
+// Counters of a background search after a step, the last report of a search carries its result
+struct SearchProgress
+{
+	SearchStats stats;
+	std::size_t allocatedBytes = 0;
+
+	// Nanoseconds spent in Start, in the steps so far and in tracing the path
+	std::uint64_t setupNs = 0;
+	std::uint64_t searchNs = 0;
+	std::uint64_t pathNs = 0;
+
+	// Set in the last report, with the goal or meeting cell (NO_CELL if not found) and the cells of the path
+	bool finished = false;
+	int result = NO_CELL;
+	std::size_t pathCells = 0;
+};
+
+/*
+ * Runs a search engine on a thread of its own.
+ *
+ * The worker starts the engine and steps it, pausing for an interval between
+ * steps so a search can be watched. Every cell an engine expands goes into a
+ * queue of cells, and the counters after every step into a queue of progress
+ * reports; both are lock-free single-producer single-consumer queues the
+ * owner drains at its own pace. When the cell queue is full the worker waits
+ * for the owner, so no expanded cell is lost.
+ *
+ * Cancel sets an atomic token that the worker checks before every step and
+ * while it waits, and wakes it from its pause, so it returns as soon as the
+ * step in progress is done. Cancel itself doesn't wait for that, a long step
+ * such as an engine's Start doesn't block the owner. The engine and the grid
+ * belong to the worker from Start until IsRunning turns false.
+ */
+class SearchWorker
+{
+public:
+	SearchWorker();
+	~SearchWorker();
+
+	SearchWorker(const SearchWorker &) = delete;
+	SearchWorker &operator=(const SearchWorker &) = delete;
+
+	// Starts the engine on the grid in the background, stepping every interval; without search it only resets the grid
+	void Start(SearchEngine *engine, Grid *grid, bool search, std::chrono::microseconds interval);
+
+	// Asks the search to stop after the current step, returns without waiting for it
+	void Cancel();
+
+	// Joins the thread of a finished or cancelled search, waiting for its step if one is still running
+	void Wait();
+
+	// Checks if the thread may still use the engine or the grid
+	bool IsRunning() const;
+
+	// Owner side: takes the next expanded cell or progress report, false if there is none yet
+	bool PopCell(int *id);
+	bool PopProgress(SearchProgress *progress);
+private:
+	// Body of the worker thread
+	void Run(SearchEngine *engine, Grid *grid, bool search, std::chrono::microseconds interval);
+
+	// Hands the cells expanded by the last step to the owner, false if cancelled while waiting
+	bool PublishCells();
+
+	// Reports the engine's counters, waits for room if the report is the last
+	void PublishProgress(const SearchEngine &engine, SearchProgress *progress);
+
+	std::thread m_thread;
+
+	// Set to stop the search
+	std::atomic<bool> m_cancelled;
+
+	// Set by the thread once it no longer touches the engine or the grid
+	std::atomic<bool> m_returned;
+
+	// Wakes the worker from its pause between steps
+	std::mutex m_mutex;
+	std::condition_variable m_wake;
+
+	// Cells expanded by the current step, filled by the engine
+	std::vector<int> m_trace;
+
+	SpscQueue<int> m_cells;
+	SpscQueue<SearchProgress> m_progress;
+};
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+/*
+ * Bounded lock-free queue between one producer thread and one consumer thread.
+ *
+ * Slots form a ring of a power of two. The producer alone advances the tail
+ * and the consumer alone advances the head, each publishing its index with a
+ * release store that the other side reads with an acquire load, so a popped
+ * value is always fully written. Each side also keeps a cached copy of the
+ * other's index and reloads it only when the ring looks full or empty, and the
+ * two indices sit on separate cache lines.
+ */
+template <typename T>
+class SpscQueue
+{
+public:
+	// Creates a queue holding at least the given number of values
+	explicit SpscQueue(std::size_t capacity);
+
+	SpscQueue(const SpscQueue &) = delete;
+	SpscQueue &operator=(const SpscQueue &) = delete;
+
+	// Producer side: appends a value, returns false if the queue is full
+	bool TryPush(const T &value);
+
+	// Consumer side: takes the oldest value, returns false if the queue is empty
+	bool TryPop(T *value);
+
+	// Empties the queue, neither side may be using it
+	void Clear();
+
+	// Number of values the queue holds at most
+	std::size_t GetCapacity() const;
+private:
+	std::vector<T> m_slots;
+	std::size_t m_mask;
+
+	// Next slot to pop, and the consumer's copy of the tail
+	alignas(64) std::atomic<std::size_t> m_head;
+	std::size_t m_cachedTail;
+
+	// Next slot to push, and the producer's copy of the head
+	alignas(64) std::atomic<std::size_t> m_tail;
+	std::size_t m_cachedHead;
+};
+
+template <typename T>
+SpscQueue<T>::SpscQueue(const std::size_t capacity)
+	: m_head(0)
+	, m_cachedTail(0)
+	, m_tail(0)
+	, m_cachedHead(0)
+{
+	std::size_t size = 2;
+	while (size < capacity)
+		size <<= 1;
+	this->m_slots.resize(size);
+	this->m_mask = size - 1;
+}
+
+template <typename T>
+bool SpscQueue<T>::TryPush(const T &value)
+{
+	const auto tail = this->m_tail.load(std::memory_order_relaxed);
+	if (tail - this->m_cachedHead == this->m_slots.size())
+	{
+		this->m_cachedHead = this->m_head.load(std::memory_order_acquire);
+		if (tail - this->m_cachedHead == this->m_slots.size())
+			return false;
+	}
+
+	this->m_slots[tail & this->m_mask] = value;
+	this->m_tail.store(tail + 1, std::memory_order_release);
+	return true;
+}
+
+template <typename T>
+bool SpscQueue<T>::TryPop(T *value)
+{
+	const auto head = this->m_head.load(std::memory_order_relaxed);
+	if (head == this->m_cachedTail)
+	{
+		this->m_cachedTail = this->m_tail.load(std::memory_order_acquire);
+		if (head == this->m_cachedTail)
+			return false;
+	}
+
+	*value = this->m_slots[head & this->m_mask];
+	this->m_head.store(head + 1, std::memory_order_release);
+	return true;
+}
+
+template <typename T>
+void SpscQueue<T>::Clear()
+{
+	this->m_head.store(0, std::memory_order_relaxed);
+	this->m_tail.store(0, std::memory_order_relaxed);
+	this->m_cachedTail = 0;
+	this->m_cachedHead = 0;
+}
+
+template <typename T>
+std::size_t SpscQueue<T>::GetCapacity() const
+{
+	return this->m_slots.size();
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+ * Fixed set of worker threads running one job at a time.
+ *
+ * Run() hands the same job to every worker and returns once all of them are
+ * done, which is the shape of level-synchronous searches: many short parallel
+ * phases separated by barriers. Idle workers spin briefly before sleeping, so
+ * back-to-back phases don't pay for a wake-up each.
+ */
+class ThreadPool
+{
+public:
+	// Creates a pool of the given number of threads, the calling thread counts as one
+	explicit ThreadPool(int threads);
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool &) = delete;
+	ThreadPool &operator=(const ThreadPool &) = delete;
+
+	// Number of threads running a job, including the caller
+	int GetThreadCount() const;
+
+	// Runs job(worker) for every worker index, the caller runs worker 0
+	void Run(const std::function<void(int)> &job);
+
+	// Number of threads to use when none is configured
+	static int GetDefaultThreadCount();
+private:
+	// Waits for jobs and runs them
+	void WorkerLoop(int worker);
+
+	std::vector<std::thread> m_workers;
+
+	// Current job, replaced between generations only
+	const std::function<void(int)> *m_job;
+
+	// Incremented for every job, workers run each generation once
+	std::atomic<std::uint64_t> m_generation;
+
+	// Workers still running the current job
+	std::atomic<int> m_pending;
+
+	// Set when the pool shuts down
+	std::atomic<bool> m_stopping;
+
+	// Wakes sleeping workers
+	std::mutex m_mutex;
+	std::condition_variable m_wake;
+};
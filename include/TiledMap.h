@@ -0,0 +1,205 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#ifdef _WIN32
+#include <fstream>
+#endif
+
+#include "Grid.h"
+#include "SearchEngine.h"
+
+// Side of a square tile in cells, each tile row is one GridWord
+#define TILE_SIZE 64
+
+// Tiles are grouped in square blocks of 1 << TILE_BLOCK_SHIFT tiles per side
+#define TILE_BLOCK_SHIFT 4
+
+// Version written by TiledMap::Create
+#define TILED_MAP_FORMAT_VERSION 1
+
+// Tiles kept in memory unless SetCacheCapacity says otherwise, 32 MiB of walls
+#define DEFAULT_TILE_CACHE_CAPACITY 65536
+
+// Fixed 64 byte header of a tiled map file
+struct TiledMapHeader
+{
+	char magic[8];              // "GRIDTILE" without a terminating zero
+	std::uint32_t version;
+	std::uint32_t tileSize;     // TILE_SIZE of the writer
+	std::int32_t rows;
+	std::int32_t cols;
+	std::int32_t tileRows;
+	std::int32_t tileCols;
+	std::uint32_t blockShift;   // TILE_BLOCK_SHIFT of the writer
+	std::uint32_t reserved;
+	std::uint64_t tilesOffset;
+	std::uint64_t tileCount;
+	std::uint64_t padding;
+};
+
+static_assert(sizeof(TiledMapHeader) == 64, "tiled map header must stay 64 bytes");
+
+// Counters of the tile cache
+struct TileCacheStats
+{
+	// Tile lookups served from memory
+	std::uint64_t hits = 0;
+
+	// Tile lookups that paged the tile in from the file
+	std::uint64_t misses = 0;
+
+	// Tiles dropped to make room for others
+	std::uint64_t evictions = 0;
+};
+
+// Rectangle of a tiled map in cells
+struct TiledWindow
+{
+	int row = 0;
+	int col = 0;
+	int rows = 0;
+	int cols = 0;
+};
+
+/*
+ * Wall map stored out of core in square tiles.
+ *
+ * A tile holds TILE_SIZE x TILE_SIZE walls as one bit per cell, one word per
+ * tile row, so a tile is 512 bytes and moving north or south stays inside it.
+ * Tiles are grouped in square blocks that are laid out row by row, and within
+ * a block the tiles follow a Z-order (Morton) curve, so tiles that are near
+ * on the map are near in the file. Cells past the map's edge are stored as
+ * walls.
+ *
+ * The file is memory-mapped and only the tiles that are used are paged in.
+ * Tiles in use are copied to a cache of fixed capacity with clock eviction,
+ * which bounds the memory a search holds however large the map is and counts
+ * the tile-level hits and misses.
+ *
+ * The search engines don't know about tiles: LoadWindow copies a rectangle of
+ * the map into a regular Grid, and SearchTiledMap grows windows around the
+ * start and goal until the engine finds a path in one. Grid ids are ints, so
+ * a window, unlike the map, has to stay below 2^31 cells.
+ *
+ * Not safe to use from several threads at once.
+ */
+class TiledMap
+{
+public:
+	TiledMap();
+	~TiledMap();
+
+	TiledMap(const TiledMap &) = delete;
+	TiledMap &operator=(const TiledMap &) = delete;
+
+	// Creates a map file with every cell open and opens it for writing; unused tiles take no disk space
+	bool Create(const std::string &path, int rows, int cols, std::string *error);
+
+	// Opens an existing map file
+	bool Open(const std::string &path, bool writable, std::string *error);
+
+	// Writes pending changes back and releases the file
+	void Close();
+
+	// Dimensions of the map in cells and in tiles
+	int GetRows() const;
+	int GetCols() const;
+	int GetTileRows() const;
+	int GetTileCols() const;
+
+	// Position of a tile in the file
+	std::uint64_t GetTileIndex(int tileRow, int tileCol) const;
+
+	// Checks if a cell is a wall, cells outside the map are
+	bool IsWall(int row, int col);
+
+	// Sets or clears the wall of a cell inside a map opened for writing
+	void SetWall(int row, int col, bool wall);
+
+	// Copies the TILE_SIZE words of a tile in or out, bit c of word r is the cell at (r, c) of the tile;
+	// tiles outside the map read as walls and writes keep the cells past the edge walled
+	void ReadTile(int tileRow, int tileCol, GridWord *words);
+	void WriteTile(int tileRow, int tileCol, const GridWord *words);
+
+	// Resizes the grid to the window and copies its walls, start and goal are unset
+	void LoadWindow(const TiledWindow &window, Grid *grid);
+
+	// Number of tiles held in memory, the cached tiles are dropped
+	void SetCacheCapacity(std::size_t tiles);
+
+	// Gets/resets the counters of the tile cache
+	const TileCacheStats &GetCacheStats() const;
+	void ResetCacheStats();
+private:
+	// Tile row words through the cache, nullptr for tiles outside the map
+	GridWord *GetTile(int tileRow, int tileCol);
+
+	// Takes a free cache slot, or evicts the first tile the clock finds unused
+	std::size_t AllocateSlot();
+
+	// Drops every cached tile
+	void ClearCache();
+
+	// Points the file data at a freshly opened file
+	bool MapData(const std::string &path, bool writable, std::string *error);
+
+	// Copies a tile between the file and memory
+	void ReadTileData(std::uint64_t index, GridWord *words);
+	void WriteTileData(std::uint64_t index, const GridWord *words);
+
+	// Walls past the map's edge in the tile
+	GridWord GetEdgeMask(int tileCol) const;
+
+	TiledMapHeader m_header;
+	bool m_writable;
+
+	// Tile data of the file
+#ifdef _WIN32
+	std::fstream m_file;
+#else
+	char *m_data;
+	std::size_t m_size;
+#endif
+
+	// Cached tiles, TILE_SIZE words per slot
+	std::vector<GridWord> m_slots;
+	std::vector<std::uint64_t> m_slotTiles;
+	std::vector<std::uint8_t> m_referenced;
+	std::size_t m_capacity;
+	std::size_t m_clock;
+
+	// Slot of every cached tile, so the lookup is bounded by the capacity instead of the map
+	std::unordered_map<std::uint64_t, std::size_t> m_tileSlots;
+
+	// Wall words of the last window, kept for the next
+	std::vector<GridWord> m_windowWords;
+
+	TileCacheStats m_stats;
+};
+
+// Outcome of SearchTiledMap
+struct TiledSearchResult
+{
+	bool found = false;
+
+	// Cells from the start to the goal as { row, col } on the map
+	std::vector<std::pair<int, int>> path;
+
+	// Windows searched and the cells of the last one
+	int windows = 0;
+	std::uint64_t windowCells = 0;
+
+	// Counters summed over the windows
+	std::uint64_t expansions = 0;
+	std::size_t peakFrontier = 0;
+};
+
+// Searches windows around start and goal, doubling their margin until the engine finds a path,
+// the window covers the map or would exceed maxCells. The path is the engine's best within the window
+TiledSearchResult SearchTiledMap(TiledMap *map, SearchEngine *engine, Grid *grid,
+	int startRow, int startCol, int goalRow, int goalCol, std::uint64_t maxCells);
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <vector>
+
+#include "SearchEngine.h"
+
+// What a wavefront search computes
+enum class WavefrontMode
+{
+	Levels,         // BFS levels, from which the shortest path is recovered
+	Reachability,   // Only whether the goal is reachable, the result has no parent chain
+};
+
+// A shift of a bitset by some bits, split into whole words and the remaining bits
+struct BitShift
+{
+	int words;
+	int bits;
+};
+
+/*
+ * Bit-parallel BFS that expands a whole level as a flood fill.
+ *
+ * The frontier is a bitmap in the Grid's cell layout, so every neighbor of a
+ * cell is a constant bit offset away. The next level is the frontier shifted
+ * by each neighbor offset, OR-ed together and masked with the open, unvisited
+ * cells: 64 cells per word operation instead of one queue pop per cell. A
+ * second, coarser bitmap with one bit per word tracks the non-empty frontier
+ * words and is spread the same way, so only words next to the wavefront are
+ * computed and a thin wavefront costs a few words per row, not the grid.
+ *
+ * Parents are not recorded while expanding, the Grid's distance array serves
+ * as the level index. Once the goal is reached the path is walked back through
+ * neighbors one level closer to the start, so the grid holds a parent chain
+ * for the path cells only. One step expands one whole level.
+ *
+ * A single-source wavefront runs diagonally through the row-major bitmap and
+ * leaves about one cell per word, so levels run no faster than the scalar BFS.
+ * In the reachability mode there are no levels to keep: Start floods the
+ * start's region with alternating forward and backward sweeps over all words,
+ * each taking moves from the words it already updated and filling runs of
+ * open cells within a word, until a sweep reaches the goal or a pair of sweeps
+ * changes nothing. Every
+ * sweep spreads the region through any number of cells in its direction, so
+ * open maps take a few sweeps. The region is left in the visited flags, and
+ * the goal, if reached, is the result without a path.
+ */
+template <typename Conn>
+class WavefrontSearch final : public SearchEngine
+{
+public:
+	explicit WavefrontSearch(WavefrontMode mode = WavefrontMode::Levels);
+
+	void Start(Grid *grid) override;
+	bool Step() override;
+	std::size_t GetAllocatedBytes() const override;
+private:
+	// Links the path from the goal back to the start through decreasing distances
+	void FillPath(int goal);
+
+	// Floods the start's region into the frontier bitmap until it holds the goal, returns its number of cells
+	std::size_t Flood();
+
+	WavefrontMode m_mode;
+
+	// Bitmaps of the current and the next level and a copy of the walls,
+	// all with m_padding guard words on either side so shifts need no checks
+	std::vector<GridWord> m_frontier;
+	std::vector<GridWord> m_next;
+	std::vector<GridWord> m_walls;
+	int m_padding = 0;
+
+	// Shift of every neighbor offset of the connectivity policy
+	BitShift m_shifts[Conn::Count];
+
+	// One bit per word of the frontier and of the next level that has cells,
+	// with guard words like the bitmaps above
+	std::vector<GridWord> m_active;
+	std::vector<GridWord> m_nextActive;
+	int m_activePadding = 0;
+
+	// Word offsets a frontier word can spread to, as shifts of the active bitmap
+	std::vector<BitShift> m_wordShifts;
+
+	// Words of the active bitmap that may contain set bits
+	int m_activeBegin = 0;
+	int m_activeEnd = 0;
+
+	// Cells of the current frontier and their distance from the start
+	std::size_t m_frontierSize = 0;
+	int m_distance = 0;
+};
@@ -0,0 +1,127 @@
+#include "AStarSearch.h"
+
+#include <climits>
+
+template <typename Conn>
+void AStarSearch<Conn>::Start(Grid *grid)
+{
+	SearchEngine::Start(grid);
+	this->m_open.Clear();
+	this->m_cost.assign(grid->GetCapacity(), INT_MAX);
+
+	const auto start = grid->GetStart();
+	const auto goal = grid->GetGoal();
+	this->m_goalRow = grid->GetRow(goal);
+	this->m_goalCol = grid->GetCol(goal);
+
+	// Starting point
+	this->m_cost[start] = 0;
+	grid->SetDistance(start, 0);
+	this->m_open.Push({ Heuristic(start), 0, start });
+}
+
+template <typename Conn>
+bool AStarSearch<Conn>::Step()
+{
+	return Expand();
+}
+
+template <typename Conn>
+void AStarSearch<Conn>::Run()
+{
+	while (Expand())
+	{
+	}
+}
+
+template <typename Conn>
+std::size_t AStarSearch<Conn>::GetAllocatedBytes() const
+{
+	return SearchEngine::GetAllocatedBytes() + this->m_open.GetAllocatedBytes() + GetBufferBytes(this->m_cost);
+}
+
+template <typename Conn>
+int AStarSearch<Conn>::Heuristic(const int id) const
+{
+	return Conn::Cost(this->m_goalRow - this->m_grid->GetRow(id), this->m_goalCol - this->m_grid->GetCol(id));
+}
+
+template <typename Conn>
+inline bool AStarSearch<Conn>::Expand()
+{
+	if (this->m_finished)
+		return false;
+
+	/*
+	 * A* algorithm
+	 *
+	 * Pop the open cell with the lowest f = g + h, skipping stale entries.
+	 * The goal is only accepted when popped, which keeps the path optimal.
+	 * Relax the neighbors and push the ones whose cost improved.
+	 */
+
+	const auto grid = this->m_grid;
+	auto current = NO_CELL;
+	auto cost = 0;
+	while (!this->m_open.IsEmpty())
+	{
+		const auto entry = this->m_open.Pop();
+		if (!grid->WasVisited(entry.id) && entry.g == this->m_cost[entry.id])
+		{
+			current = entry.id;
+			cost = entry.g;
+			break;
+		}
+	}
+
+	if (current == NO_CELL)
+	{
+		Finish(NO_CELL); // Goal NOT found
+		return false;
+	}
+
+	grid->SetVisited(current, true);
+	this->m_stats.expansions++;
+	if (this->m_trace != nullptr)
+		this->m_trace->push_back(current);
+
+	if (current == grid->GetGoal())
+	{
+		Finish(current); // Goal found
+		return false;
+	}
+
+	const auto distance = grid->GetDistance(current) + 1;
+
+	auto checks = 0;
+	auto duplicates = 0;
+	Conn::ForEach(grid, current, [&](const int next, const bool diagonal)
+	{
+		checks++;
+		if (grid->WasVisited(next))
+			return true;
+
+		const auto nextCost = cost + (diagonal ? DIAGONAL_COST : STRAIGHT_COST);
+		if (nextCost < this->m_cost[next])
+		{
+			// An open cell leaves its stale entry in the heap
+			if (this->m_cost[next] != INT_MAX)
+				duplicates++;
+
+			this->m_cost[next] = nextCost;
+			grid->SetPrevious(next, current);
+			grid->SetDistance(next, distance);
+			this->m_open.Push({ nextCost + Heuristic(next), nextCost, next });
+		}
+		return true;
+	});
+
+	this->m_stats.neighborChecks += checks;
+	this->m_stats.duplicatePushes += duplicates;
+	if (this->m_open.GetSize() > this->m_stats.peakFrontier)
+		this->m_stats.peakFrontier = this->m_open.GetSize();
+
+	return true;
+}
+
+INSTANTIATE_ENGINE(AStarSearch)
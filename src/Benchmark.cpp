@@ -0,0 +1,709 @@
+/*
+ * Headless benchmark for the search engines.
+ *
+ * Generates grids with random walls and runs every engine to completion,
+ * without the QTimer animation of the GUI.
+ *
+ * Usage: BFS-DFS-Benchmark [--size RxC]... [--map FILE] [--layout L] [--density D] [--seed S] [--engine NAME]... [--connectivity C] [--threads N] [--max-cost N] [--sources N] [--edits N] [--components] [--flow-field]
+ *                          [--tiled FILE [--queries N] [--span N] [--window-cells N] [--tile-cache N]] [--csv] [--stats FILE]
+ */
+
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "ComponentIndex.h"
+#include "FlowField.h"
+#include "Grid.h"
+#include "IncrementalSearch.h"
+#include "MapFile.h"
+#include "MapGenerator.h"
+#include "MultiSourceSearch.h"
+#include "SearchEngine.h"
+#include "SearchReport.h"
+#include "TiledMap.h"
+
+namespace
+{
+	// { rows, cols }
+	using BenchSize = std::pair<int, int>;
+
+	// Sizes of the GUI's size selection (750x600 scene) followed by larger headless maps
+	const std::vector<BenchSize> DefaultSizes = {
+		{4, 5},
+		{8, 10},
+		{20, 25},
+		{40, 50},
+		{60, 75},
+		{120, 150},
+		{1000, 1000},
+		{4000, 4000},
+	};
+
+	// Wall edits a flow field refresh takes at once
+	const int FlowEditBatch = 16;
+
+	// Largest side accepted on the command line, tiled maps live on disk and may be larger
+	const int MaxSide = 10000;
+	const int MaxTiledSide = 1000000;
+
+	// Size of a tiled map created without --size
+	const BenchSize DefaultTiledSize = { 20000, 20000 };
+
+	struct BenchOptions
+	{
+		std::vector<BenchSize> sizes;
+		std::vector<std::string> engines;
+		std::string map;
+		MapLayout layout = MapLayout::Uniform;
+		double density = 0.33;
+		unsigned seed = 1;
+		Connectivity connectivity = Connectivity::Four;
+		int threads = 0;
+		int maxCost = DEFAULT_COST;
+		int sources = 0;
+		int edits = 0;
+		bool components = false;
+		bool flowField = false;
+		std::string tiled;
+		int queries = 10;
+		int span = 1000;
+		std::uint64_t windowCells = 1ULL << 24;
+		std::size_t tileCache = DEFAULT_TILE_CACHE_CAPACITY;
+		bool csv = false;
+		std::string stats;
+	};
+
+	void PrintUsage(const char *program)
+	{
+		std::fprintf(stderr,
+			"Usage: %s [--size RxC]... [--map FILE] [--layout L] [--density D] [--seed S] [--engine NAME]... [--connectivity C] [--threads N] [--max-cost N] [--sources N] [--edits N] [--components] [--flow-field]\n"
+			"          [--tiled FILE [--queries N] [--span N] [--window-cells N] [--tile-cache N]] [--csv] [--stats FILE]\n"
+			"  --size RxC          grid of R rows and C columns, at most %dx%d (repeatable)\n"
+			"  --map FILE          run on a binary or MovingAI map instead of random grids\n"
+			"  --layout L          generated map: uniform, maze, caves or rooms, default uniform\n"
+			"  --density D         probability of a cell being a wall in uniform maps, default 0.33\n"
+			"  --seed S            seed of the map generator, default 1\n"
+			"  --engine NAME       engine to run (repeatable), default all\n"
+			"  --connectivity C    4, 8, 8nc (no corner cutting) or hex, default 4\n"
+			"  --threads N         threads of parallel engines and of the map generator, default one per core\n"
+			"  --max-cost N        random terrain costs from 1 to N (at most 255), default 1\n"
+			"  --sources N         also run multi-source BFS (msbfs) from N random open cells,\n"
+			"                      found holds the number of sources, expansions count cells once per pass\n"
+			"  --edits N           toggle N random walls after each incremental search and replan,\n"
+			"                      reported as NAME-replan with the totals of all replans\n"
+			"  --components        also build the connected component index (cc), found tells if start and goal\n"
+			"                      are connected, path holds the number of components, expansions the open cells\n"
+			"                      and peak_frontier the largest component\n"
+			"  --flow-field        also build the flow field to the goal (flow), found tells if the start reaches\n"
+			"                      it and path holds the steps from the start; with --edits, flow-refresh toggles\n"
+			"                      the walls %d at a time, found holds the full builds and path the cells\n"
+			"                      whose cost differs from a full build after a refresh, which fails the run\n"
+			"  --tiled FILE        run random queries on a tiled map file (TiledMap), which is created from the\n"
+			"                      first --size (at most %dx%d) and --density if it doesn't exist\n"
+			"  --queries N         queries on the tiled map, default 10\n"
+			"  --span N            largest row and column distance of a query's start and goal, default 1000\n"
+			"  --window-cells N    largest window a tiled query may load into a grid, default 16777216\n"
+			"  --tile-cache N      tiles kept in memory, default %d\n"
+			"  --csv               print comma separated values\n"
+			"  --stats FILE        append the statistics of every engine run to FILE, CSV for a .csv name and\n"
+			"                      JSON lines otherwise\n",
+			program, MaxSide, MaxSide, FlowEditBatch, MaxTiledSide, MaxTiledSide, DEFAULT_TILE_CACHE_CAPACITY);
+	}
+
+	bool ParseOptions(const int argc, char *argv[], BenchOptions *options)
+	{
+		for (auto i = 1; i < argc; i++)
+		{
+			const std::string arg = argv[i];
+			const auto hasValue = i + 1 < argc;
+
+			if (arg == "--size" && hasValue)
+			{
+				BenchSize size;
+				if (std::sscanf(argv[++i], "%dx%d", &size.first, &size.second) != 2
+					|| size.first < 1 || size.second < 1 || size.first > MaxTiledSide || size.second > MaxTiledSide)
+					return false;
+				options->sizes.push_back(size);
+			}
+			else if (arg == "--map" && hasValue)
+			{
+				options->map = argv[++i];
+			}
+			else if (arg == "--layout" && hasValue)
+			{
+				if (!ParseMapLayout(argv[++i], &options->layout))
+					return false;
+			}
+			else if (arg == "--density" && hasValue)
+			{
+				options->density = std::atof(argv[++i]);
+			}
+			else if (arg == "--seed" && hasValue)
+			{
+				options->seed = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+			}
+			else if (arg == "--engine" && hasValue)
+			{
+				options->engines.push_back(argv[++i]);
+			}
+			else if (arg == "--connectivity" && hasValue)
+			{
+				if (!ParseConnectivity(argv[++i], &options->connectivity))
+					return false;
+			}
+			else if (arg == "--threads" && hasValue)
+			{
+				options->threads = std::atoi(argv[++i]);
+			}
+			else if (arg == "--max-cost" && hasValue)
+			{
+				options->maxCost = std::atoi(argv[++i]);
+				if (options->maxCost < 1 || options->maxCost > 255)
+					return false;
+			}
+			else if (arg == "--sources" && hasValue)
+			{
+				options->sources = std::atoi(argv[++i]);
+				if (options->sources < 0)
+					return false;
+			}
+			else if (arg == "--edits" && hasValue)
+			{
+				options->edits = std::atoi(argv[++i]);
+				if (options->edits < 0)
+					return false;
+			}
+			else if (arg == "--components")
+			{
+				options->components = true;
+			}
+			else if (arg == "--flow-field")
+			{
+				options->flowField = true;
+			}
+			else if (arg == "--tiled" && hasValue)
+			{
+				options->tiled = argv[++i];
+			}
+			else if (arg == "--queries" && hasValue)
+			{
+				options->queries = std::atoi(argv[++i]);
+				if (options->queries < 1)
+					return false;
+			}
+			else if (arg == "--span" && hasValue)
+			{
+				options->span = std::atoi(argv[++i]);
+				if (options->span < 1)
+					return false;
+			}
+			else if (arg == "--window-cells" && hasValue)
+			{
+				options->windowCells = std::strtoull(argv[++i], nullptr, 10);
+			}
+			else if (arg == "--tile-cache" && hasValue)
+			{
+				options->tileCache = static_cast<std::size_t>(std::strtoull(argv[++i], nullptr, 10));
+			}
+			else if (arg == "--csv")
+			{
+				options->csv = true;
+			}
+			else if (arg == "--stats" && hasValue)
+			{
+				options->stats = argv[++i];
+			}
+			else
+			{
+				return false;
+			}
+		}
+
+		// Sides past MaxSide only fit in memory as tiles
+		for (const auto &size : options->sizes)
+		{
+			if (options->tiled.empty() && (size.first > MaxSide || size.second > MaxSide))
+				return false;
+		}
+
+		if (options->sizes.empty() && options->tiled.empty())
+			options->sizes = DefaultSizes;
+		if (options->engines.empty())
+			options->engines = GetSearchEngineNames();
+		return true;
+	}
+
+	// Assigns random terrain costs, a maximum of 1 keeps the grid uniform
+	void GenerateCosts(Grid *grid, const int maxCost, const unsigned seed)
+	{
+		grid->ClearCosts();
+		if (maxCost <= DEFAULT_COST)
+			return;
+
+		std::mt19937_64 random(seed ^ 0x9e3779b97f4a7c15ULL);
+		std::uniform_int_distribution<int> cost(DEFAULT_COST, maxCost);
+		for (auto row = 0; row < grid->GetRows(); row++)
+		{
+			for (auto col = 0; col < grid->GetCols(); col++)
+				grid->SetCost(grid->GetId(row, col), static_cast<CellCost>(cost(random)));
+		}
+	}
+
+	// Picks random open cells, at most count, fewer if the grid is mostly walls
+	std::vector<int> PickSources(const Grid &grid, const int count, const unsigned seed)
+	{
+		std::mt19937_64 random(seed);
+		std::uniform_int_distribution<int> row(0, grid.GetRows() - 1);
+		std::uniform_int_distribution<int> col(0, grid.GetCols() - 1);
+
+		std::vector<int> sources;
+		for (auto attempt = 0; attempt < count * 16 && static_cast<int>(sources.size()) < count; attempt++)
+		{
+			const auto id = grid.GetId(row(random), col(random));
+			if (!grid.IsWall(id))
+				sources.push_back(id);
+		}
+		return sources;
+	}
+
+	std::uint64_t GetNanoseconds(const std::chrono::steady_clock::duration duration)
+	{
+		return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count());
+	}
+
+	// Peak resident set size of the process in MiB
+	double PeakRssMiB()
+	{
+		rusage usage {};
+		getrusage(RUSAGE_SELF, &usage);
+		return usage.ru_maxrss / 1024.0;
+	}
+
+	// Places random walls on a tiled map one tile at a time, a word of 64 cells at once
+	void GenerateTiledWalls(TiledMap *map, const double density, const unsigned seed)
+	{
+		const auto level = GetWallLevel(density);
+		std::vector<GridWord> words(TILE_SIZE);
+
+		for (auto tileRow = 0; tileRow < map->GetTileRows(); tileRow++)
+		{
+			for (auto tileCol = 0; tileCol < map->GetTileCols(); tileCol++)
+			{
+				// Counters follow the file order of the tiles
+				const auto first = map->GetTileIndex(tileRow, tileCol) * TILE_SIZE;
+				for (auto row = 0; row < TILE_SIZE; row++)
+					words[row] = GetRandomWallWord(seed, first + row, level);
+				map->WriteTile(tileRow, tileCol, words.data());
+			}
+		}
+	}
+
+	// Picks an open cell at most span rows and columns away from an open start
+	bool PickTiledQuery(TiledMap *map, const int span, std::mt19937_64 *random, int *query)
+	{
+		std::uniform_int_distribution<int> row(0, map->GetRows() - 1);
+		std::uniform_int_distribution<int> col(0, map->GetCols() - 1);
+		std::uniform_int_distribution<int> offset(-span, span);
+
+		for (auto attempt = 0; attempt < 256; attempt++)
+		{
+			query[0] = row(*random);
+			query[1] = col(*random);
+			query[2] = query[0] + offset(*random);
+			query[3] = query[1] + offset(*random);
+			if (!map->IsWall(query[0], query[1]) && !map->IsWall(query[2], query[3]))
+				return true;
+		}
+		return false;
+	}
+
+	// Runs the engines on random queries of a tiled map, which is created first if the file doesn't exist
+	int RunTiled(const BenchOptions &options)
+	{
+		TiledMap map;
+		std::string error;
+		const auto existing = std::fopen(options.tiled.c_str(), "rb");
+		if (existing != nullptr)
+		{
+			std::fclose(existing);
+			if (!map.Open(options.tiled, false, &error))
+			{
+				std::fprintf(stderr, "%s\n", error.c_str());
+				return 1;
+			}
+		}
+		else
+		{
+			const auto size = options.sizes.empty() ? DefaultTiledSize : options.sizes.front();
+			const auto begin = std::chrono::steady_clock::now();
+			if (!map.Create(options.tiled, size.first, size.second, &error))
+			{
+				std::fprintf(stderr, "%s\n", error.c_str());
+				return 1;
+			}
+			GenerateTiledWalls(&map, options.density, options.seed);
+			std::fprintf(stderr, "Created %s in %.0f ms\n", options.tiled.c_str(),
+				std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count() * 1000.0);
+		}
+		map.SetCacheCapacity(options.tileCache);
+
+		// The same queries for every engine
+		std::mt19937_64 random(options.seed);
+		std::vector<std::array<int, 4>> queries;
+		for (auto query = 0; query < options.queries; query++)
+		{
+			std::array<int, 4> cells {};
+			if (PickTiledQuery(&map, options.span, &random, cells.data()))
+				queries.push_back(cells);
+		}
+
+		if (options.csv)
+			std::printf("rows,cols,engine,queries,found,mean_path,windows,mean_window_cells,expansions,time_ms,tile_hits,tile_misses,tile_hit_rate,peak_rss_mib\n");
+		else
+			std::printf("%7s %7s %-8s %7s %5s %9s %7s %12s %12s %10s %11s %11s %8s %9s\n",
+				"rows", "cols", "engine", "queries", "found", "mean_path", "windows", "window_cells", "expansions", "time_ms",
+				"tile_hits", "tile_misses", "hit_rate", "rss_mib");
+
+		Grid grid;
+		for (const auto &name : options.engines)
+		{
+			std::unique_ptr<SearchEngine> engine(CreateSearchEngine(name, options.connectivity));
+			if (engine == nullptr)
+			{
+				std::fprintf(stderr, "Unknown engine: %s\n", name.c_str());
+				return 1;
+			}
+			engine->SetThreadCount(options.threads);
+			map.ResetCacheStats();
+
+			auto found = 0;
+			auto windows = 0;
+			double pathCells = 0;
+			double windowCells = 0;
+			std::uint64_t expansions = 0;
+			const auto begin = std::chrono::steady_clock::now();
+			for (const auto &query : queries)
+			{
+				const auto result = SearchTiledMap(&map, engine.get(), &grid, query[0], query[1], query[2], query[3], options.windowCells);
+				found += result.found ? 1 : 0;
+				windows += result.windows;
+				pathCells += static_cast<double>(result.path.size());
+				windowCells += static_cast<double>(result.windowCells);
+				expansions += result.expansions;
+			}
+			const auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+			const auto &stats = map.GetCacheStats();
+			const auto lookups = stats.hits + stats.misses;
+			const auto count = std::max<std::size_t>(queries.size(), 1);
+			std::printf(options.csv
+				? "%d,%d,%s,%zu,%d,%.1f,%d,%.0f,%llu,%.3f,%llu,%llu,%.4f,%.1f\n"
+				: "%7d %7d %-8s %7zu %5d %9.1f %7d %12.0f %12llu %10.3f %11llu %11llu %8.4f %9.1f\n",
+				map.GetRows(), map.GetCols(), name.c_str(), queries.size(), found, found > 0 ? pathCells / found : 0.0,
+				windows, windowCells / count, static_cast<unsigned long long>(expansions), seconds * 1000.0,
+				static_cast<unsigned long long>(stats.hits), static_cast<unsigned long long>(stats.misses),
+				lookups > 0 ? static_cast<double>(stats.hits) / lookups : 0.0, PeakRssMiB());
+		}
+		return 0;
+	}
+
+}
+
+int main(int argc, char *argv[])
+{
+	BenchOptions options;
+	if (!ParseOptions(argc, argv, &options))
+	{
+		PrintUsage(argv[0]);
+		return 1;
+	}
+
+	if (!options.tiled.empty())
+		return RunTiled(options);
+
+	if (options.csv)
+		std::printf("rows,cols,engine,found,path_length,expansions,time_ms,expansions_per_sec,peak_frontier,peak_rss_mib\n");
+	else
+		std::printf("%7s %7s %-8s %5s %9s %12s %10s %14s %13s %9s\n",
+			"rows", "cols", "engine", "found", "path", "expansions", "time_ms", "expansions/s", "peak_frontier", "rss_mib");
+
+	// A map file replaces the generated grids
+	Grid grid;
+	if (!options.map.empty())
+	{
+		std::string error;
+		if (!LoadMap(options.map, &grid, nullptr, &error))
+		{
+			std::fprintf(stderr, "%s\n", error.c_str());
+			return 1;
+		}
+		options.sizes = { { grid.GetRows(), grid.GetCols() } };
+	}
+
+	for (const auto &size : options.sizes)
+	{
+		if (options.map.empty())
+		{
+			grid.Resize(size.first, size.second);
+			grid.SetStart(grid.GetId(0, 0));
+			grid.SetGoal(grid.GetId(size.first - 1, size.second - 1));
+			GeneratorOptions generator;
+			generator.layout = options.layout;
+			generator.seed = options.seed;
+			generator.density = options.density;
+			generator.threads = options.threads;
+			GenerateMap(&grid, generator);
+			GenerateCosts(&grid, options.maxCost, options.seed);
+		}
+
+		for (const auto &name : options.engines)
+		{
+			std::unique_ptr<SearchEngine> engine(CreateSearchEngine(name, options.connectivity));
+			if (engine == nullptr)
+			{
+				std::fprintf(stderr, "Unknown engine: %s\n", name.c_str());
+				return 1;
+			}
+
+			engine->SetThreadCount(options.threads);
+
+			const auto begin = std::chrono::steady_clock::now();
+			engine->Start(&grid);
+			const auto started = std::chrono::steady_clock::now();
+			engine->Run();
+			const auto end = std::chrono::steady_clock::now();
+			const auto path = grid.GetPath(engine->GetResult());
+			const auto traced = std::chrono::steady_clock::now();
+
+			const auto seconds = std::chrono::duration<double>(end - begin).count();
+			const auto &stats = engine->GetStats();
+			const auto found = engine->GetResult() != NO_CELL;
+			const auto pathLength = static_cast<int>(path.size());
+			const auto rate = seconds > 0 ? stats.expansions / seconds : 0.0;
+
+			if (!options.stats.empty())
+			{
+				SearchRecord record;
+				record.engine = name;
+				record.connectivity = GetConnectivityName(options.connectivity);
+				record.rows = size.first;
+				record.cols = size.second;
+				record.found = found;
+				record.pathCells = path.size();
+				record.setupNs = GetNanoseconds(started - begin);
+				record.searchNs = GetNanoseconds(end - started);
+				record.pathNs = GetNanoseconds(traced - end);
+				CollectSearchRecord(*engine, &record);
+
+				std::string error;
+				if (!AppendSearchRecord(options.stats, record, &error))
+				{
+					std::fprintf(stderr, "%s\n", error.c_str());
+					return 1;
+				}
+			}
+
+			std::printf(options.csv
+				? "%d,%d,%s,%d,%d,%llu,%.3f,%.0f,%zu,%.1f\n"
+				: "%7d %7d %-8s %5d %9d %12llu %10.3f %14.0f %13zu %9.1f\n",
+				size.first, size.second, name.c_str(), found ? 1 : 0, pathLength,
+				static_cast<unsigned long long>(stats.expansions), seconds * 1000.0, rate,
+				stats.peakFrontier, PeakRssMiB());
+
+			// The hierarchical engine keeps its abstract graph, so a second query only searches and refines
+			if (name == "hpa")
+			{
+				const auto warmBegin = std::chrono::steady_clock::now();
+				engine->Start(&grid);
+				engine->Run();
+				const auto warmSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - warmBegin).count();
+
+				std::printf(options.csv
+					? "%d,%d,%s,%d,%d,%llu,%.3f,%.0f,%zu,%.1f\n"
+					: "%7d %7d %-8s %5d %9d %12llu %10.3f %14.0f %13zu %9.1f\n",
+					size.first, size.second, "hpa-warm", engine->GetResult() != NO_CELL ? 1 : 0,
+					static_cast<int>(grid.GetPath(engine->GetResult()).size()),
+					static_cast<unsigned long long>(stats.expansions), warmSeconds * 1000.0,
+					warmSeconds > 0 ? stats.expansions / warmSeconds : 0.0, stats.peakFrontier, PeakRssMiB());
+			}
+
+			// Wall edits repaired by the incremental engines, the walls are restored afterwards
+			const auto incremental = dynamic_cast<IncrementalSearchBase*>(engine.get());
+			if (incremental != nullptr && options.edits > 0)
+			{
+				std::mt19937_64 random(options.seed + 1);
+				std::uniform_int_distribution<int> row(0, size.first - 1);
+				std::uniform_int_distribution<int> col(0, size.second - 1);
+				std::vector<int> edited;
+				std::uint64_t expansions = 0;
+				auto replanSeconds = 0.0;
+
+				for (auto edit = 0; edit < options.edits; edit++)
+				{
+					const auto id = grid.GetId(row(random), col(random));
+					if (id == grid.GetStart() || id == grid.GetGoal())
+						continue;
+
+					grid.IsWall(id) ? grid.UnsetWall(id) : grid.SetWall(id);
+					edited.push_back(id);
+
+					const auto replanBegin = std::chrono::steady_clock::now();
+					incremental->UpdateCell(id);
+					incremental->Replan();
+					replanSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - replanBegin).count();
+					expansions += incremental->GetStats().expansions;
+				}
+
+				for (auto id = edited.rbegin(); id != edited.rend(); ++id)
+					grid.IsWall(*id) ? grid.UnsetWall(*id) : grid.SetWall(*id);
+
+				std::printf(options.csv
+					? "%d,%d,%s,%d,%d,%llu,%.3f,%.0f,%zu,%.1f\n"
+					: "%7d %7d %-8s %5d %9d %12llu %10.3f %14.0f %13zu %9.1f\n",
+					size.first, size.second, (name + "-replan").c_str(), incremental->GetResult() != NO_CELL ? 1 : 0,
+					static_cast<int>(grid.GetPath(incremental->GetResult()).size()),
+					static_cast<unsigned long long>(expansions), replanSeconds * 1000.0,
+					replanSeconds > 0 ? expansions / replanSeconds : 0.0, incremental->GetStats().peakFrontier, PeakRssMiB());
+			}
+		}
+
+		// Distance fields of many sources in passes of SOURCES_PER_PASS
+		if (options.sources > 0)
+		{
+			const auto sources = PickSources(grid, options.sources, options.seed);
+			MultiSourceSearch search(options.connectivity);
+			search.SetThreadCount(options.threads);
+
+			const auto begin = std::chrono::steady_clock::now();
+			search.Run(&grid, sources);
+			const auto end = std::chrono::steady_clock::now();
+
+			const auto seconds = std::chrono::duration<double>(end - begin).count();
+			const auto &stats = search.GetStats();
+			const auto rate = seconds > 0 ? stats.expansions / seconds : 0.0;
+
+			std::printf(options.csv
+				? "%d,%d,%s,%d,%d,%llu,%.3f,%.0f,%zu,%.1f\n"
+				: "%7d %7d %-8s %5d %9d %12llu %10.3f %14.0f %13zu %9.1f\n",
+				size.first, size.second, "msbfs", static_cast<int>(sources.size()), 0,
+				static_cast<unsigned long long>(stats.expansions), seconds * 1000.0, rate,
+				stats.peakFrontier, PeakRssMiB());
+		}
+
+		// Full build of the connected component index
+		if (options.components)
+		{
+			ComponentIndex components(&grid, options.connectivity);
+			components.SetThreadCount(options.threads);
+
+			const auto begin = std::chrono::steady_clock::now();
+			const auto connected = components.IsConnected(grid.GetStart(), grid.GetGoal());
+			const auto end = std::chrono::steady_clock::now();
+
+			const auto seconds = std::chrono::duration<double>(end - begin).count();
+			const auto sizes = components.GetComponentSizes();
+			long long open = 0;
+			for (const auto size : sizes)
+				open += size;
+
+			std::printf(options.csv
+				? "%d,%d,%s,%d,%d,%llu,%.3f,%.0f,%zu,%.1f\n"
+				: "%7d %7d %-8s %5d %9d %12llu %10.3f %14.0f %13zu %9.1f\n",
+				size.first, size.second, "cc", connected ? 1 : 0, components.GetComponentCount(),
+				static_cast<unsigned long long>(open), seconds * 1000.0, seconds > 0 ? open / seconds : 0.0,
+				sizes.empty() ? std::size_t(0) : static_cast<std::size_t>(sizes.front()), PeakRssMiB());
+		}
+
+		// Full build of the flow field, then refreshes after batches of wall edits checked against a full build
+		if (options.flowField)
+		{
+			FlowField field(&grid, options.connectivity);
+			field.SetThreadCount(options.threads);
+			field.SetGoal(grid.GetGoal());
+
+			const auto begin = std::chrono::steady_clock::now();
+			field.Refresh();
+			const auto end = std::chrono::steady_clock::now();
+
+			const auto seconds = std::chrono::duration<double>(end - begin).count();
+			const auto &stats = field.GetStats();
+			auto steps = 0;
+			for (auto id = grid.GetStart(); id != NO_CELL && field.GetIntegration(id) != NO_DISTANCE && id != grid.GetGoal(); id = field.GetNext(id))
+				steps++;
+
+			std::printf(options.csv
+				? "%d,%d,%s,%d,%d,%llu,%.3f,%.0f,%zu,%.1f\n"
+				: "%7d %7d %-8s %5d %9d %12llu %10.3f %14.0f %13zu %9.1f\n",
+				size.first, size.second, "flow", field.GetIntegration(grid.GetStart()) != NO_DISTANCE ? 1 : 0, steps,
+				static_cast<unsigned long long>(stats.expansions), seconds * 1000.0,
+				seconds > 0 ? stats.expansions / seconds : 0.0, stats.peakFrontier, PeakRssMiB());
+
+			if (options.edits > 0)
+			{
+				std::mt19937_64 random(options.seed + 1);
+				std::uniform_int_distribution<int> row(0, size.first - 1);
+				std::uniform_int_distribution<int> col(0, size.second - 1);
+				std::vector<int> edited;
+				std::uint64_t expansions = 0;
+				std::size_t peakFrontier = 0;
+				auto refreshSeconds = 0.0;
+				auto mismatches = 0;
+
+				for (auto edit = 0; edit < options.edits; edit++)
+				{
+					const auto id = grid.GetId(row(random), col(random));
+					if (id != grid.GetGoal())
+					{
+						grid.IsWall(id) ? grid.UnsetWall(id) : grid.SetWall(id);
+						edited.push_back(id);
+					}
+					if ((edit + 1) % FlowEditBatch != 0 && edit + 1 != options.edits)
+						continue;
+
+					const auto refreshBegin = std::chrono::steady_clock::now();
+					field.Refresh();
+					refreshSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - refreshBegin).count();
+					expansions += field.GetStats().expansions;
+					peakFrontier = std::max(peakFrontier, field.GetStats().peakFrontier);
+
+					FlowField reference(&grid, options.connectivity);
+					reference.SetThreadCount(options.threads);
+					reference.SetGoal(grid.GetGoal());
+					reference.Refresh();
+					for (auto cell = 0; cell < grid.GetCapacity(); cell++)
+					{
+						if (field.GetIntegration(cell) != reference.GetIntegration(cell))
+							mismatches++;
+					}
+				}
+
+				for (auto id = edited.rbegin(); id != edited.rend(); ++id)
+					grid.IsWall(*id) ? grid.UnsetWall(*id) : grid.SetWall(*id);
+
+				std::printf(options.csv
+					? "%d,%d,%s,%d,%d,%llu,%.3f,%.0f,%zu,%.1f\n"
+					: "%7d %7d %-8s %5d %9d %12llu %10.3f %14.0f %13zu %9.1f\n",
+					size.first, size.second, "flow-refresh", field.GetBuildCount(), mismatches,
+					static_cast<unsigned long long>(expansions), refreshSeconds * 1000.0,
+					refreshSeconds > 0 ? expansions / refreshSeconds : 0.0, peakFrontier, PeakRssMiB());
+				if (mismatches > 0)
+				{
+					std::fprintf(stderr, "Flow field refresh differs from a full build in %d cells\n", mismatches);
+					return 1;
+				}
+			}
+		}
+	}
+	return 0;
+}
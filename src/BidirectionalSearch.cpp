@@ -0,0 +1,159 @@
+#include "BidirectionalSearch.h"
+
+#include <utility>
+
+template <typename Conn>
+void BidirectionalSearch<Conn>::Start(Grid *grid)
+{
+	SearchEngine::Start(grid);
+	grid->PrepareBackwardSearch();
+	this->m_forward.clear();
+	this->m_backward.clear();
+	this->m_forwardDepth = 0;
+	this->m_backwardDepth = 0;
+	this->m_meeting = NO_CELL;
+
+	// Starting points, a cell reached from the goal stores its distance to the goal
+	const auto start = grid->GetStart();
+	const auto goal = grid->GetGoal();
+	grid->SetVisited(start, true);
+	grid->SetDistance(start, 0);
+	this->m_forward.push_back(start);
+
+	grid->SetVisitedFromGoal(goal);
+	grid->SetDistance(goal, 0);
+	this->m_backward.push_back(goal);
+
+	if (start == goal)
+		Finish(start);
+}
+
+template <typename Conn>
+bool BidirectionalSearch<Conn>::Step()
+{
+	if (this->m_finished)
+		return false;
+
+	if (this->m_forward.empty() || this->m_backward.empty())
+	{
+		Finish(NO_CELL); // Goal NOT found
+		return false;
+	}
+
+	// Grow the cheaper side
+	const auto forward = this->m_forward.size() <= this->m_backward.size();
+	const auto &frontier = forward ? this->m_forward : this->m_backward;
+
+	this->m_stats.expansions += frontier.size();
+	if (this->m_trace != nullptr)
+		this->m_trace->insert(this->m_trace->end(), frontier.begin(), frontier.end());
+
+	if (forward)
+		ExpandForward();
+	else
+		ExpandBackward();
+
+	const auto frontiers = this->m_forward.size() + this->m_backward.size();
+	if (frontiers > this->m_stats.peakFrontier)
+		this->m_stats.peakFrontier = frontiers;
+
+	if (this->m_meeting != NO_CELL)
+	{
+		Finish(this->m_meeting); // Searches met
+		return false;
+	}
+	return true;
+}
+
+template <typename Conn>
+std::size_t BidirectionalSearch<Conn>::GetAllocatedBytes() const
+{
+	return SearchEngine::GetAllocatedBytes() + GetBufferBytes(this->m_forward) + GetBufferBytes(this->m_backward)
+		+ GetBufferBytes(this->m_next);
+}
+
+template <typename Conn>
+void BidirectionalSearch<Conn>::ExpandForward()
+{
+	const auto grid = this->m_grid;
+	const auto distance = this->m_forwardDepth + 1;
+	this->m_next.clear();
+
+	std::uint64_t checks = 0;
+	for (const auto current : this->m_forward)
+	{
+		Conn::ForEach(grid, current, [&](const int next, bool)
+		{
+			checks++;
+			if (grid->WasVisited(next))
+				return true;
+
+			// Reached the backward search, keep the shortest connection of this level
+			if (grid->WasVisitedFromGoal(next))
+			{
+				const auto length = distance + grid->GetDistance(next);
+				if (this->m_meeting == NO_CELL || length < this->m_bestLength)
+				{
+					this->m_meeting = next;
+					this->m_bestLength = length;
+					grid->SetPrevious(next, current);
+				}
+				return true;
+			}
+
+			grid->SetVisited(next, true);
+			grid->SetPrevious(next, current);
+			grid->SetDistance(next, distance);
+			this->m_next.push_back(next);
+			return true;
+		});
+	}
+
+	this->m_stats.neighborChecks += checks;
+	std::swap(this->m_forward, this->m_next);
+	this->m_forwardDepth = distance;
+}
+
+template <typename Conn>
+void BidirectionalSearch<Conn>::ExpandBackward()
+{
+	const auto grid = this->m_grid;
+	const auto distance = this->m_backwardDepth + 1;
+	this->m_next.clear();
+
+	std::uint64_t checks = 0;
+	for (const auto current : this->m_backward)
+	{
+		Conn::ForEach(grid, current, [&](const int next, bool)
+		{
+			checks++;
+			if (grid->WasVisitedFromGoal(next))
+				return true;
+
+			// Reached the forward search, keep the shortest connection of this level
+			if (grid->WasVisited(next))
+			{
+				const auto length = grid->GetDistance(next) + distance;
+				if (this->m_meeting == NO_CELL || length < this->m_bestLength)
+				{
+					this->m_meeting = next;
+					this->m_bestLength = length;
+					grid->SetNext(next, current);
+				}
+				return true;
+			}
+
+			grid->SetVisitedFromGoal(next);
+			grid->SetNext(next, current);
+			grid->SetDistance(next, distance);
+			this->m_next.push_back(next);
+			return true;
+		});
+	}
+
+	this->m_stats.neighborChecks += checks;
+	std::swap(this->m_backward, this->m_next);
+	this->m_backwardDepth = distance;
+}
+
+INSTANTIATE_ENGINE(BidirectionalSearch)
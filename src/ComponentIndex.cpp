@@ -0,0 +1,415 @@
+#include "ComponentIndex.h"
+
+#include <algorithm>
+
+namespace
+{
+	// Cells a local search floods before an edit falls back to a full build
+	const std::size_t ExploreBudget = 4096;
+
+	// Fewest rows per band of a parallel build
+	const int MinBandRows = 64;
+}
+
+ComponentIndex::ComponentIndex(Grid *grid, const Connectivity connectivity)
+	: m_grid(grid)
+	, m_connectivity(connectivity)
+{
+	this->m_grid->AddObserver(this);
+}
+
+ComponentIndex::~ComponentIndex()
+{
+	this->m_grid->RemoveObserver(this);
+}
+
+Connectivity ComponentIndex::GetConnectivity() const
+{
+	return this->m_connectivity;
+}
+
+void ComponentIndex::SetConnectivity(const Connectivity connectivity)
+{
+	if (connectivity != this->m_connectivity)
+		this->m_dirty = true;
+	this->m_connectivity = connectivity;
+}
+
+void ComponentIndex::SetThreadCount(const int threads)
+{
+	this->m_threadCount = threads;
+}
+
+bool ComponentIndex::IsConnected(const int a, const int b)
+{
+	const auto component = GetComponent(a);
+	return component != NO_COMPONENT && component == GetComponent(b);
+}
+
+int ComponentIndex::GetComponent(const int id)
+{
+	EnsureBuilt();
+	if (id == NO_CELL || this->m_node[id] < 0)
+		return NO_COMPONENT;
+	return Find(this->m_node[id]);
+}
+
+int ComponentIndex::GetComponentSize(const int id)
+{
+	const auto component = GetComponent(id);
+	return component == NO_COMPONENT ? 0 : this->m_size[component];
+}
+
+int ComponentIndex::GetComponentCount()
+{
+	EnsureBuilt();
+	return this->m_componentCount;
+}
+
+int ComponentIndex::GetLargestComponentSize()
+{
+	EnsureBuilt();
+	return this->m_sizeCounts.empty() ? 0 : this->m_sizeCounts.rbegin()->first;
+}
+
+std::vector<int> ComponentIndex::GetComponentSizes()
+{
+	EnsureBuilt();
+
+	// Every root once
+	std::vector<int> sizes;
+	std::vector<bool> counted(this->m_parent.size(), false);
+	for (const auto node : this->m_node)
+	{
+		if (node < 0)
+			continue;
+
+		const auto root = Find(node);
+		if (!counted[root])
+		{
+			counted[root] = true;
+			sizes.push_back(this->m_size[root]);
+		}
+	}
+	std::sort(sizes.begin(), sizes.end(), [](const int a, const int b) { return a > b; });
+	return sizes;
+}
+
+int ComponentIndex::GetBuildCount() const
+{
+	return this->m_buildCount;
+}
+
+void ComponentIndex::OnWallChanged(const int id, const bool wall)
+{
+	// A pending build picks the edit up anyway
+	if (this->m_dirty)
+		return;
+
+	DispatchConnectivity(this->m_connectivity, [&](auto policy)
+	{
+		using Conn = decltype(policy);
+		if (wall)
+			CloseCell<Conn>(id);
+		else
+			OpenCell<Conn>(id);
+	});
+}
+
+void ComponentIndex::OnGridReset()
+{
+	this->m_dirty = true;
+}
+
+void ComponentIndex::EnsureBuilt()
+{
+	if (this->m_dirty)
+		Build();
+}
+
+void ComponentIndex::Build()
+{
+	const auto grid = this->m_grid;
+	const auto capacity = static_cast<std::size_t>(grid->GetCapacity());
+	this->m_node.assign(capacity, -1);
+	this->m_parent.resize(capacity);
+	this->m_size.resize(capacity);
+	this->m_mark.assign(capacity, 0);
+	this->m_stamp = 0;
+
+	// One band of rows per thread, small grids are labeled by the caller alone
+	const auto configured = this->m_threadCount > 0 ? this->m_threadCount : ThreadPool::GetDefaultThreadCount();
+	const auto rows = grid->GetRows();
+	const auto bands = std::max(1, std::min(configured, rows / MinBandRows));
+
+	DispatchConnectivity(this->m_connectivity, [&](auto policy)
+	{
+		using Conn = decltype(policy);
+		std::vector<int> unions(bands, 0);
+
+		if (bands == 1)
+		{
+			unions[0] = BuildBand<Conn>(0, rows - 1);
+		}
+		else
+		{
+			// The pool is sized by the configuration, not the grid, so resizes don't restart threads
+			if (this->m_pool == nullptr || this->m_pool->GetThreadCount() != configured)
+				this->m_pool.reset(new ThreadPool(configured));
+
+			// Bands only union their own cells, so they need no synchronization
+			this->m_pool->Run([&](const int band)
+			{
+				if (band < bands)
+					unions[band] = BuildBand<Conn>(rows * band / bands, rows * (band + 1) / bands - 1);
+			});
+
+			for (auto band = 1; band < bands; band++)
+				unions[0] += JoinSeam<Conn>(rows * band / bands - 1);
+		}
+
+		auto open = 0;
+		for (const auto node : this->m_node)
+			open += node >= 0;
+
+		auto joined = 0;
+		for (const auto count : unions)
+			joined += count;
+		this->m_componentCount = open - joined;
+	});
+
+	// A full build uses the cell ids as nodes, the roots are the components
+	this->m_sizeCounts.clear();
+	for (auto id = 0; id < static_cast<int>(capacity); id++)
+	{
+		if (this->m_node[id] == id && this->m_parent[id] == id)
+			CountSize(this->m_size[id], 1);
+	}
+
+	this->m_dirty = false;
+	this->m_buildCount++;
+}
+
+template <typename Conn>
+int ComponentIndex::BuildBand(const int firstRow, const int lastRow)
+{
+	const auto grid = this->m_grid;
+	const auto begin = grid->GetId(firstRow, 0);
+	const auto end = grid->GetId(lastRow, grid->GetCols() - 1) + 1;
+	auto unions = 0;
+
+	for (auto id = begin; id < end; id++)
+	{
+		if (grid->IsWall(id))
+			continue;
+
+		this->m_node[id] = id;
+		this->m_parent[id] = id;
+		this->m_size[id] = 1;
+	}
+
+	// Every pair once, from its lower id, and only within the band
+	for (auto id = begin; id < end; id++)
+	{
+		if (grid->IsWall(id))
+			continue;
+
+		Conn::ForEach(grid, id, [&](const int next, bool)
+		{
+			if (next > id && next < end && Union(id, next))
+				unions++;
+			return true;
+		});
+	}
+	return unions;
+}
+
+template <typename Conn>
+int ComponentIndex::JoinSeam(const int row)
+{
+	const auto grid = this->m_grid;
+	const auto begin = grid->GetId(row, 0);
+	const auto end = grid->GetId(row, grid->GetCols() - 1) + 1;
+	auto unions = 0;
+
+	for (auto id = begin; id < end; id++)
+	{
+		if (grid->IsWall(id))
+			continue;
+
+		Conn::ForEach(grid, id, [&](const int next, bool)
+		{
+			if (next >= end && Union(this->m_node[id], this->m_node[next]))
+				unions++;
+			return true;
+		});
+	}
+	return unions;
+}
+
+template <typename Conn>
+void ComponentIndex::OpenCell(const int id)
+{
+	const auto node = AddNode(1);
+	this->m_node[id] = node;
+	this->m_componentCount++;
+	CountSize(1, 1);
+
+	Conn::ForEach(this->m_grid, id, [&](const int next, bool)
+	{
+		const auto size = this->m_size[Find(node)];
+		const auto nextSize = this->m_size[Find(this->m_node[next])];
+		if (Union(node, this->m_node[next]))
+		{
+			this->m_componentCount--;
+			CountSize(size, -1);
+			CountSize(nextSize, -1);
+			CountSize(size + nextSize, 1);
+		}
+		return true;
+	});
+}
+
+template <typename Conn>
+void ComponentIndex::CloseCell(const int id)
+{
+	const auto root = Find(this->m_node[id]);
+	this->m_node[id] = -1;
+	CountSize(this->m_size[root], -1);
+	if (--this->m_size[root] == 0)
+	{
+		this->m_componentCount--;
+		return;
+	}
+	CountSize(this->m_size[root], 1);
+
+	// Cells that could have been connected through this one
+	std::vector<int> pending;
+	Conn::ForEach(this->m_grid, id, [&](const int next, bool)
+	{
+		pending.push_back(next);
+		return true;
+	});
+
+	/*
+	 * Sort the neighbors into pieces. Every piece but one has to leave the
+	 * old component; a piece that fits the budget is moved to a new node, a
+	 * larger one has to be the piece that stays. Two large pieces may or may
+	 * not meet far away, only a full build can tell.
+	 */
+	auto kept = false;
+	while (!pending.empty())
+	{
+		// The last piece stays if no other did
+		if (pending.size() == 1 && !kept)
+			return;
+
+		const auto from = pending.back();
+		const auto flooded = Explore<Conn>(from, &pending, !kept);
+
+		if (!flooded)
+		{
+			if (kept)
+			{
+				this->m_dirty = true;
+				return;
+			}
+			kept = true;
+			continue;
+		}
+
+		// All neighbors in one piece, nothing was cut
+		if (pending.empty() && !kept)
+			return;
+
+		const auto node = AddNode(static_cast<int>(this->m_queue.size()));
+		CountSize(this->m_size[root], -1);
+		this->m_size[root] -= static_cast<int>(this->m_queue.size());
+		CountSize(this->m_size[root], 1);
+		CountSize(this->m_size[node], 1);
+		for (const auto cell : this->m_queue)
+			this->m_node[cell] = node;
+		this->m_componentCount++;
+	}
+}
+
+template <typename Conn>
+bool ComponentIndex::Explore(const int from, std::vector<int> *targets, const bool stopWhenAllFound)
+{
+	const auto grid = this->m_grid;
+
+	// Restart the stamps when they wrap around
+	if (++this->m_stamp == 0)
+	{
+		std::fill(this->m_mark.begin(), this->m_mark.end(), 0);
+		this->m_stamp = 1;
+	}
+
+	auto &queue = this->m_queue;
+	queue.clear();
+
+	const auto reach = [&](const int cell)
+	{
+		this->m_mark[cell] = this->m_stamp;
+		queue.push_back(cell);
+		targets->erase(std::remove(targets->begin(), targets->end(), cell), targets->end());
+	};
+	reach(from);
+
+	for (std::size_t head = 0; head < queue.size(); head++)
+	{
+		// Too large to move, or known to be the only piece left
+		if (queue.size() > ExploreBudget || (stopWhenAllFound && targets->empty()))
+			return false;
+
+		Conn::ForEach(grid, queue[head], [&](const int next, bool)
+		{
+			if (this->m_mark[next] != this->m_stamp)
+				reach(next);
+			return true;
+		});
+	}
+	return true;
+}
+
+void ComponentIndex::CountSize(const int size, const int delta)
+{
+	auto &count = this->m_sizeCounts[size];
+	count += delta;
+	if (count == 0)
+		this->m_sizeCounts.erase(size);
+}
+
+int ComponentIndex::Find(int node)
+{
+	// Path halving
+	while (this->m_parent[node] != node)
+	{
+		this->m_parent[node] = this->m_parent[this->m_parent[node]];
+		node = this->m_parent[node];
+	}
+	return node;
+}
+
+bool ComponentIndex::Union(const int a, const int b)
+{
+	auto rootA = Find(a);
+	auto rootB = Find(b);
+	if (rootA == rootB)
+		return false;
+
+	// Smaller tree below the larger one
+	if (this->m_size[rootA] < this->m_size[rootB])
+		std::swap(rootA, rootB);
+	this->m_parent[rootB] = rootA;
+	this->m_size[rootA] += this->m_size[rootB];
+	return true;
+}
+
+int ComponentIndex::AddNode(const int size)
+{
+	const auto node = static_cast<int>(this->m_parent.size());
+	this->m_parent.push_back(node);
+	this->m_size.push_back(size);
+	return node;
+}
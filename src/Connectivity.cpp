@@ -0,0 +1,30 @@
+#include "Connectivity.h"
+
+std::string GetConnectivityName(const Connectivity connectivity)
+{
+	switch (connectivity)
+	{
+	case Connectivity::Eight:
+		return "8";
+	case Connectivity::EightNoCornerCutting:
+		return "8nc";
+	case Connectivity::Hex:
+		return "hex";
+	case Connectivity::Four:
+	default:
+		return "4";
+	}
+}
+
+bool ParseConnectivity(const std::string &name, Connectivity *connectivity)
+{
+	for (const auto candidate : { Connectivity::Four, Connectivity::Eight, Connectivity::EightNoCornerCutting, Connectivity::Hex })
+	{
+		if (GetConnectivityName(candidate) == name)
+		{
+			*connectivity = candidate;
+			return true;
+		}
+	}
+	return false;
+}
@@ -0,0 +1,203 @@
+#include "DijkstraSearch.h"
+
+#include <limits>
+
+namespace
+{
+	const auto Unreached = std::numeric_limits<RadixHeap::Key>::max();
+}
+
+template <typename Conn>
+void DijkstraSearch<Conn>::Start(Grid *grid)
+{
+	SearchEngine::Start(grid);
+	this->m_uniform = grid->IsUniformCost() && !Conn::HasDiagonals;
+	this->m_open.Clear();
+	this->m_queue.clear();
+	this->m_head = 0;
+	this->m_cost.assign(grid->GetCapacity(), Unreached);
+
+	// Starting point
+	const auto start = grid->GetStart();
+	this->m_cost[start] = 0;
+	grid->SetDistance(start, 0);
+
+	if (this->m_uniform)
+	{
+		grid->SetVisited(start, true);
+		this->m_queue.push_back(start);
+		if (start == grid->GetGoal())
+			Finish(start);
+	}
+	else
+	{
+		this->m_open.Push(0, start);
+	}
+}
+
+template <typename Conn>
+bool DijkstraSearch<Conn>::Step()
+{
+	return this->m_uniform ? ExpandUniform() : ExpandWeighted();
+}
+
+template <typename Conn>
+void DijkstraSearch<Conn>::Run()
+{
+	if (this->m_uniform)
+	{
+		while (ExpandUniform())
+		{
+		}
+	}
+	else
+	{
+		while (ExpandWeighted())
+		{
+		}
+	}
+}
+
+template <typename Conn>
+std::size_t DijkstraSearch<Conn>::GetAllocatedBytes() const
+{
+	return SearchEngine::GetAllocatedBytes() + this->m_open.GetAllocatedBytes()
+		+ GetBufferBytes(this->m_queue) + GetBufferBytes(this->m_cost);
+}
+
+template <typename Conn>
+long long DijkstraSearch<Conn>::GetPathCost() const
+{
+	return this->m_result == NO_CELL ? 0 : static_cast<long long>(this->m_cost[this->m_result]);
+}
+
+template <typename Conn>
+inline bool DijkstraSearch<Conn>::ExpandWeighted()
+{
+	if (this->m_finished)
+		return false;
+
+	/*
+	 * Dijkstra's algorithm
+	 *
+	 * Pop the open cell with the lowest cost, skipping stale entries.
+	 * The goal is only accepted when popped, which keeps the path cheapest.
+	 * Relax the neighbors and push the ones whose cost improved.
+	 */
+
+	const auto grid = this->m_grid;
+	auto current = NO_CELL;
+	RadixHeap::Key cost = 0;
+	while (!this->m_open.IsEmpty())
+	{
+		const auto entry = this->m_open.Pop();
+		if (!grid->WasVisited(entry.second) && entry.first == this->m_cost[entry.second])
+		{
+			cost = entry.first;
+			current = entry.second;
+			break;
+		}
+	}
+
+	if (current == NO_CELL)
+	{
+		Finish(NO_CELL); // Goal NOT found
+		return false;
+	}
+
+	grid->SetVisited(current, true);
+	this->m_stats.expansions++;
+	if (this->m_trace != nullptr)
+		this->m_trace->push_back(current);
+
+	if (current == grid->GetGoal())
+	{
+		Finish(current); // Goal found
+		return false;
+	}
+
+	const auto distance = grid->GetDistance(current) + 1;
+
+	auto checks = 0;
+	auto duplicates = 0;
+	Conn::ForEach(grid, current, [&](const int next, const bool diagonal)
+	{
+		checks++;
+		if (grid->WasVisited(next))
+			return true;
+
+		const auto nextCost = cost + grid->GetCost(next) * RadixHeap::Key(diagonal ? DIAGONAL_COST : STRAIGHT_COST);
+		if (nextCost < this->m_cost[next])
+		{
+			if (this->m_cost[next] != Unreached)
+				duplicates++;
+
+			this->m_cost[next] = nextCost;
+			grid->SetPrevious(next, current);
+			grid->SetDistance(next, distance);
+			this->m_open.Push(nextCost, next);
+		}
+		return true;
+	});
+
+	this->m_stats.neighborChecks += checks;
+	this->m_stats.duplicatePushes += duplicates;
+	if (this->m_open.GetSize() > this->m_stats.peakFrontier)
+		this->m_stats.peakFrontier = this->m_open.GetSize();
+
+	return true;
+}
+
+template <typename Conn>
+inline bool DijkstraSearch<Conn>::ExpandUniform()
+{
+	if (this->m_finished)
+		return false;
+
+	if (this->m_head == this->m_queue.size())
+	{
+		Finish(NO_CELL); // Goal NOT found
+		return false;
+	}
+
+	// Every move costs STRAIGHT_COST, so this is BFS
+	const auto grid = this->m_grid;
+	const auto current = this->m_queue[this->m_head++];
+	const auto distance = grid->GetDistance(current) + 1;
+	const auto cost = this->m_cost[current] + STRAIGHT_COST;
+	const auto goal = grid->GetGoal();
+
+	this->m_stats.expansions++;
+	if (this->m_trace != nullptr)
+		this->m_trace->push_back(current);
+
+	auto checks = 0;
+	Conn::ForEach(grid, current, [&](const int next, bool)
+	{
+		checks++;
+		if (grid->WasVisited(next))
+			return true;
+
+		grid->SetVisited(next, true);
+		grid->SetPrevious(next, current);
+		grid->SetDistance(next, distance);
+		this->m_cost[next] = cost;
+		this->m_queue.push_back(next);
+
+		if (next == goal)
+		{
+			Finish(next); // Goal found
+			return false;
+		}
+		return true;
+	});
+
+	this->m_stats.neighborChecks += checks;
+	const auto frontier = this->m_queue.size() - this->m_head;
+	if (frontier > this->m_stats.peakFrontier)
+		this->m_stats.peakFrontier = frontier;
+
+	return !this->m_finished;
+}
+
+INSTANTIATE_ENGINE(DijkstraSearch)
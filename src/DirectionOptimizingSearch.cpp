@@ -0,0 +1,197 @@
+#include "DirectionOptimizingSearch.h"
+
+#include <utility>
+
+void DirectionOptimizingBase::SetThresholds(const DirectionThresholds &thresholds)
+{
+	this->m_thresholds = thresholds;
+}
+
+const DirectionThresholds &DirectionOptimizingBase::GetThresholds() const
+{
+	return this->m_thresholds;
+}
+
+const std::vector<LevelInfo> &DirectionOptimizingBase::GetLevels() const
+{
+	return this->m_levels;
+}
+
+template <typename Conn>
+void DirectionOptimizingSearch<Conn>::Start(Grid *grid)
+{
+	SearchEngine::Start(grid);
+	this->m_levels.clear();
+	this->m_frontier.clear();
+	this->m_next.clear();
+	this->m_frontierBits.assign(grid->GetWordCount(), 0);
+	this->m_mode = LevelMode::TopDown;
+	this->m_distance = 0;
+
+	// Count open cells, bits past the last id are zero and must not count
+	long long walls = 0;
+	for (auto word = 0; word < grid->GetWordCount(); word++)
+		walls += CountBits(grid->GetWallWords()[word]);
+	this->m_openCells = grid->GetCapacity() - walls;
+
+	// Starting point
+	const auto start = grid->GetStart();
+	grid->SetVisited(start, true);
+	grid->SetDistance(start, 0);
+	this->m_frontier.push_back(start);
+	this->m_unvisited = this->m_openCells - 1;
+
+	if (start == grid->GetGoal())
+		Finish(start);
+}
+
+template <typename Conn>
+bool DirectionOptimizingSearch<Conn>::Step()
+{
+	if (this->m_finished)
+		return false;
+
+	if (this->m_frontier.empty())
+	{
+		Finish(NO_CELL); // Goal NOT found
+		return false;
+	}
+
+	// Pick the direction of this level, cell counts stand for neighbor checks since every cell has as many
+	const auto frontier = static_cast<double>(this->m_frontier.size());
+	if (this->m_mode == LevelMode::TopDown && frontier > this->m_unvisited / this->m_thresholds.alpha)
+		this->m_mode = LevelMode::BottomUp;
+	else if (this->m_mode == LevelMode::BottomUp && frontier < this->m_openCells / this->m_thresholds.beta)
+		this->m_mode = LevelMode::TopDown;
+
+	this->m_levels.push_back({ this->m_mode, this->m_frontier.size() });
+	this->m_stats.expansions += this->m_frontier.size();
+	if (this->m_trace != nullptr)
+		this->m_trace->insert(this->m_trace->end(), this->m_frontier.begin(), this->m_frontier.end());
+
+	this->m_next.clear();
+	const auto goalFound = this->m_mode == LevelMode::TopDown
+		? TopDown(this->m_distance + 1)
+		: BottomUp(this->m_distance + 1);
+
+	if (this->m_next.size() > this->m_stats.peakFrontier)
+		this->m_stats.peakFrontier = this->m_next.size();
+
+	std::swap(this->m_frontier, this->m_next);
+	this->m_distance++;
+
+	if (goalFound)
+	{
+		Finish(this->m_grid->GetGoal()); // Goal found
+		return false;
+	}
+	return true;
+}
+
+template <typename Conn>
+std::size_t DirectionOptimizingSearch<Conn>::GetAllocatedBytes() const
+{
+	return SearchEngine::GetAllocatedBytes() + GetBufferBytes(this->m_frontier) + GetBufferBytes(this->m_next)
+		+ GetBufferBytes(this->m_frontierBits) + GetBufferBytes(this->m_levels);
+}
+
+template <typename Conn>
+bool DirectionOptimizingSearch<Conn>::TopDown(const int distance)
+{
+	const auto grid = this->m_grid;
+	const auto goal = grid->GetGoal();
+	auto goalFound = false;
+	std::uint64_t checks = 0;
+
+	for (const auto current : this->m_frontier)
+	{
+		Conn::ForEach(grid, current, [&](const int next, bool)
+		{
+			checks++;
+			if (grid->WasVisited(next))
+				return true;
+
+			grid->SetVisited(next, true);
+			grid->SetPrevious(next, current);
+			grid->SetDistance(next, distance);
+			this->m_next.push_back(next);
+			this->m_unvisited--;
+
+			goalFound = next == goal;
+			return !goalFound;
+		});
+
+		if (goalFound)
+			break;
+	}
+
+	this->m_stats.neighborChecks += checks;
+	return goalFound;
+}
+
+template <typename Conn>
+bool DirectionOptimizingSearch<Conn>::BottomUp(const int distance)
+{
+	const auto grid = this->m_grid;
+	const auto goal = grid->GetGoal();
+	const auto words = grid->GetWordCount();
+	const auto walls = grid->GetWallWords();
+	const auto visited = grid->GetVisitedWords();
+	const auto frontierBits = this->m_frontierBits.data();
+	const auto capacity = grid->GetCapacity();
+	auto goalFound = false;
+	std::uint64_t checks = 0;
+
+	for (const auto id : this->m_frontier)
+		frontierBits[id >> 6] |= GridWord(1) << (id & 63);
+
+	for (auto word = 0; word < words && !goalFound; word++)
+	{
+		// Open, unvisited cells of this word
+		auto candidates = ~(walls[word] | visited[word]);
+		if (word == words - 1 && (capacity & 63) != 0)
+			candidates &= (GridWord(1) << (capacity & 63)) - 1;
+
+		while (candidates != 0)
+		{
+			const auto id = word * 64 + LowestBit(candidates);
+			candidates &= candidates - 1;
+
+			// Any neighbor in the frontier is a parent on a shortest path
+			auto parent = NO_CELL;
+			Conn::ForEach(grid, id, [&](const int next, bool)
+			{
+				checks++;
+				if ((frontierBits[next >> 6] >> (next & 63)) & 1)
+				{
+					parent = next;
+					return false;
+				}
+				return true;
+			});
+
+			if (parent == NO_CELL)
+				continue;
+
+			grid->SetVisited(id, true);
+			grid->SetPrevious(id, parent);
+			grid->SetDistance(id, distance);
+			this->m_next.push_back(id);
+			this->m_unvisited--;
+
+			if (id == goal)
+			{
+				goalFound = true;
+				break;
+			}
+		}
+	}
+
+	for (const auto id : this->m_frontier)
+		frontierBits[id >> 6] = 0;
+
+	this->m_stats.neighborChecks += checks;
+	return goalFound;
+}
+
+INSTANTIATE_ENGINE(DirectionOptimizingSearch)
@@ -0,0 +1,448 @@
+#include "FlowField.h"
+
+#include <algorithm>
+#include <atomic>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace
+{
+	// Bucket cells handed out at once
+	const std::size_t ChunkSize = 256;
+
+	// Smaller buckets are expanded by the calling thread alone
+	const std::size_t ParallelThreshold = 4 * ChunkSize;
+
+	// Buckets in the ring, more than the cost of the costliest move
+	const int BucketCount = 4096;
+
+	// Past this share of the cells edited at once, a full build is cheaper
+	const std::size_t FullBuildDivisor = 64;
+
+	// Reads a cost other threads may lower
+	int LoadCost(const int *value)
+	{
+#ifdef _MSC_VER
+		return *reinterpret_cast<const volatile long*>(value);
+#else
+		return __atomic_load_n(value, __ATOMIC_RELAXED);
+#endif
+	}
+
+	// Lowers the value to the candidate if that's less, returns true if this call lowered it; safe across threads
+	bool LowerCost(int *value, const int candidate)
+	{
+#ifdef _MSC_VER
+		static_assert(sizeof(int) == sizeof(long), "costs must be 32-bit");
+		const auto volatileValue = reinterpret_cast<volatile long*>(value);
+		long current = *volatileValue;
+		while (candidate < current)
+		{
+			const auto seen = _InterlockedCompareExchange(volatileValue, candidate, current);
+			if (seen == current)
+				return true;
+			current = seen;
+		}
+		return false;
+#else
+		auto current = __atomic_load_n(value, __ATOMIC_RELAXED);
+		while (candidate < current)
+		{
+			if (__atomic_compare_exchange_n(value, &current, candidate, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+				return true;
+		}
+		return false;
+#endif
+	}
+
+	// Cost of entering a cell of the given terrain
+	int GetMoveCost(const CellCost cost, const bool diagonal)
+	{
+		return cost * (diagonal ? DIAGONAL_COST : STRAIGHT_COST);
+	}
+}
+
+FlowField::FlowField(Grid *grid, const Connectivity connectivity)
+	: m_grid(grid)
+	, m_connectivity(connectivity)
+{
+	this->m_grid->AddObserver(this);
+}
+
+FlowField::~FlowField()
+{
+	this->m_grid->RemoveObserver(this);
+}
+
+Connectivity FlowField::GetConnectivity() const
+{
+	return this->m_connectivity;
+}
+
+void FlowField::SetConnectivity(const Connectivity connectivity)
+{
+	if (connectivity != this->m_connectivity)
+		this->m_dirty = true;
+	this->m_connectivity = connectivity;
+}
+
+void FlowField::SetThreadCount(const int threads)
+{
+	this->m_threadCount = threads;
+}
+
+int FlowField::GetGoal() const
+{
+	return this->m_goal;
+}
+
+void FlowField::SetGoal(const int id)
+{
+	if (id != this->m_goal)
+		this->m_dirty = true;
+	this->m_goal = id;
+}
+
+void FlowField::UpdateCell(const int id)
+{
+	if (this->m_dirty)
+		return;
+
+	// Past a share of the cells a full build is cheaper, the edits needn't be kept
+	this->m_edits.push_back(id);
+	if (this->m_edits.size() > this->m_integration.size() / FullBuildDivisor)
+	{
+		this->m_dirty = true;
+		this->m_edits.clear();
+	}
+}
+
+std::size_t FlowField::Refresh()
+{
+	this->m_stats = SearchStats();
+
+	// Reuse the pool while the thread count stays the same
+	const auto threads = this->m_threadCount > 0 ? this->m_threadCount : ThreadPool::GetDefaultThreadCount();
+	if (this->m_pool == nullptr || this->m_pool->GetThreadCount() != threads)
+		this->m_pool.reset(new ThreadPool(threads));
+	this->m_lowered.resize(threads);
+	this->m_buckets.resize(BucketCount);
+
+	const auto capacity = static_cast<std::size_t>(this->m_grid->GetCapacity());
+	const auto goalEdited = std::find(this->m_edits.begin(), this->m_edits.end(), this->m_goal) != this->m_edits.end();
+	if (this->m_dirty || goalEdited || this->m_integration.size() != capacity)
+	{
+		DispatchConnectivity(this->m_connectivity, [this](auto policy) { Build<decltype(policy)>(); });
+		this->m_dirty = false;
+		this->m_edits.clear();
+		return capacity;
+	}
+
+	if (this->m_edits.empty())
+		return 0;
+
+	const auto changed = DispatchConnectivity(this->m_connectivity, [this](auto policy) { return Update<decltype(policy)>(); });
+	this->m_edits.clear();
+	return changed;
+}
+
+bool FlowField::IsStale() const
+{
+	return this->m_dirty || !this->m_edits.empty();
+}
+
+const SearchStats &FlowField::GetStats() const
+{
+	return this->m_stats;
+}
+
+int FlowField::GetBuildCount() const
+{
+	return this->m_buildCount;
+}
+
+std::size_t FlowField::GetAllocatedBytes() const
+{
+	auto bytes = GetBufferBytes(this->m_integration) + GetBufferBytes(this->m_next) + GetBufferBytes(this->m_buckets)
+		+ GetBufferBytes(this->m_current) + GetBufferBytes(this->m_lowered) + GetBufferBytes(this->m_edits) + GetBufferBytes(this->m_changed) + GetBufferBytes(this->m_seeds);
+	for (const auto &bucket : this->m_buckets)
+		bytes += GetBufferBytes(bucket);
+	for (const auto &lowered : this->m_lowered)
+		bytes += GetBufferBytes(lowered);
+	return bytes;
+}
+
+void FlowField::OnWallChanged(const int id, bool)
+{
+	UpdateCell(id);
+}
+
+void FlowField::OnGridReset()
+{
+	this->m_dirty = true;
+	this->m_edits.clear();
+}
+
+template <typename Conn>
+void FlowField::Build()
+{
+	const auto capacity = this->m_grid->GetCapacity();
+	this->m_integration.assign(capacity, NO_INTEGRATION);
+	this->m_next.assign(capacity, NO_CELL);
+	for (auto &bucket : this->m_buckets)
+		bucket.clear();
+	this->m_queued = 0;
+	this->m_buildCount++;
+
+	if (this->m_goal == NO_CELL || this->m_goal >= capacity || this->m_grid->IsWall(this->m_goal))
+		return;
+
+	this->m_integration[this->m_goal] = 0;
+	Push(this->m_goal, 0);
+	Propagate<Conn>();
+
+	// Every cell picks its move on its own, the costs are final
+	const auto chunks = (static_cast<std::size_t>(capacity) + ChunkSize - 1) / ChunkSize;
+	std::atomic<std::size_t> next(0);
+	this->m_pool->Run([&](int)
+	{
+		for (auto chunk = next++; chunk < chunks; chunk = next++)
+			PointRange<Conn>(nullptr, chunk * ChunkSize, std::min<std::size_t>(capacity, (chunk + 1) * ChunkSize));
+	});
+}
+
+template <typename Conn>
+std::size_t FlowField::Update()
+{
+	const auto stride = this->m_grid->GetStride();
+	this->m_changed.clear();
+	this->m_updating = true;
+
+	// Cells whose path ran through an edit lose their costs, they may have risen
+	for (const auto id : this->m_edits)
+		Invalidate(id);
+
+	// Without corner cutting a new wall also closes the diagonals past it
+	if (this->m_connectivity == Connectivity::EightNoCornerCutting)
+	{
+		const auto isSide = [stride](const int a, const int b) { return a - b == 1 || b - a == 1 || a - b == stride || b - a == stride; };
+		for (const auto id : this->m_edits)
+		{
+			for (const auto offset : { -stride - 1, -stride + 1, stride - 1, stride + 1, -stride, stride, -1, 1 })
+			{
+				const auto cell = id + offset;
+				const auto next = this->m_next[cell];
+				if (next != NO_CELL && !isSide(cell, next) && isSide(id, cell) && isSide(id, next))
+					Invalidate(cell);
+			}
+		}
+	}
+
+	// The edited cells and those around them may have cheaper moves now, the others take them from their neighbors
+	const auto invalidated = this->m_changed;
+	for (const auto id : this->m_edits)
+	{
+		Reseed<Conn>(id);
+		for (const auto offset : { -stride - 1, -stride, -stride + 1, -1, 1, stride - 1, stride, stride + 1 })
+			Reseed<Conn>(id + offset);
+	}
+	for (const auto id : invalidated)
+		Reseed<Conn>(id);
+
+	Propagate<Conn>();
+	this->m_updating = false;
+
+	// Only cells whose cost was recomputed may move differently
+	std::sort(this->m_changed.begin(), this->m_changed.end());
+	this->m_changed.erase(std::unique(this->m_changed.begin(), this->m_changed.end()), this->m_changed.end());
+	PointRange<Conn>(&this->m_changed, 0, this->m_changed.size());
+	return this->m_changed.size();
+}
+
+void FlowField::Invalidate(const int id)
+{
+	if (this->m_integration[id] == NO_INTEGRATION)
+		return;
+
+	const auto stride = this->m_grid->GetStride();
+	this->m_integration[id] = NO_INTEGRATION;
+	this->m_changed.push_back(id);
+
+	// The cells moving to a cell are among its eight surrounding ids, whatever the connectivity
+	auto &stack = this->m_current;
+	stack.assign(1, id);
+	while (!stack.empty())
+	{
+		const auto cell = stack.back();
+		stack.pop_back();
+
+		for (const auto offset : { -stride - 1, -stride, -stride + 1, -1, 1, stride - 1, stride, stride + 1 })
+		{
+			const auto from = cell + offset;
+			if (this->m_next[from] != cell || this->m_integration[from] == NO_INTEGRATION)
+				continue;
+
+			this->m_integration[from] = NO_INTEGRATION;
+			this->m_changed.push_back(from);
+			stack.push_back(from);
+		}
+	}
+}
+
+template <typename Conn>
+void FlowField::Reseed(const int id)
+{
+	if (id == this->m_goal || this->m_grid->IsWall(id))
+		return;
+
+	auto best = this->m_integration[id];
+	Conn::ForEach(this->m_grid, id, [&](const int next, const bool diagonal)
+	{
+		const auto cost = this->m_integration[next];
+		if (cost != NO_INTEGRATION)
+			best = std::min(best, cost + GetMoveCost(this->m_grid->GetCost(next), diagonal));
+		return true;
+	});
+
+	// Seeds may lie further apart than the ring is wide, Propagate queues each once the buckets reach its cost
+	if (best < this->m_integration[id])
+	{
+		this->m_integration[id] = best;
+		this->m_seeds.emplace_back(best, id);
+		this->m_changed.push_back(id);
+	}
+}
+
+template <typename Conn>
+void FlowField::Propagate()
+{
+	const auto threads = this->m_pool->GetThreadCount();
+	std::sort(this->m_seeds.begin(), this->m_seeds.end());
+	std::size_t seed = 0;
+	while (this->m_queued > 0 || seed < this->m_seeds.size())
+	{
+		// Queued cells cost at most one move more than the bucket, so only seeds at its cost may join the ring
+		if (this->m_queued == 0)
+			this->m_cost = this->m_seeds[seed].first;
+		for (; seed < this->m_seeds.size() && this->m_seeds[seed].first <= this->m_cost; seed++)
+		{
+			// Seeds lowered since were queued at their lower cost
+			if (this->m_integration[this->m_seeds[seed].second] == this->m_seeds[seed].first)
+				Push(this->m_seeds[seed].second, this->m_seeds[seed].first);
+		}
+
+		auto &bucket = this->m_buckets[this->m_cost % BucketCount];
+		const auto cost = this->m_cost++;
+		if (bucket.empty())
+			continue;
+
+		this->m_current.swap(bucket);
+		bucket.clear();
+		this->m_queued -= this->m_current.size();
+		for (auto &lowered : this->m_lowered)
+			lowered.clear();
+
+		const auto size = this->m_current.size();
+		if (threads == 1 || size < ParallelThreshold)
+		{
+			ExpandRange<Conn>(0, 0, size, cost, &this->m_stats);
+		}
+		else
+		{
+			const auto chunks = (size + ChunkSize - 1) / ChunkSize;
+			std::atomic<std::size_t> next(0);
+			std::atomic<std::uint64_t> expansions(0);
+			std::atomic<std::uint64_t> checks(0);
+			this->m_pool->Run([&](const int worker)
+			{
+				SearchStats stats;
+				for (auto chunk = next++; chunk < chunks; chunk = next++)
+					ExpandRange<Conn>(worker, chunk * ChunkSize, std::min(size, (chunk + 1) * ChunkSize), cost, &stats);
+				expansions.fetch_add(stats.expansions, std::memory_order_relaxed);
+				checks.fetch_add(stats.neighborChecks, std::memory_order_relaxed);
+			});
+			this->m_stats.expansions += expansions.load(std::memory_order_relaxed);
+			this->m_stats.neighborChecks += checks.load(std::memory_order_relaxed);
+		}
+
+		// Lowered cells join their buckets, a cell lowered twice is expanded at its lowest cost only
+		for (const auto &lowered : this->m_lowered)
+		{
+			for (const auto &cell : lowered)
+				Push(cell.first, cell.second);
+		}
+		this->m_stats.peakFrontier = std::max(this->m_stats.peakFrontier, this->m_queued);
+	}
+	this->m_seeds.clear();
+}
+
+template <typename Conn>
+void FlowField::ExpandRange(const int worker, const std::size_t begin, const std::size_t end, const int cost, SearchStats *stats)
+{
+	auto &lowered = this->m_lowered[worker];
+
+	for (auto i = begin; i < end; i++)
+	{
+		// Cells queued again at a lower cost were expanded then
+		const auto current = this->m_current[i];
+		if (LoadCost(&this->m_integration[current]) != cost)
+			continue;
+
+		stats->expansions++;
+		const auto terrain = this->m_grid->GetCost(current);
+		Conn::ForEach(this->m_grid, current, [&](const int next, const bool diagonal)
+		{
+			stats->neighborChecks++;
+			const auto candidate = cost + GetMoveCost(terrain, diagonal);
+			if (LowerCost(&this->m_integration[next], candidate))
+				lowered.emplace_back(next, candidate);
+			return true;
+		});
+	}
+}
+
+template <typename Conn>
+void FlowField::PointRange(const std::vector<int> *cells, const std::size_t begin, const std::size_t end)
+{
+	for (auto i = begin; i < end; i++)
+	{
+		const auto id = cells != nullptr ? (*cells)[i] : static_cast<int>(i);
+		if (id == this->m_goal || this->m_integration[id] == NO_INTEGRATION)
+		{
+			this->m_next[id] = NO_CELL;
+			continue;
+		}
+
+		// Ties go to the first neighbor in the policy's order
+		auto best = NO_INTEGRATION;
+		auto move = NO_CELL;
+		Conn::ForEach(this->m_grid, id, [&](const int next, const bool diagonal)
+		{
+			const auto cost = this->m_integration[next];
+			if (cost == NO_INTEGRATION)
+				return true;
+
+			const auto total = cost + GetMoveCost(this->m_grid->GetCost(next), diagonal);
+			if (total < best)
+			{
+				best = total;
+				move = next;
+			}
+			return true;
+		});
+		this->m_next[id] = move;
+	}
+}
+
+void FlowField::Push(const int id, const int cost)
+{
+	if (this->m_queued == 0 || cost < this->m_cost)
+		this->m_cost = cost;
+
+	this->m_buckets[cost % BucketCount].push_back(id);
+	this->m_queued++;
+	if (this->m_updating)
+		this->m_changed.push_back(id);
+}
@@ -1,9 +1,11 @@
 #include "Graph.h"
+#include "MapFile.h"
 #include <random>
 #include <array>
+#include <algorithm>
 
 Graph::Graph(QWidget *parent)
-	: QGraphicsView(parent), m_currentlyTraveling(false)
+	: QGraphicsView(parent), m_currentlyTraveling(false), m_replanning(false)
 {
 	this->m_currentTab = parent;
 
@@ -20,54 +22,80 @@ Graph::Graph(QWidget *parent)
 		{2000, 15},
 		{4500, 10},
 		{18000, 5},
+		{112500, 2},
+		{450000, 1},
+		{1800000, 0.5},
 	};
 
 	// Default values
 	this->m_cellSize = this->m_sizeList[0].second;
-	this->m_vertexDescThreshold = this->m_sizeList[2].second;
+	this->m_vertexDescThreshold = static_cast<int>(this->m_sizeList[2].second);
 
-	// Data structures which hold pointers to all the vertices
-	this->m_vertices = new VertexHashShapeList;
-	this->m_vertexIdList = new VertexHashIDList;
+	// Grid model holding the state of every cell
+	this->m_grid = new Grid();
+	this->m_components = new ComponentIndex(this->m_grid);
+	this->m_flowField = new FlowField(this->m_grid);
 
 	InitUI();
 	SetDefaultSelections();
 	Render();
 
 	// Initialize pathfinder
-	const auto cols = this->m_sceneWidth / this->m_cellSize;
-	const auto rows = this->m_sceneHeight / this->m_cellSize;
-	this->m_pathFinder = new PathFinder(this->m_vertexIdList, rows, cols);
-	connect(this->m_pathFinder, SIGNAL(DisplayGoal(Vertex*)), this, SLOT(DisplayResults(Vertex*)));
+	this->m_pathFinder = new PathFinder(this->m_grid);
+	this->m_pathFinder->SetComponentIndex(this->m_components);
+	connect(this->m_pathFinder, SIGNAL(CellVisited(int)), this, SLOT(VisitVertex(int)));
+	connect(this->m_pathFinder, SIGNAL(DisplayGoal(int)), this, SLOT(DisplayResults(int)));
+
+	// Cell changes are collected and shown at the display rate, never per cell
+	this->m_frameTimer = new QTimer(this);
+	connect(this->m_frameTimer, SIGNAL(timeout()), this, SLOT(PresentFrame()));
+	this->m_frameTimer->start(1000 / FRAME_RATE);
 }
 
 void Graph::mousePressEvent(QMouseEvent *me)
 {
-	// Do not process event during traversal
-	if (!m_currentlyTraveling)
-		return;
-
-	const auto current = itemAt(me->pos());
-
-    if (current == nullptr)
-        return;
-	
-    auto selected = this->m_vertices->value(current);
+	// Cell under the cursor from the scene coordinates; editing during a traversal is fine, the
+	// search runs on the version of the grid it started with
+	const auto selected = this->m_gridItem->GetCellAt(this->m_gridItem->mapFromScene(mapToScene(me->pos())));
 
-    if (selected == nullptr)
+    if (selected == NO_CELL)
         return;
 
-    // Set and unset walls at the clicked vertex
+    // Set and unset walls at the clicked cell
     if (me->button() == Qt::LeftButton)
     {
-        if (selected->IsWall())
+        SetWall(selected, !this->m_grid->IsWall(selected));
+        UpdateRegions();
+    }
+    // Cycle the terrain of an open cell: road, mud, water
+    else if (me->button() == Qt::RightButton && !this->m_grid->IsWall(selected))
+    {
+        const auto cost = this->m_grid->GetCost(selected);
+        if (cost < MUD_COST)
+        {
+            this->m_grid->SetCost(selected, MUD_COST);
+        }
+        else if (cost < WATER_COST)
         {
-            selected->UnsetWall();
+            this->m_grid->SetCost(selected, WATER_COST);
         }
         else
         {
-            selected->SetWall();
+            this->m_grid->SetCost(selected, DEFAULT_COST);
         }
+        this->m_gridItem->Refresh(selected);
+
+        // Cost edits aren't announced by the grid
+        this->m_flowField->UpdateCell(selected);
+        UpdateFlowField();
+    }
+
+    // Repair the path of a finished incremental search instead of searching again
+    if (this->m_pathFinder->CanReplan())
+    {
+        this->m_replanning = true;
+        this->m_pathFinder->Replan();
+        this->m_replanning = false;
     }
 }
 
@@ -80,6 +108,10 @@ void Graph::InitUI()
     setGeometry(0, 0, this->m_sceneWidth, this->m_sceneHeight);
     this->m_scene = new QGraphicsScene();
     setScene(this->m_scene);
+
+    // Every cell is drawn by one item
+    this->m_gridItem = new GridItem(this->m_grid, this->m_cellSize);
+    this->m_scene->addItem(this->m_gridItem);
     GraphLayout->addWidget(this, 0, 0, 3, 1, Qt::AlignLeft | Qt::AlignTop);
 
     // Spacers
@@ -102,8 +134,25 @@ void Graph::AddItemsToGroupBox(QGroupBox *groupBox)
     this->m_algorithmSelection = new QComboBox();
     this->m_algorithmSelection->addItem("Depth-First Search");
     this->m_algorithmSelection->addItem("Breadth-First Search");
+    this->m_algorithmSelection->addItem("Direction-Optimizing BFS");
+    this->m_algorithmSelection->addItem("Parallel BFS");
+    this->m_algorithmSelection->addItem("Bidirectional BFS");
+    this->m_algorithmSelection->addItem("Wavefront BFS");
+    this->m_algorithmSelection->addItem("Dijkstra");
+    this->m_algorithmSelection->addItem("A* Search");
+    this->m_algorithmSelection->addItem("Jump Point Search");
+    this->m_algorithmSelection->addItem("Incremental A* (LPA*)");
+    this->m_algorithmSelection->addItem("Hierarchical A* (HPA*)");
     controlLayout->addRow(algoDescription, this->m_algorithmSelection);
 
+    const auto movementDescription = new QLabel("Movement");
+    this->m_movementSelection = new QComboBox();
+    this->m_movementSelection->addItem("4-way", static_cast<int>(Connectivity::Four));
+    this->m_movementSelection->addItem("8-way", static_cast<int>(Connectivity::Eight));
+    this->m_movementSelection->addItem("8-way, no corner cutting", static_cast<int>(Connectivity::EightNoCornerCutting));
+    this->m_movementSelection->addItem("Hexagonal", static_cast<int>(Connectivity::Hex));
+    controlLayout->addRow(movementDescription, this->m_movementSelection);
+
     // Display the possible sizes of the Graph to user
     const auto GraphSizeDesc = new QLabel("Graph Size");
     this->m_sizeSelection = new QComboBox();
@@ -113,6 +162,34 @@ void Graph::AddItemsToGroupBox(QGroupBox *groupBox)
 	}
     controlLayout->addRow(GraphSizeDesc, this->m_sizeSelection);
 
+	// Generated maps, the same seed gives the same map
+	const auto layoutDescription = new QLabel("Map Layout");
+	this->m_layoutSelection = new QComboBox();
+	this->m_layoutSelection->addItem("Uniform noise", static_cast<int>(MapLayout::Uniform));
+	this->m_layoutSelection->addItem("Maze", static_cast<int>(MapLayout::Maze));
+	this->m_layoutSelection->addItem("Caves", static_cast<int>(MapLayout::Caves));
+	this->m_layoutSelection->addItem("Rooms and corridors", static_cast<int>(MapLayout::Rooms));
+	controlLayout->addRow(layoutDescription, this->m_layoutSelection);
+
+	const auto seedDescription = new QLabel("Next Seed");
+	this->m_seedSelection = new QSpinBox();
+	this->m_seedSelection->setRange(0, 999999);
+	this->m_seedSelection->setValue(1);
+	controlLayout->addRow(seedDescription, this->m_seedSelection);
+
+    const auto regionsDescription = new QLabel("Regions");
+    this->m_regionsLabel = new QLabel();
+    controlLayout->addRow(regionsDescription, this->m_regionsLabel);
+
+	// Arrows towards the goal from every cell, for units that share it
+	this->m_flowFieldCheck = new QCheckBox("Show Flow Field");
+	controlLayout->addRow(this->m_flowFieldCheck);
+
+	// Counters of the search, refreshed every frame while it runs
+	const auto statisticsDescription = new QLabel("Statistics");
+	this->m_statisticsLabel = new QLabel();
+	controlLayout->addRow(statisticsDescription, this->m_statisticsLabel);
+
     this->m_resetGraphButton = new QPushButton("Reset Graph");
     controlLayout->addRow(this->m_resetGraphButton);
 
@@ -122,6 +199,15 @@ void Graph::AddItemsToGroupBox(QGroupBox *groupBox)
 	this->m_randomizeGraphButton = new QPushButton("Randomize Graph");
 	controlLayout->addRow(this->m_randomizeGraphButton);
 
+	this->m_openMapButton = new QPushButton("Open Map");
+	controlLayout->addRow(this->m_openMapButton);
+
+	this->m_saveMapButton = new QPushButton("Save Map");
+	controlLayout->addRow(this->m_saveMapButton);
+
+	this->m_statisticsLogButton = new QPushButton("Log Statistics...");
+	controlLayout->addRow(this->m_statisticsLogButton);
+
     this->m_startTravelButton = new QPushButton("Start Traveling");
     controlLayout->addRow(this->m_startTravelButton);
 
@@ -131,17 +217,28 @@ void Graph::AddItemsToGroupBox(QGroupBox *groupBox)
 
     // Connect UI objects to slots
 	connect(this->m_sizeSelection, SIGNAL(activated(int)), this, SLOT(NewSize()));
+	connect(this->m_movementSelection, SIGNAL(activated(int)), this, SLOT(UpdateRegions()));
     connect(this->m_startTravelButton, SIGNAL(clicked()), this, SLOT(StartTraveling()));
     connect(this->m_stopTravelButton, SIGNAL(clicked()), this, SLOT(StopTraveling()));
     connect(this->m_resetGraphButton, SIGNAL(clicked()), this, SLOT(Reset()));
     connect(this->m_clearGraphButton, SIGNAL(clicked()), this, SLOT(Clear()));
 	connect(this->m_randomizeGraphButton, SIGNAL(clicked()), this, SLOT(Randomize()));
+	connect(this->m_openMapButton, SIGNAL(clicked()), this, SLOT(OpenMap()));
+	connect(this->m_saveMapButton, SIGNAL(clicked()), this, SLOT(SaveMap()));
+	connect(this->m_statisticsLogButton, SIGNAL(clicked()), this, SLOT(ChooseStatisticsLog()));
+	connect(this->m_flowFieldCheck, SIGNAL(toggled(bool)), this, SLOT(UpdateFlowField()));
 }
 
 void Graph::SetStartAndGoal() const
 {
-    this->m_vertexIdList->value(0)->SetStart(true);
-    this->m_vertexIdList->value(this->m_vertexIdList->size() - 1)->SetGoal(true);
+    const auto lastRow = this->m_grid->GetRows() - 1;
+    const auto lastCol = this->m_grid->GetCols() - 1;
+    if (this->m_grid->GetStart() == NO_CELL)
+        this->m_grid->SetStart(this->m_grid->GetId(0, 0));
+    if (this->m_grid->GetGoal() == NO_CELL)
+        this->m_grid->SetGoal(this->m_grid->GetId(lastRow, lastCol));
+    this->m_gridItem->Refresh(this->m_grid->GetStart());
+    this->m_gridItem->Refresh(this->m_grid->GetGoal());
 }
 
 void Graph::SetDefaultSelections()
@@ -154,17 +251,18 @@ void Graph::SetDefaultSelections()
     this->m_algorithmSelection->setCurrentIndex(1);
 }
 
-int Graph::TracePath(Vertex* lastVertex, QStack<int>* stack)
+int Graph::TracePath(const int lastVertex, QStack<int>* stack) const
 {
-	auto count = 0;
-	while (lastVertex != nullptr)
+	// The chain back to the start, stitched to the chain on to the goal for bidirectional searches
+	const auto path = this->m_pathFinder->GetPath(lastVertex);
+
+	// Push from the goal so the start ends up on top
+	for (auto vertex = path.rbegin(); vertex != path.rend(); ++vertex)
 	{
-		lastVertex->TracePath();
-		stack->push(lastVertex->GetId());
-		lastVertex = lastVertex->GetPrevious();
-		count++;
+		this->m_gridItem->SetPath(*vertex, true);
+		stack->push(this->m_grid->GetCellNumber(*vertex));
 	}
-	return count;
+	return static_cast<int>(path.size());
 }
 
 void Graph::UpdateUiState()
@@ -173,43 +271,44 @@ void Graph::UpdateUiState()
 	this->m_resetGraphButton->setEnabled(!this->m_resetGraphButton->isEnabled());
 	this->m_sizeSelection->setEnabled(!this->m_sizeSelection->isEnabled());
 	this->m_algorithmSelection->setEnabled(!this->m_algorithmSelection->isEnabled());
+	this->m_movementSelection->setEnabled(!this->m_movementSelection->isEnabled());
 	this->m_clearGraphButton->setEnabled(!this->m_clearGraphButton->isEnabled());
 	this->m_randomizeGraphButton->setEnabled(!this->m_randomizeGraphButton->isEnabled());
-	this->m_currentlyTraveling = !this->m_currentlyTraveling;
+	this->m_layoutSelection->setEnabled(!this->m_layoutSelection->isEnabled());
+	this->m_seedSelection->setEnabled(!this->m_seedSelection->isEnabled());
+	this->m_openMapButton->setEnabled(!this->m_openMapButton->isEnabled());
+	this->m_saveMapButton->setEnabled(!this->m_saveMapButton->isEnabled());
 }
 
 void Graph::Render() const
 {
-	const auto cols = this->m_sceneWidth / this->m_cellSize;
-	const auto rows = this->m_sceneHeight / this->m_cellSize;
-	auto i = 0;
-	auto j = 0;
-	auto idCount = 0;
-
-	// Traverse rows/cols
-	while (i < rows)
-	{
-		while (j < cols)
-		{
-			// Get a new vertex
-			auto vertex = new Vertex(idCount, j * this->m_cellSize, i * this->m_cellSize, this->m_cellSize);
-			this->m_scene->addItem(vertex->GetShape());
+	const auto cols = static_cast<int>(this->m_sceneWidth / this->m_cellSize);
+	const auto rows = static_cast<int>(this->m_sceneHeight / this->m_cellSize);
 
-			// Insert vertices into hash tables
-			this->m_vertices->insert(vertex->GetShape(), vertex);
-			this->m_vertexIdList->insert(idCount, vertex);
+	// Size the grid model, the item is a view of it
+	this->m_grid->Resize(rows, cols);
+	DisplayGrid();
+}
 
-			// Set vertex descriptions for the smaller sizes
-			if (this->m_cellSize > this->m_vertexDescThreshold)
-				vertex->SetDescription();
+void Graph::DisplayGrid() const
+{
+	this->m_gridItem->Reset(this->m_cellSize);
+	this->m_scene->setSceneRect(this->m_gridItem->boundingRect());
+
+	// Cell numbers for the smaller sizes
+	this->m_gridItem->SetShowNumbers(this->m_cellSize > this->m_vertexDescThreshold);
 
-			j++;
-			idCount++;
-		}
-		j = 0;
-		i++;
-	}
 	SetStartAndGoal();
+	UpdateRegions();
+}
+
+void Graph::SetWall(const int id, const bool wall) const
+{
+	if (id == this->m_grid->GetStart() || id == this->m_grid->GetGoal())
+		return;
+
+	wall ? this->m_grid->SetWall(id) : this->m_grid->UnsetWall(id);
+	this->m_gridItem->Refresh(id);
 }
 
 void Graph::NewSize()
@@ -218,13 +317,7 @@ void Graph::NewSize()
         return;
 
     this->m_cellSize = this->m_sizeList[this->m_sizeSelection->currentIndex()].second;
-    this->m_scene->clear();
-
-    for (auto &vertex : *this->m_vertices)
-        delete vertex;
-
-    this->m_vertices->clear();
-    this->m_vertexIdList->clear();
+    this->m_pathFinder->Release();
     Render();
     this->m_startTravelButton->setEnabled(true);
 }
@@ -237,10 +330,8 @@ void Graph::StartTraveling()
 	this->m_startTravelButton->setVisible(false);
 	this->m_stopTravelButton->setVisible(true);
 
-	const auto cols = this->m_sceneWidth / this->m_cellSize;
-	const auto rows = this->m_sceneHeight / this->m_cellSize;
-
-	this->m_pathFinder->Setup(this->m_vertexIdList, rows, cols);
+	const auto connectivity = static_cast<Connectivity>(this->m_movementSelection->currentData().toInt());
+	this->m_pathFinder->Setup(this->m_grid, connectivity);
 
 	if (this->m_algorithmSelection->currentText() == "Depth-First Search")
 	{
@@ -250,6 +341,42 @@ void Graph::StartTraveling()
 	{
 		this->m_pathFinder->StartBreadthFirstSearch();
 	}
+	else if (this->m_algorithmSelection->currentText() == "Direction-Optimizing BFS")
+	{
+		this->m_pathFinder->StartDirectionOptimizingSearch();
+	}
+	else if (this->m_algorithmSelection->currentText() == "Parallel BFS")
+	{
+		this->m_pathFinder->StartParallelSearch();
+	}
+	else if (this->m_algorithmSelection->currentText() == "Bidirectional BFS")
+	{
+		this->m_pathFinder->StartBidirectionalSearch();
+	}
+	else if (this->m_algorithmSelection->currentText() == "Wavefront BFS")
+	{
+		this->m_pathFinder->StartWavefrontSearch();
+	}
+	else if (this->m_algorithmSelection->currentText() == "Dijkstra")
+	{
+		this->m_pathFinder->StartDijkstraSearch();
+	}
+	else if (this->m_algorithmSelection->currentText() == "A* Search")
+	{
+		this->m_pathFinder->StartAStarSearch();
+	}
+	else if (this->m_algorithmSelection->currentText() == "Jump Point Search")
+	{
+		this->m_pathFinder->StartJumpPointSearch();
+	}
+	else if (this->m_algorithmSelection->currentText() == "Incremental A* (LPA*)")
+	{
+		this->m_pathFinder->StartIncrementalSearch();
+	}
+	else if (this->m_algorithmSelection->currentText() == "Hierarchical A* (HPA*)")
+	{
+		this->m_pathFinder->StartHierarchicalSearch();
+	}
 }
 
 void Graph::StopTraveling()
@@ -263,19 +390,9 @@ void Graph::StopTraveling()
 
 void Graph::Reset() const
 {
-    for (auto& vertex : *this->m_vertices)
-    {
-	    if (!vertex->IsWall())
-	    {
-			vertex->UnsetWall();
-			vertex->SetStart(false);
-			vertex->SetVisited(false);
-			vertex->SetGoal(false);
-
-			if (this->m_cellSize > this->m_vertexDescThreshold)
-				vertex->SetDescription();
-	    }
-    }
+	this->m_pathFinder->Release();
+	this->m_grid->ResetSearch();
+	this->m_gridItem->ClearMarks();
 
 	// Reset start/goal
 	SetStartAndGoal();
@@ -285,19 +402,15 @@ void Graph::Reset() const
 
 void Graph::Clear() const
 {
-    for (auto& vertex : *this->m_vertices)
-    {
-		vertex->UnsetWall();
-		vertex->SetStart(false);
-		vertex->SetVisited(false);
-		vertex->SetGoal(false);
-
-		if (this->m_cellSize > this->m_vertexDescThreshold)
-			vertex->SetDescription();
-    }
+	this->m_pathFinder->Release();
+	this->m_grid->ClearWalls();
+	this->m_grid->ClearCosts();
+	this->m_grid->ResetSearch();
+	this->m_gridItem->ClearMarks();
 
 	// Reset start/goal
 	SetStartAndGoal();
+	UpdateRegions();
 
 	this->m_startTravelButton->setEnabled(true);
 }
@@ -305,24 +418,200 @@ void Graph::Clear() const
 void Graph::Randomize() const
 {
 	Clear();
-	for (auto vertex : *this->m_vertices)
+
+	// Start and goal stay open, the generator writes every other wall at once
+	GeneratorOptions options;
+	options.layout = static_cast<MapLayout>(this->m_layoutSelection->currentData().toInt());
+	options.seed = static_cast<std::uint64_t>(this->m_seedSelection->value());
+	GenerateMap(this->m_grid, options);
+	this->m_seedSelection->setValue(this->m_seedSelection->value() + 1);
+
+	DisplayGrid();
+}
+
+void Graph::UpdateRegions() const
+{
+	// Regions depend on the movement, which may have changed since the last search
+	this->m_components->SetConnectivity(static_cast<Connectivity>(this->m_movementSelection->currentData().toInt()));
+
+	// Both are kept up to date by the edits, no cell is visited
+	const auto count = this->m_components->GetComponentCount();
+	this->m_regionsLabel->setText(QString::number(count)
+		+ (count == 0 ? QString() : ", largest " + QString::number(this->m_components->GetLargestComponentSize()) + " cells"));
+
+	// The flow field follows the same edits
+	UpdateFlowField();
+}
+
+void Graph::UpdateFlowField() const
+{
+	if (!this->m_flowFieldCheck->isChecked())
+	{
+		this->m_gridItem->SetFlowField(nullptr);
+		return;
+	}
+
+	// Only the cells around the edits since the last call are recomputed
+	this->m_flowField->SetConnectivity(static_cast<Connectivity>(this->m_movementSelection->currentData().toInt()));
+	this->m_flowField->SetGoal(this->m_grid->GetGoal());
+	this->m_flowField->Refresh();
+	this->m_gridItem->SetFlowField(this->m_flowField);
+}
+
+void Graph::OpenMap()
+{
+	const auto path = QFileDialog::getOpenFileName(this, "Open Map", QString(), "Maps (*.gridmap *.map);;All files (*)");
+	if (path.isEmpty())
+		return;
+
+	this->m_pathFinder->Release();
+	this->m_path.clear();
+
+	std::string error;
+	if (!LoadMap(path.toStdString(), this->m_grid, nullptr, &error))
+	{
+		QMessageBox::warning(this, "Open Map", QString::fromStdString(error));
+
+		// The grid may be half loaded, start over at the selected size
+		this->m_cellSize = this->m_sizeList[this->m_sizeSelection->currentIndex()].second;
+		Render();
+	}
+	else
 	{
-		if (!vertex->IsGoal() || !vertex->IsStart())
+		// Fit the whole map into the scene
+		this->m_cellSize = std::min(static_cast<qreal>(this->m_sceneWidth) / this->m_grid->GetCols(),
+			static_cast<qreal>(this->m_sceneHeight) / this->m_grid->GetRows());
+		DisplayGrid();
+	}
+	this->m_startTravelButton->setEnabled(true);
+}
+
+void Graph::SaveMap()
+{
+	const auto path = QFileDialog::getSaveFileName(this, "Save Map", QString(),
+		"Binary maps (*.gridmap);;MovingAI maps (*.map)");
+	if (path.isEmpty())
+		return;
+
+	std::string error;
+	const auto saved = path.endsWith(".map")
+		? ExportMovingAiMap(path.toStdString(), *this->m_grid, &error)
+		: ::SaveMap(path.toStdString(), *this->m_grid, std::string(), &error);
+	if (!saved)
+		QMessageBox::warning(this, "Save Map", QString::fromStdString(error));
+}
+
+void Graph::ChooseStatisticsLog()
+{
+	const auto path = QFileDialog::getSaveFileName(this, "Log Statistics", this->m_statisticsLog,
+		"JSON lines (*.jsonl);;CSV (*.csv)");
+	if (path.isEmpty())
+		return;
+
+	// Records are appended, an existing log keeps its history
+	this->m_statisticsLog = path;
+	this->m_statisticsLogButton->setToolTip("Appending to " + path);
+}
+
+QString Graph::DescribeSearch() const
+{
+	QString description;
+
+	// Report the direction each level of a direction-optimizing search ran in
+	const auto directionOptimizing = dynamic_cast<const DirectionOptimizingBase*>(this->m_pathFinder->GetEngine());
+	if (directionOptimizing != nullptr)
+	{
+		auto topDown = 0;
+		auto bottomUp = 0;
+		QString modes;
+		for (const auto &level : directionOptimizing->GetLevels())
 		{
-			const auto heuristic = rand() % 3; // Decides if it's a wall or not
-			if (heuristic >= 2)			
-				vertex->SetWall();			
+			const auto isTopDown = level.mode == LevelMode::TopDown;
+			isTopDown ? topDown++ : bottomUp++;
+			modes += isTopDown ? 'T' : 'B';
 		}
+		description += "\nLevels: " + QString::number(topDown) + " top-down, " + QString::number(bottomUp) + " bottom-up";
+
+#ifdef QT_DEBUG
+		description += "\nLevel modes: " + modes;
+#endif
 	}
+	return description;
+}
+
+void Graph::UpdateStatistics() const
+{
+	const auto &record = this->m_pathFinder->GetRecord();
+	if (record.engine.empty())
+		return;
+
+	const auto &stats = record.stats;
+	this->m_statisticsLabel->setText("Expanded " + QString::number(static_cast<qulonglong>(stats.expansions))
+		+ "\nNeighbor checks " + QString::number(static_cast<qulonglong>(stats.neighborChecks))
+		+ "\nDuplicate pushes " + QString::number(static_cast<qulonglong>(stats.duplicatePushes))
+		+ "\nPeak frontier " + QString::number(static_cast<qulonglong>(stats.peakFrontier))
+		+ "\nMemory " + QString::number(record.allocatedBytes / 1024.0, 'f', 1) + " KiB"
+		+ "\nSetup " + QString::number(record.setupNs / 1e6, 'f', 3) + " ms"
+		+ "\nSearch " + QString::number(record.searchNs / 1e6, 'f', 3) + " ms"
+		+ "\nPath " + QString::number(record.pathNs / 1e6, 'f', 3) + " ms"
+		+ "\n" + QString::number(record.GetNsPerExpansion(), 'f', 1) + " ns/expansion");
 }
 
-void Graph::DisplayResults(Vertex* vertex)
+void Graph::LogStatistics()
 {
+	if (this->m_statisticsLog.isEmpty())
+		return;
+
+	std::string error;
+	if (!AppendSearchRecord(this->m_statisticsLog.toStdString(), this->m_pathFinder->GetRecord(), &error))
+	{
+		// Stop logging instead of warning after every search
+		this->m_statisticsLog.clear();
+		this->m_statisticsLogButton->setToolTip(QString());
+		QMessageBox::warning(this, "Log Statistics", QString::fromStdString(error));
+	}
+}
+
+void Graph::PresentFrame() const
+{
+	this->m_gridItem->Flush();
+	if (this->m_currentlyTraveling)
+		UpdateStatistics();
+}
+
+void Graph::VisitVertex(const int id) const
+{
+	if (id != this->m_grid->GetStart() && id != this->m_grid->GetGoal())
+		this->m_gridItem->SetVisited(id, true);
+}
+
+void Graph::DisplayResults(const int goal)
+{
+	// A repaired path replaces the highlighted one without ending a search
+	if (this->m_replanning)
+	{
+		for (const auto id : this->m_path)
+			this->m_gridItem->SetPath(id, false);
+
+		this->m_path = this->m_pathFinder->GetPath(goal);
+		for (const auto id : this->m_path)
+			this->m_gridItem->SetPath(id, true);
+		UpdateStatistics();
+		LogStatistics();
+		return;
+	}
+	this->m_path = this->m_pathFinder->GetPath(goal);
+	UpdateStatistics();
+	LogStatistics();
+
 	// Trace the path
-	if (vertex != nullptr)
+	if (goal != NO_CELL)
 	{
 		const auto path = new QStack<int>();
-		const auto pathLength = TracePath(vertex, path);
+		const auto pathLength = TracePath(goal, path);
+
+		// Show the final frame before the message box takes over
+		this->m_gridItem->Flush();
 
 #ifdef QT_DEBUG
 		while (!path->isEmpty())
@@ -331,14 +620,18 @@ void Graph::DisplayResults(Vertex* vertex)
 		}
 		qDebug() << "Length of the path: " + QString::number(pathLength);
 		qDebug() << "Seconds elapsed: " + QString::number(m_pathFinder->GetElapsedTime() / 1000.0, 'f', 2);
+		qDebug() << DescribeSearch();
 #else
 		QMessageBox::information(this, "Path Length",
 			"Length of the path: " + QString::number(pathLength)
-			+ "\nSeconds elapsed: " + QString::number(m_pathFinder->GetElapsedTime() / 1000.0, 'f', 2));
+			+ "\nSeconds elapsed: " + QString::number(m_pathFinder->GetElapsedTime() / 1000.0, 'f', 2)
+			+ DescribeSearch());
 #endif
 	}
 	else
 	{
+		this->m_gridItem->Flush();
+
 #ifdef QT_DEBUG
 		qDebug() << "No path found!";
 #else
@@ -348,6 +641,7 @@ void Graph::DisplayResults(Vertex* vertex)
 
 	// Disable searching until Graph is reset
 	UpdateUiState();
+	this->m_currentlyTraveling = false;
 	this->m_startTravelButton->setEnabled(false);
 	this->m_startTravelButton->setVisible(true);
 	this->m_stopTravelButton->setVisible(false);
@@ -0,0 +1,239 @@
+#include "Grid.h"
+
+#include <algorithm>
+
+Grid::Grid(const int rows, const int cols)
+	: m_rows(0)
+	, m_cols(0)
+	, m_stride(2)
+	, m_start(NO_CELL)
+	, m_goal(NO_CELL)
+	, m_weightedCells(0)
+{
+	Resize(rows, cols);
+}
+
+void Grid::Resize(const int rows, const int cols)
+{
+	this->m_rows = rows;
+	this->m_cols = cols;
+	this->m_stride = cols + 2;
+	this->m_start = NO_CELL;
+	this->m_goal = NO_CELL;
+
+	const auto cells = static_cast<size_t>(GetCapacity());
+	const auto words = (cells + 63) / 64;
+
+	this->m_walls.assign(words, 0);
+	this->m_visited.assign(words, 0);
+	this->m_costs.assign(cells, DEFAULT_COST);
+	this->m_weightedCells = 0;
+	this->m_previous.assign(cells, NO_CELL);
+	this->m_distance.assign(cells, NO_DISTANCE);
+	this->m_visitedFromGoal.clear();
+	this->m_next.clear();
+	SetBorder();
+
+	for (const auto observer : this->m_observers.observers)
+		observer->OnGridReset();
+}
+
+void Grid::SetWall(const int id)
+{
+	if (id == this->m_start || id == this->m_goal || IsWall(id))
+		return;
+
+	this->m_walls[id >> 6] |= GridWord(1) << (id & 63);
+
+	for (const auto observer : this->m_observers.observers)
+		observer->OnWallChanged(id, true);
+}
+
+void Grid::UnsetWall(const int id)
+{
+	if (!IsWall(id))
+		return;
+
+	this->m_walls[id >> 6] &= ~(GridWord(1) << (id & 63));
+
+	for (const auto observer : this->m_observers.observers)
+		observer->OnWallChanged(id, false);
+}
+
+void Grid::ClearWalls()
+{
+	std::fill(this->m_walls.begin(), this->m_walls.end(), 0);
+	SetBorder();
+
+	for (const auto observer : this->m_observers.observers)
+		observer->OnGridReset();
+}
+
+void Grid::SetWallWords(const GridWord *words)
+{
+	std::copy(words, words + this->m_walls.size(), this->m_walls.begin());
+
+	// Bits past the last id stay clear, the bitset scans rely on it
+	const auto capacity = GetCapacity();
+	if ((capacity & 63) != 0)
+		this->m_walls.back() &= (GridWord(1) << (capacity & 63)) - 1;
+	SetBorder();
+
+	for (const auto id : { this->m_start, this->m_goal })
+	{
+		if (id != NO_CELL)
+			this->m_walls[id >> 6] &= ~(GridWord(1) << (id & 63));
+	}
+
+	for (const auto observer : this->m_observers.observers)
+		observer->OnGridReset();
+}
+
+void Grid::CopyWallWords(const int first, const int count, const GridWord *words)
+{
+	for (auto index = 0; index < count; index++)
+	{
+		auto word = words[index];
+		const auto base = (first + index) << 6;
+		for (const auto id : { this->m_start, this->m_goal })
+		{
+			if (id >= base && id < base + 64)
+				word &= ~(GridWord(1) << (id - base));
+		}
+
+		auto changed = this->m_walls[first + index] ^ word;
+		this->m_walls[first + index] = word;
+
+		for (; changed != 0; changed &= changed - 1)
+		{
+			const auto id = base + LowestBit(changed);
+			for (const auto observer : this->m_observers.observers)
+				observer->OnWallChanged(id, (word >> (id - base)) & 1);
+		}
+	}
+}
+
+void Grid::AddObserver(GridObserver *observer)
+{
+	this->m_observers.observers.push_back(observer);
+}
+
+void Grid::RemoveObserver(GridObserver *observer)
+{
+	auto &observers = this->m_observers.observers;
+	observers.erase(std::remove(observers.begin(), observers.end(), observer), observers.end());
+}
+
+void Grid::SetCost(const int id, const CellCost cost)
+{
+	const auto clamped = cost < 1 ? CellCost(1) : cost;
+	this->m_weightedCells += (clamped != DEFAULT_COST) - (this->m_costs[id] != DEFAULT_COST);
+	this->m_costs[id] = clamped;
+}
+
+void Grid::SetCosts(const CellCost *costs)
+{
+	for (auto row = 0; row < this->m_rows; row++)
+	{
+		for (auto col = 0; col < this->m_cols; col++)
+			SetCost(GetId(row, col), costs[row * this->m_cols + col]);
+	}
+}
+
+void Grid::SetCostData(const CellCost *costs)
+{
+	this->m_weightedCells = 0;
+	for (std::size_t id = 0; id < this->m_costs.size(); id++)
+	{
+		this->m_costs[id] = costs[id] < 1 ? CellCost(1) : costs[id];
+		this->m_weightedCells += this->m_costs[id] != DEFAULT_COST;
+	}
+}
+
+void Grid::CopyCostData(const int first, const int count, const CellCost *costs)
+{
+	for (auto id = first; id < first + count; id++)
+	{
+		const auto cost = costs[id - first] < 1 ? CellCost(1) : costs[id - first];
+		this->m_weightedCells += (cost != DEFAULT_COST) - (this->m_costs[id] != DEFAULT_COST);
+		this->m_costs[id] = cost;
+	}
+}
+
+void Grid::ClearCosts()
+{
+	std::fill(this->m_costs.begin(), this->m_costs.end(), DEFAULT_COST);
+	this->m_weightedCells = 0;
+}
+
+void Grid::SetStart(const int id)
+{
+	this->m_start = id;
+	if (id != NO_CELL)
+		UnsetWall(id);
+}
+
+void Grid::SetGoal(const int id)
+{
+	this->m_goal = id;
+	if (id != NO_CELL)
+		UnsetWall(id);
+}
+
+void Grid::SetBorder()
+{
+	const auto last = GetCapacity() - this->m_stride;
+
+	// Top and bottom rows
+	for (auto id = 0; id < this->m_stride; id++)
+	{
+		this->m_walls[id >> 6] |= GridWord(1) << (id & 63);
+		this->m_walls[(last + id) >> 6] |= GridWord(1) << ((last + id) & 63);
+	}
+
+	// Left and right columns
+	for (auto id = this->m_stride; id < last; id += this->m_stride)
+	{
+		const auto right = id + this->m_stride - 1;
+		this->m_walls[id >> 6] |= GridWord(1) << (id & 63);
+		this->m_walls[right >> 6] |= GridWord(1) << (right & 63);
+	}
+}
+
+void Grid::ResetSearch()
+{
+	std::fill(this->m_visited.begin(), this->m_visited.end(), 0);
+	std::fill(this->m_previous.begin(), this->m_previous.end(), NO_CELL);
+	std::fill(this->m_distance.begin(), this->m_distance.end(), NO_DISTANCE);
+	std::fill(this->m_visitedFromGoal.begin(), this->m_visitedFromGoal.end(), 0);
+	std::fill(this->m_next.begin(), this->m_next.end(), NO_CELL);
+}
+
+std::size_t Grid::GetSearchStateBytes() const
+{
+	return (this->m_visited.capacity() + this->m_visitedFromGoal.capacity()) * sizeof(GridWord)
+		+ (this->m_previous.capacity() + this->m_distance.capacity() + this->m_next.capacity()) * sizeof(int);
+}
+
+void Grid::PrepareBackwardSearch()
+{
+	this->m_visitedFromGoal.assign(this->m_visited.size(), 0);
+	this->m_next.assign(this->m_previous.size(), NO_CELL);
+}
+
+std::vector<int> Grid::GetPath(const int last) const
+{
+	std::vector<int> path;
+	if (last == NO_CELL)
+		return path;
+
+	// Back to the start
+	for (auto id = last; id != NO_CELL; id = GetPrevious(id))
+		path.push_back(id);
+	std::reverse(path.begin(), path.end());
+
+	// On to the goal
+	for (auto id = GetNext(last); id != NO_CELL; id = GetNext(id))
+		path.push_back(id);
+	return path;
+}
@@ -0,0 +1,282 @@
+#include "GridItem.h"
+
+#include <QVector>
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	// Smallest cells that still get a border
+	const qreal MinBorderSize = 4;
+
+	// Space between a cell's corner and its number
+	const qreal NumberMargin = 4;
+
+	// Smallest cells that still get a flow arrow
+	const qreal MinArrowSize = 8;
+
+	// Share of the way to the next cell's center an arrow covers, and the size of its head
+	const qreal ArrowLength = 0.7;
+	const qreal ArrowHead = 0.2;
+
+	// Share of the cells past which a frame recolors the whole image
+	const std::size_t FullRefreshDivisor = 8;
+}
+
+GridItem::GridItem(Grid *grid, const qreal cellSize)
+	: m_grid(grid)
+	, m_cellSize(cellSize)
+	, m_showNumbers(false)
+	, m_flowField(nullptr)
+{
+	// Paint only the exposed cells
+	setFlag(QGraphicsItem::ItemUsesExtendedStyleOption);
+	Reset(cellSize);
+}
+
+void GridItem::Reset(const qreal cellSize)
+{
+	prepareGeometryChange();
+	this->m_cellSize = cellSize;
+
+	// The buffers keep their capacity, only a larger grid allocates
+	const auto rows = this->m_grid->GetRows();
+	const auto cols = this->m_grid->GetCols();
+	this->m_pixels.resize(static_cast<std::size_t>(rows) * cols);
+	this->m_image = QImage(reinterpret_cast<uchar*>(this->m_pixels.data()), cols, rows,
+		cols * static_cast<int>(sizeof(QRgb)), QImage::Format_RGB32);
+
+	this->m_marks.assign(this->m_grid->GetCapacity(), 0);
+	this->m_marked.clear();
+	RefreshAll();
+}
+
+qreal GridItem::GetCellSize() const
+{
+	return this->m_cellSize;
+}
+
+int GridItem::GetCellAt(const QPointF &point) const
+{
+	const auto row = static_cast<int>(std::floor(point.y() / this->m_cellSize));
+	const auto col = static_cast<int>(std::floor(point.x() / this->m_cellSize));
+	if (row < 0 || col < 0 || row >= this->m_grid->GetRows() || col >= this->m_grid->GetCols())
+		return NO_CELL;
+	return this->m_grid->GetId(row, col);
+}
+
+void GridItem::SetVisited(const int id, const bool visited)
+{
+	SetMark(id, VisitedMark, visited);
+}
+
+void GridItem::SetPath(const int id, const bool path)
+{
+	SetMark(id, PathMark, path);
+}
+
+void GridItem::ClearMarks()
+{
+	// Only marked cells change, the frame recolors them or the whole image if there are many
+	for (const auto id : this->m_marked)
+	{
+		this->m_marks[id] &= PendingMark;
+		Refresh(id);
+	}
+	this->m_marked.clear();
+}
+
+void GridItem::Refresh(const int id)
+{
+	if (this->m_marks[id] & PendingMark)
+		return;
+
+	this->m_marks[id] |= PendingMark;
+	this->m_changes.push_back(id);
+	this->m_dirty = this->m_dirty.united(QRect(this->m_grid->GetCol(id), this->m_grid->GetRow(id), 1, 1));
+}
+
+void GridItem::Flush()
+{
+	if (this->m_changes.empty())
+		return;
+
+	// Past a share of the cells one pass over the image is cheaper than the scattered pixels
+	if (this->m_changes.size() > this->m_pixels.size() / FullRefreshDivisor)
+	{
+		for (const auto id : this->m_changes)
+			this->m_marks[id] &= ~PendingMark;
+		RefreshAll();
+		return;
+	}
+
+	const auto cols = this->m_grid->GetCols();
+	for (const auto id : this->m_changes)
+	{
+		this->m_marks[id] &= ~PendingMark;
+		this->m_pixels[this->m_grid->GetRow(id) * cols + this->m_grid->GetCol(id)] = GetColor(id);
+	}
+
+	const auto size = this->m_cellSize;
+	update(QRectF(this->m_dirty.left() * size, this->m_dirty.top() * size, this->m_dirty.width() * size, this->m_dirty.height() * size));
+	this->m_changes.clear();
+	this->m_dirty = QRect();
+}
+
+void GridItem::SetShowNumbers(const bool show)
+{
+	if (show == this->m_showNumbers)
+		return;
+
+	this->m_showNumbers = show;
+	update();
+}
+
+void GridItem::SetFlowField(const FlowField *field)
+{
+	this->m_flowField = field;
+	update();
+}
+
+QRectF GridItem::boundingRect() const
+{
+	return QRectF(0, 0, this->m_grid->GetCols() * this->m_cellSize, this->m_grid->GetRows() * this->m_cellSize);
+}
+
+void GridItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *)
+{
+	const auto exposed = option->exposedRect.intersected(boundingRect());
+	if (exposed.isEmpty())
+		return;
+
+	// Cells touched by the exposed rectangle
+	const auto size = this->m_cellSize;
+	const auto firstRow = std::max(0, static_cast<int>(std::floor(exposed.top() / size)));
+	const auto firstCol = std::max(0, static_cast<int>(std::floor(exposed.left() / size)));
+	const auto lastRow = std::min(this->m_grid->GetRows() - 1, static_cast<int>(std::ceil(exposed.bottom() / size)) - 1);
+	const auto lastCol = std::min(this->m_grid->GetCols() - 1, static_cast<int>(std::ceil(exposed.right() / size)) - 1);
+	if (lastRow < firstRow || lastCol < firstCol)
+		return;
+
+	const QRect source(firstCol, firstRow, lastCol - firstCol + 1, lastRow - firstRow + 1);
+	const QRectF target(firstCol * size, firstRow * size, source.width() * size, source.height() * size);
+	painter->drawImage(target, this->m_image, source);
+
+	// Borders once cells are large enough to tell apart
+	if (size >= MinBorderSize)
+	{
+		QVector<QLineF> lines;
+		for (auto row = firstRow; row <= lastRow + 1; row++)
+			lines.append(QLineF(target.left(), row * size, target.right(), row * size));
+		for (auto col = firstCol; col <= lastCol + 1; col++)
+			lines.append(QLineF(col * size, target.top(), col * size, target.bottom()));
+
+		painter->setPen(QPen(Qt::black, 0));
+		painter->drawLines(lines);
+	}
+
+	// Every cell's move towards the goal, a shaft and two strokes of the head
+	if (this->m_flowField != nullptr && size >= MinArrowSize)
+	{
+		QVector<QLineF> arrows;
+		for (auto row = firstRow; row <= lastRow; row++)
+		{
+			for (auto col = firstCol; col <= lastCol; col++)
+			{
+				const auto id = this->m_grid->GetId(row, col);
+				const auto next = this->m_flowField->GetNext(id);
+				if (next == NO_CELL)
+					continue;
+
+				const auto from = GetCellRect(id).center();
+				const auto to = GetCellRect(next).center();
+				const auto dx = (to.x() - from.x()) * ArrowLength / 2;
+				const auto dy = (to.y() - from.y()) * ArrowLength / 2;
+				const auto tipX = from.x() + dx;
+				const auto tipY = from.y() + dy;
+				const auto headX = (dx + dy) * ArrowHead * 2;
+				const auto headY = (dy - dx) * ArrowHead * 2;
+
+				arrows.append(QLineF(from.x() - dx, from.y() - dy, tipX, tipY));
+				arrows.append(QLineF(tipX, tipY, tipX - headX, tipY - headY));
+				arrows.append(QLineF(tipX, tipY, tipX + headY, tipY - headX));
+			}
+		}
+
+		painter->setPen(QPen(Qt::darkGray, 0));
+		painter->drawLines(arrows);
+	}
+
+	if (!this->m_showNumbers)
+		return;
+
+	for (auto row = firstRow; row <= lastRow; row++)
+	{
+		for (auto col = firstCol; col <= lastCol; col++)
+		{
+			const auto id = this->m_grid->GetId(row, col);
+			painter->drawText(GetCellRect(id).adjusted(NumberMargin, NumberMargin, 0, 0), Qt::AlignLeft | Qt::AlignTop,
+				QString::number(this->m_grid->GetCellNumber(id)));
+		}
+	}
+}
+
+void GridItem::SetMark(const int id, const std::uint8_t mark, const bool set)
+{
+	const auto marks = set ? this->m_marks[id] | mark : this->m_marks[id] & ~mark;
+	if (marks == this->m_marks[id])
+		return;
+
+	this->m_marks[id] = static_cast<std::uint8_t>(marks);
+	if (set && !(marks & ListedMark))
+	{
+		this->m_marks[id] |= ListedMark;
+		this->m_marked.push_back(id);
+	}
+	Refresh(id);
+}
+
+QRgb GridItem::GetColor(const int id) const
+{
+	if (id == this->m_grid->GetStart())
+		return QColor(Qt::green).rgb();
+	if (id == this->m_grid->GetGoal())
+		return QColor(Qt::red).rgb();
+	if (this->m_grid->IsWall(id))
+		return QColor(Qt::gray).rgb();
+	if (this->m_marks[id] & PathMark)
+		return QColor(Qt::yellow).rgb();
+	if (this->m_marks[id] & VisitedMark)
+		return qRgb(135, 206, 250); // Sky blue
+
+	// Darker for costlier terrain
+	const auto cost = this->m_grid->GetCost(id);
+	if (cost >= WATER_COST)
+		return qRgb(100, 149, 237); // Cornflower blue
+	if (cost >= MUD_COST)
+		return qRgb(205, 170, 125); // Light brown
+	return QColor(Qt::white).rgb();
+}
+
+QRectF GridItem::GetCellRect(const int id) const
+{
+	const auto size = this->m_cellSize;
+	return QRectF(this->m_grid->GetCol(id) * size, this->m_grid->GetRow(id) * size, size, size);
+}
+
+void GridItem::RefreshAll()
+{
+	// Every pending change is covered
+	this->m_changes.clear();
+	this->m_dirty = QRect();
+
+	const auto cols = this->m_grid->GetCols();
+	for (auto row = 0; row < this->m_grid->GetRows(); row++)
+	{
+		const auto line = this->m_pixels.data() + static_cast<std::size_t>(row) * cols;
+		for (auto col = 0; col < cols; col++)
+			line[col] = GetColor(this->m_grid->GetId(row, col));
+	}
+	update();
+}
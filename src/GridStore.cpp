@@ -0,0 +1,416 @@
+#include "GridStore.h"
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <thread>
+
+namespace
+{
+	// Number of tiles covering the ids of a map
+	int GetTileCount(const int capacity)
+	{
+		return (capacity + SNAPSHOT_TILE_CELLS - 1) / SNAPSHOT_TILE_CELLS;
+	}
+
+	// Number of wall words from the first that exist in a grid
+	int GetTileWords(const Grid &grid, const int first)
+	{
+		return std::min(SNAPSHOT_TILE_WORDS, grid.GetWordCount() - first);
+	}
+
+	// Number of ids from the first that exist in a grid
+	int GetTileCells(const Grid &grid, const int first)
+	{
+		return std::min(SNAPSHOT_TILE_CELLS, grid.GetCapacity() - first);
+	}
+
+	// Checks if a tile holds the walls and costs the grid has over its range
+	bool MatchesGrid(const SnapshotTile &tile, const Grid &grid, const int index)
+	{
+		const auto firstWord = index * SNAPSHOT_TILE_WORDS;
+		const auto firstCell = index * SNAPSHOT_TILE_CELLS;
+		return std::memcmp(tile.walls.data(), grid.GetWallWords() + firstWord, GetTileWords(grid, firstWord) * sizeof(GridWord)) == 0
+			&& std::memcmp(tile.costs.data(), grid.GetCostData() + firstCell, GetTileCells(grid, firstCell) * sizeof(CellCost)) == 0;
+	}
+
+	// Copies the walls and costs of the grid over the tile's range
+	void CopyFromGrid(SnapshotTile *tile, const Grid &grid, const int index)
+	{
+		const auto firstWord = index * SNAPSHOT_TILE_WORDS;
+		const auto firstCell = index * SNAPSHOT_TILE_CELLS;
+		std::copy_n(grid.GetWallWords() + firstWord, GetTileWords(grid, firstWord), tile->walls.begin());
+		std::copy_n(grid.GetCostData() + firstCell, GetTileCells(grid, firstCell), tile->costs.begin());
+	}
+}
+
+GridSnapshot::GridSnapshot(const GridStore *store, const int slot, const GridVersion *version)
+	: m_store(store)
+	, m_slot(slot)
+	, m_version(version)
+{
+}
+
+GridSnapshot::GridSnapshot(GridSnapshot &&other) noexcept
+	: m_store(other.m_store)
+	, m_slot(other.m_slot)
+	, m_version(other.m_version)
+{
+	other.m_store = nullptr;
+	other.m_version = nullptr;
+}
+
+GridSnapshot &GridSnapshot::operator=(GridSnapshot &&other) noexcept
+{
+	if (this != &other)
+	{
+		Release();
+		this->m_store = other.m_store;
+		this->m_slot = other.m_slot;
+		this->m_version = other.m_version;
+		other.m_store = nullptr;
+		other.m_version = nullptr;
+	}
+	return *this;
+}
+
+GridSnapshot::~GridSnapshot()
+{
+	Release();
+}
+
+void GridSnapshot::Release()
+{
+	if (this->m_store != nullptr)
+		this->m_store->Release(this->m_slot);
+	this->m_store = nullptr;
+	this->m_version = nullptr;
+}
+
+std::uint64_t GridSnapshot::GetVersion() const
+{
+	return this->m_version->number;
+}
+
+int GridSnapshot::GetRows() const
+{
+	return this->m_version->rows;
+}
+
+int GridSnapshot::GetCols() const
+{
+	return this->m_version->cols;
+}
+
+int GridSnapshot::GetId(const int row, const int col) const
+{
+	return (row + 1) * (this->m_version->cols + 2) + col + 1;
+}
+
+int GridSnapshot::GetTileCount() const
+{
+	return static_cast<int>(this->m_version->tiles.size());
+}
+
+const SnapshotTile &GridSnapshot::GetTile(const int index) const
+{
+	return *this->m_version->tiles[index];
+}
+
+GridStore::GridStore(const Grid &grid)
+	: m_current(nullptr)
+	, m_number(0)
+	, m_nextSerial(1)
+{
+	Assign(grid);
+	Publish();
+}
+
+GridStore::~GridStore()
+{
+	// Every snapshot has to be released by now
+	delete this->m_current.load();
+	for (const auto version : this->m_retired)
+		delete version;
+}
+
+void GridStore::Assign(const Grid &grid)
+{
+	std::lock_guard<std::mutex> lock(this->m_writeMutex);
+
+	const auto current = this->m_current.load();
+	const auto tileCount = GetTileCount(grid.GetCapacity());
+
+	// Other dimensions share nothing with the current version
+	if (current == nullptr || current->rows != grid.GetRows() || current->cols != grid.GetCols())
+	{
+		this->m_draft.reset(new GridVersion());
+		this->m_draft->rows = grid.GetRows();
+		this->m_draft->cols = grid.GetCols();
+		this->m_draftTiles.assign(tileCount, nullptr);
+
+		for (auto index = 0; index < tileCount; index++)
+		{
+			auto tile = CreateTile();
+			CopyFromGrid(tile.get(), grid, index);
+			this->m_draftTiles[index] = tile;
+			this->m_draft->tiles.push_back(tile);
+		}
+		return;
+	}
+
+	BeginDraft();
+	for (auto index = 0; index < tileCount; index++)
+	{
+		if (!MatchesGrid(*this->m_draft->tiles[index], grid, index))
+			CopyFromGrid(GetDraftTile(index), grid, index);
+	}
+}
+
+bool GridStore::SetWall(const int row, const int col, const bool wall)
+{
+	std::lock_guard<std::mutex> lock(this->m_writeMutex);
+	BeginDraft();
+
+	if (row < 0 || row >= this->m_draft->rows || col < 0 || col >= this->m_draft->cols)
+		return false;
+
+	const auto id = (row + 1) * (this->m_draft->cols + 2) + col + 1;
+	const auto offset = id % SNAPSHOT_TILE_CELLS;
+	const auto bit = GridWord(1) << (offset & 63);
+
+	// Unchanged cells don't copy their tile
+	const auto &shared = *this->m_draft->tiles[id / SNAPSHOT_TILE_CELLS];
+	if (((shared.walls[offset >> 6] & bit) != 0) == wall)
+		return true;
+
+	auto tile = GetDraftTile(id / SNAPSHOT_TILE_CELLS);
+	if (wall)
+		tile->walls[offset >> 6] |= bit;
+	else
+		tile->walls[offset >> 6] &= ~bit;
+	return true;
+}
+
+bool GridStore::SetCost(const int row, const int col, const CellCost cost)
+{
+	std::lock_guard<std::mutex> lock(this->m_writeMutex);
+	BeginDraft();
+
+	if (row < 0 || row >= this->m_draft->rows || col < 0 || col >= this->m_draft->cols)
+		return false;
+
+	const auto id = (row + 1) * (this->m_draft->cols + 2) + col + 1;
+	const auto clamped = cost < 1 ? CellCost(1) : cost;
+	if (this->m_draft->tiles[id / SNAPSHOT_TILE_CELLS]->costs[id % SNAPSHOT_TILE_CELLS] != clamped)
+		GetDraftTile(id / SNAPSHOT_TILE_CELLS)->costs[id % SNAPSHOT_TILE_CELLS] = clamped;
+	return true;
+}
+
+std::uint64_t GridStore::Publish()
+{
+	std::lock_guard<std::mutex> lock(this->m_writeMutex);
+
+	const auto current = this->m_current.load();
+	const auto changed = std::any_of(this->m_draftTiles.begin(), this->m_draftTiles.end(),
+		[](const std::shared_ptr<SnapshotTile> &tile) { return tile != nullptr; });
+
+	if (this->m_draft != nullptr && changed)
+	{
+		this->m_draft->number = current == nullptr ? 1 : current->number + 1;
+		const auto number = this->m_draft->number;
+
+		// Readers see the whole version or none of it
+		this->m_current.store(this->m_draft.release());
+		this->m_number.store(number);
+		if (current != nullptr)
+			this->m_retired.push_back(current);
+		this->m_draftTiles.clear();
+
+		ReclaimRetired();
+		return number;
+	}
+
+	this->m_draft.reset();
+	this->m_draftTiles.clear();
+	ReclaimRetired();
+	return current->number;
+}
+
+void GridStore::Reclaim()
+{
+	std::lock_guard<std::mutex> lock(this->m_writeMutex);
+	ReclaimRetired();
+}
+
+GridSnapshot GridStore::Pin() const
+{
+	// Threads start their scan at different slots so they rarely contend
+	const auto first = std::hash<std::thread::id>()(std::this_thread::get_id()) % SNAPSHOT_READERS;
+
+	for (;;)
+	{
+		for (std::size_t probe = 0; probe < SNAPSHOT_READERS; probe++)
+		{
+			const auto slot = static_cast<int>((first + probe) % SNAPSHOT_READERS);
+			auto &reader = this->m_readers[slot].version;
+			if (reader.load(std::memory_order_relaxed) != nullptr)
+				continue;
+
+			auto version = this->m_current.load();
+			const GridVersion *expected = nullptr;
+			if (!reader.compare_exchange_strong(expected, version))
+				continue;
+
+			// The version may have been replaced and freed before the slot was set, only a still current one is safe
+			for (;;)
+			{
+				const auto current = this->m_current.load();
+				if (current == version)
+					return GridSnapshot(this, slot, version);
+				version = current;
+				reader.store(version);
+			}
+		}
+		std::this_thread::yield();
+	}
+}
+
+std::uint64_t GridStore::GetVersion() const
+{
+	return this->m_number.load();
+}
+
+std::size_t GridStore::GetLiveVersionCount() const
+{
+	std::lock_guard<std::mutex> lock(this->m_writeMutex);
+	return this->m_retired.size() + 1;
+}
+
+void GridStore::BeginDraft()
+{
+	if (this->m_draft != nullptr)
+		return;
+
+	this->m_draft.reset(new GridVersion(*this->m_current.load()));
+	this->m_draftTiles.assign(this->m_draft->tiles.size(), nullptr);
+}
+
+SnapshotTile *GridStore::GetDraftTile(const int index)
+{
+	auto &owned = this->m_draftTiles[index];
+	if (owned == nullptr)
+	{
+		owned = CreateTile();
+		const auto serial = owned->serial;
+		*owned = *this->m_draft->tiles[index];
+		owned->serial = serial;
+		this->m_draft->tiles[index] = owned;
+	}
+	return owned.get();
+}
+
+std::shared_ptr<SnapshotTile> GridStore::CreateTile()
+{
+	auto tile = std::make_shared<SnapshotTile>();
+	tile->serial = this->m_nextSerial++;
+	tile->walls.fill(0);
+	tile->costs.fill(DEFAULT_COST);
+	return tile;
+}
+
+void GridStore::ReclaimRetired()
+{
+	auto kept = this->m_retired.begin();
+	for (const auto version : this->m_retired)
+	{
+		const auto pinned = std::any_of(this->m_readers.begin(), this->m_readers.end(),
+			[version](const ReaderSlot &reader) { return reader.version.load() == version; });
+
+		if (pinned)
+			*kept++ = version;
+		else
+			delete version;
+	}
+	this->m_retired.erase(kept, this->m_retired.end());
+}
+
+void GridStore::Release(const int slot) const
+{
+	this->m_readers[slot].version.store(nullptr);
+}
+
+GridReplica::GridReplica()
+	: m_version(0)
+{
+}
+
+void GridReplica::Load(const GridSnapshot &snapshot, std::vector<int> *changed)
+{
+	const auto tileCount = snapshot.GetTileCount();
+
+	// New dimensions load everything at once, observers see a single reset
+	if (snapshot.GetRows() != this->m_grid.GetRows() || snapshot.GetCols() != this->m_grid.GetCols()
+		|| static_cast<int>(this->m_serials.size()) != tileCount)
+	{
+		this->m_grid.Resize(snapshot.GetRows(), snapshot.GetCols());
+
+		std::vector<GridWord> words(this->m_grid.GetWordCount());
+		std::vector<CellCost> costs(this->m_grid.GetCapacity());
+		this->m_serials.resize(tileCount);
+
+		for (auto index = 0; index < tileCount; index++)
+		{
+			const auto &tile = snapshot.GetTile(index);
+			const auto firstWord = index * SNAPSHOT_TILE_WORDS;
+			const auto firstCell = index * SNAPSHOT_TILE_CELLS;
+			std::copy_n(tile.walls.begin(), GetTileWords(this->m_grid, firstWord), words.begin() + firstWord);
+			std::copy_n(tile.costs.begin(), GetTileCells(this->m_grid, firstCell), costs.begin() + firstCell);
+			this->m_serials[index] = tile.serial;
+		}
+
+		this->m_grid.SetWallWords(words.data());
+		this->m_grid.SetCostData(costs.data());
+		this->m_version = snapshot.GetVersion();
+		return;
+	}
+
+	for (auto index = 0; index < tileCount; index++)
+	{
+		const auto &tile = snapshot.GetTile(index);
+		if (tile.serial == this->m_serials[index])
+			continue;
+
+		const auto firstWord = index * SNAPSHOT_TILE_WORDS;
+		const auto firstCell = index * SNAPSHOT_TILE_CELLS;
+		if (changed != nullptr)
+		{
+			const auto cells = GetTileCells(this->m_grid, firstCell);
+			for (auto offset = 0; offset < cells; offset++)
+			{
+				const auto wall = ((tile.walls[offset >> 6] >> (offset & 63)) & 1) != 0;
+				if (wall != this->m_grid.IsWall(firstCell + offset) || tile.costs[offset] != this->m_grid.GetCost(firstCell + offset))
+					changed->push_back(firstCell + offset);
+			}
+		}
+		this->m_grid.CopyWallWords(firstWord, GetTileWords(this->m_grid, firstWord), tile.walls.data());
+		this->m_grid.CopyCostData(firstCell, GetTileCells(this->m_grid, firstCell), tile.costs.data());
+		this->m_serials[index] = tile.serial;
+	}
+	this->m_version = snapshot.GetVersion();
+}
+
+Grid *GridReplica::GetGrid()
+{
+	return &this->m_grid;
+}
+
+const Grid *GridReplica::GetGrid() const
+{
+	return &this->m_grid;
+}
+
+std::uint64_t GridReplica::GetVersion() const
+{
+	return this->m_version;
+}
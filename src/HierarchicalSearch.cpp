@@ -0,0 +1,711 @@
+#include "HierarchicalSearch.h"
+
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <type_traits>
+
+namespace
+{
+	// Marks the goal in the abstract open list, the goal cell itself may be a node
+	const int GoalEntry = -2;
+
+	// Fewest edited clusters worth handing to the thread pool
+	const std::size_t MinParallelClusters = 16;
+
+	// Cells of a cluster's local search arrays
+	const int ClusterCells = CLUSTER_SIZE * CLUSTER_SIZE;
+
+	// Buckets of the local searches' ring, more than f can grow by in one step
+	const int BucketMask = HIERARCHICAL_BUCKETS - 1;
+	static_assert(HIERARCHICAL_BUCKETS > 2 * 2 * DIAGONAL_COST, "a step must not wrap around the bucket ring");
+}
+
+template <typename Conn>
+int HierarchicalSearch<Conn>::LocalSearch::GetCost(const int local) const
+{
+	return this->mark[local] == this->stamp ? this->cost[local] : INT_MAX;
+}
+
+template <typename Conn>
+HierarchicalSearch<Conn>::HierarchicalSearch()
+	: m_attached(nullptr)
+	, m_clusterRows(0)
+	, m_clusterCols(0)
+	, m_built(false)
+	, m_buildCount(0)
+	, m_rebuildCount(0)
+	, m_threadCount(0)
+	, m_stamp(0)
+	, m_goalCostTotal(INT_MAX)
+	, m_goalParent(NO_CELL)
+	, m_ownsState(false)
+{
+}
+
+template <typename Conn>
+HierarchicalSearch<Conn>::~HierarchicalSearch()
+{
+	if (this->m_attached != nullptr)
+		this->m_attached->RemoveObserver(this);
+}
+
+template <typename Conn>
+void HierarchicalSearch<Conn>::Start(Grid *grid)
+{
+	if (grid != this->m_attached)
+	{
+		if (this->m_attached != nullptr)
+			this->m_attached->RemoveObserver(this);
+		this->m_attached = grid;
+		grid->AddObserver(this);
+		this->m_built = false;
+		this->m_ownsState = false;
+	}
+
+	// Only the last path carries state once the grid has been reset for this engine
+	if (this->m_ownsState)
+	{
+		for (const auto id : this->m_lastPath)
+		{
+			grid->SetVisited(id, false);
+			grid->SetPrevious(id, NO_CELL);
+			grid->SetDistance(id, NO_DISTANCE);
+		}
+	}
+	else
+	{
+		grid->ResetSearch();
+		this->m_ownsState = true;
+	}
+	this->m_lastPath.clear();
+
+	this->m_grid = grid;
+	this->m_finished = false;
+	this->m_result = NO_CELL;
+	this->m_stats = SearchStats();
+}
+
+template <typename Conn>
+bool HierarchicalSearch<Conn>::Step()
+{
+	if (this->m_finished)
+		return false;
+
+	Query();
+	return false;
+}
+
+template <typename Conn>
+void HierarchicalSearch<Conn>::SetThreadCount(const int threads)
+{
+	this->m_threadCount = threads;
+}
+
+template <typename Conn>
+int HierarchicalSearch<Conn>::GetBuildCount() const
+{
+	return this->m_buildCount;
+}
+
+template <typename Conn>
+int HierarchicalSearch<Conn>::GetClusterRebuildCount() const
+{
+	return this->m_rebuildCount;
+}
+
+template <typename Conn>
+std::size_t HierarchicalSearch<Conn>::GetAllocatedBytes() const
+{
+	auto bytes = SearchEngine::GetAllocatedBytes();
+	for (const auto &cluster : this->m_clusters)
+	{
+		bytes += GetBufferBytes(cluster.nodes) + GetBufferBytes(cluster.partners) + GetBufferBytes(cluster.distances);
+		bytes += GetBufferBytes(cluster.cost) + GetBufferBytes(cluster.parent);
+	}
+	for (const auto &search : this->m_scratch)
+	{
+		bytes += GetBufferBytes(search.cost) + GetBufferBytes(search.parent) + GetBufferBytes(search.mark);
+		for (const auto &bucket : search.buckets)
+			bytes += GetBufferBytes(bucket);
+	}
+	bytes += GetBufferBytes(this->m_clusters) + GetBufferBytes(this->m_nodeIndex);
+	bytes += GetBufferBytes(this->m_dirty) + GetBufferBytes(this->m_isDirty);
+	bytes += this->m_open.GetAllocatedBytes() + GetBufferBytes(this->m_startCost) + GetBufferBytes(this->m_goalCost);
+	bytes += GetBufferBytes(this->m_lastPath);
+
+	// Buckets and nodes of the hash map, a node holds the pair and a link
+	bytes += this->m_pathPositions.bucket_count() * sizeof(void *);
+	bytes += this->m_pathPositions.size() * (sizeof(std::pair<const int, std::size_t>) + sizeof(void *));
+
+	// The fallback shares the grid state counted above
+	return bytes + this->m_flat.GetAllocatedBytes() - this->m_flat.SearchEngine::GetAllocatedBytes();
+}
+
+template <typename Conn>
+void HierarchicalSearch<Conn>::OnWallChanged(const int id, bool)
+{
+	if (!this->m_built)
+		return;
+
+	// Cells on a border also change the entrances of the cluster across it
+	const auto cluster = GetCluster(id);
+	int top, left, bottom, right;
+	GetClusterBounds(cluster, &top, &left, &bottom, &right);
+	const auto row = this->m_attached->GetRow(id);
+	const auto col = this->m_attached->GetCol(id);
+
+	MarkDirty(cluster);
+	if (row == top && top > 0)
+		MarkDirty(cluster - this->m_clusterCols);
+	if (row == bottom - 1 && bottom < this->m_attached->GetRows())
+		MarkDirty(cluster + this->m_clusterCols);
+	if (col == left && left > 0)
+		MarkDirty(cluster - 1);
+	if (col == right - 1 && right < this->m_attached->GetCols())
+		MarkDirty(cluster + 1);
+}
+
+template <typename Conn>
+void HierarchicalSearch<Conn>::OnGridReset()
+{
+	this->m_built = false;
+	this->m_ownsState = false;
+}
+
+template <typename Conn>
+void HierarchicalSearch<Conn>::MarkDirty(const int cluster)
+{
+	if (this->m_isDirty[cluster])
+		return;
+
+	this->m_isDirty[cluster] = 1;
+	this->m_dirty.push_back(cluster);
+}
+
+template <typename Conn>
+void HierarchicalSearch<Conn>::EnsureBuilt()
+{
+	if (this->m_built)
+	{
+		if (this->m_dirty.empty())
+			return;
+
+		// Only the edited clusters
+		this->m_rebuildCount += static_cast<int>(this->m_dirty.size());
+		BuildClusters(this->m_dirty);
+	}
+	else
+	{
+		// Edits before the build are part of it
+		this->m_dirty.clear();
+
+		const auto grid = this->m_attached;
+		this->m_clusterRows = (grid->GetRows() + CLUSTER_SIZE - 1) / CLUSTER_SIZE;
+		this->m_clusterCols = (grid->GetCols() + CLUSTER_SIZE - 1) / CLUSTER_SIZE;
+
+		const auto count = this->m_clusterRows * this->m_clusterCols;
+		this->m_clusters.assign(count, Cluster());
+		this->m_isDirty.assign(count, 0);
+		this->m_nodeIndex.assign(grid->GetCapacity(), -1);
+
+		std::vector<int> all(count);
+		for (auto cluster = 0; cluster < count; cluster++)
+			all[cluster] = cluster;
+		BuildClusters(all);
+
+		this->m_buildCount++;
+		this->m_built = true;
+	}
+
+	for (const auto cluster : this->m_dirty)
+		this->m_isDirty[cluster] = 0;
+	this->m_dirty.clear();
+}
+
+template <typename Conn>
+void HierarchicalSearch<Conn>::BuildClusters(const std::vector<int> &clusters)
+{
+	const auto threads = clusters.size() < MinParallelClusters ? 1
+		: this->m_threadCount > 0 ? this->m_threadCount : ThreadPool::GetDefaultThreadCount();
+	if (threads > 1 && (this->m_pool == nullptr || this->m_pool->GetThreadCount() != threads))
+		this->m_pool.reset(new ThreadPool(threads));
+	if (static_cast<int>(this->m_scratch.size()) < threads)
+		this->m_scratch.resize(threads);
+
+	if (threads == 1)
+	{
+		for (const auto cluster : clusters)
+			BuildCluster(cluster, &this->m_scratch[0]);
+		return;
+	}
+
+	// Clusters only write their own nodes, so workers take them in any order
+	std::atomic<std::size_t> next(0);
+	this->m_pool->Run([&](const int worker)
+	{
+		for (auto index = next++; index < clusters.size(); index = next++)
+			BuildCluster(clusters[index], &this->m_scratch[worker]);
+	});
+}
+
+template <typename Conn>
+void HierarchicalSearch<Conn>::BuildCluster(const int index, LocalSearch *search)
+{
+	const auto grid = this->m_attached;
+	const auto stride = grid->GetStride();
+	auto &cluster = this->m_clusters[index];
+	for (const auto node : cluster.nodes)
+		this->m_nodeIndex[node] = -1;
+	cluster.nodes.clear();
+	cluster.partners.clear();
+	cluster.stamp = 0;
+
+	int top, left, bottom, right;
+	GetClusterBounds(index, &top, &left, &bottom, &right);
+
+	// Both clusters of a border find the same runs, so their transitions match up
+	if (top > 0)
+		AddEntrances(&cluster, grid->GetId(top, left), -stride, 1, right - left);
+	if (bottom < grid->GetRows())
+		AddEntrances(&cluster, grid->GetId(bottom - 1, left), stride, 1, right - left);
+	if (left > 0)
+		AddEntrances(&cluster, grid->GetId(top, left), -1, stride, bottom - top);
+	if (right < grid->GetCols())
+		AddEntrances(&cluster, grid->GetId(top, right - 1), 1, stride, bottom - top);
+
+	// Distances between the nodes; moves are symmetric, so each flood stops once the later nodes are settled
+	const auto count = static_cast<int>(cluster.nodes.size());
+	cluster.distances.assign(static_cast<std::size_t>(count) * count, INT_MAX);
+	for (auto node = 0; node < count; node++)
+		this->m_nodeIndex[cluster.nodes[node]] = static_cast<std::int16_t>(node);
+	for (auto from = 0; from + 1 < count; from++)
+	{
+		SearchCluster(index, cluster.nodes[from], NO_CELL, from + 1, search, nullptr);
+		for (auto to = from + 1; to < count; to++)
+		{
+			const auto distance = search->GetCost(GetLocalIndex(index, cluster.nodes[to]));
+			cluster.distances[from * count + to] = distance;
+			cluster.distances[to * count + from] = distance;
+		}
+	}
+	for (auto node = 0; node < count; node++)
+		cluster.distances[node * count + node] = 0;
+}
+
+template <typename Conn>
+void HierarchicalSearch<Conn>::AddEntrances(Cluster *cluster, const int first, const int across, const int step, const int length)
+{
+	const auto grid = this->m_attached;
+	const auto addTransition = [&](const int id)
+	{
+		auto node = std::find(cluster->nodes.begin(), cluster->nodes.end(), id) - cluster->nodes.begin();
+		if (node == static_cast<std::ptrdiff_t>(cluster->nodes.size()))
+		{
+			cluster->nodes.push_back(id);
+			cluster->partners.push_back({ NO_CELL, NO_CELL, NO_CELL, NO_CELL });
+		}
+
+		auto &partners = cluster->partners[node];
+		*std::find(partners.begin(), partners.end(), NO_CELL) = id + across;
+	};
+
+	// Runs of cells open on both sides of the border
+	auto runStart = -1;
+	for (auto i = 0; i <= length; i++)
+	{
+		const auto id = first + i * step;
+		const auto open = i < length && !grid->IsWall(id) && !grid->IsWall(id + across);
+		if (open && runStart < 0)
+			runStart = i;
+		if (open || runStart < 0)
+			continue;
+
+		const auto width = i - runStart;
+		if (width >= ENTRANCE_SPLIT_WIDTH)
+		{
+			addTransition(first + runStart * step);
+			addTransition(first + (i - 1) * step);
+		}
+		else
+		{
+			addTransition(first + (runStart + width / 2) * step);
+		}
+		runStart = -1;
+	}
+}
+
+template <typename Conn>
+int HierarchicalSearch<Conn>::SearchCluster(const int cluster, const int source, const int target, const int firstNode,
+	LocalSearch *search, std::vector<int> *trace) const
+{
+	const auto grid = this->m_attached;
+	int top, left, bottom, right;
+	GetClusterBounds(cluster, &top, &left, &bottom, &right);
+
+	if (search->cost.empty())
+	{
+		search->cost.resize(ClusterCells);
+		search->parent.resize(ClusterCells);
+		search->mark.assign(ClusterCells, 0);
+	}
+	if (++search->stamp == 0)
+	{
+		std::fill(search->mark.begin(), search->mark.end(), 0);
+		search->stamp = 1;
+	}
+
+	const auto targetRow = target == NO_CELL ? 0 : grid->GetRow(target);
+	const auto targetCol = target == NO_CELL ? 0 : grid->GetCol(target);
+	const auto heuristic = [&](const int row, const int col)
+	{
+		return target == NO_CELL ? 0 : Conn::Cost(targetRow - row, targetCol - col);
+	};
+
+	// Nodes left to settle before a flood may stop, none to flood the whole cluster
+	const auto nodes = static_cast<int>(this->m_clusters[cluster].nodes.size());
+	auto remaining = target == NO_CELL ? std::max(nodes - firstNode, 0) : 0;
+
+	/*
+	 * Dial's algorithm: move costs are small integers, so cells wait in a ring
+	 * of buckets indexed by f instead of a heap. With a consistent heuristic f
+	 * grows by at most two moves per step, which the ring covers; an entry is
+	 * stale if the cell's f has dropped since it was queued.
+	 */
+
+	auto &buckets = search->buckets;
+	const auto sourceLocal = GetLocalIndex(cluster, source);
+	search->cost[sourceLocal] = 0;
+	search->parent[sourceLocal] = NO_CELL;
+	search->mark[sourceLocal] = search->stamp;
+	auto current = heuristic(grid->GetRow(source), grid->GetCol(source));
+	buckets[current & BucketMask].push_back(source);
+	std::size_t pending = 1;
+
+	// Neighbors are at most one row away, their row follows from the id offset without a division
+	const auto stride = grid->GetStride();
+	auto expansions = 0;
+	std::uint64_t checks = 0;
+	auto done = false;
+	for (; pending > 0 && !done; current++)
+	{
+		auto &bucket = buckets[current & BucketMask];
+		for (std::size_t i = 0; i < bucket.size() && !done; i++)
+		{
+			const auto id = bucket[i];
+			const auto row = grid->GetRow(id);
+			const auto col = grid->GetCol(id);
+			const auto cost = search->cost[(row - top) * CLUSTER_SIZE + col - left];
+			if (cost + heuristic(row, col) != current)
+				continue;
+
+			expansions++;
+			if (trace != nullptr)
+				trace->push_back(id);
+			if (id == target || (remaining > 0 && this->m_nodeIndex[id] >= firstNode && --remaining == 0))
+			{
+				done = true;
+				break;
+			}
+
+			Conn::ForEach(grid, id, [&](const int next, const bool diagonal)
+			{
+				checks++;
+				const auto offset = next - id;
+				const auto rowStep = offset > stride / 2 ? 1 : offset < -stride / 2 ? -1 : 0;
+				const auto nextRow = row + rowStep;
+				const auto nextCol = col + offset - rowStep * stride;
+				if (nextRow < top || nextRow >= bottom || nextCol < left || nextCol >= right)
+					return true;
+
+				const auto local = (nextRow - top) * CLUSTER_SIZE + nextCol - left;
+				const auto nextCost = cost + (diagonal ? DIAGONAL_COST : STRAIGHT_COST);
+				if (nextCost < search->GetCost(local))
+				{
+					search->cost[local] = nextCost;
+					search->parent[local] = id;
+					search->mark[local] = search->stamp;
+					buckets[(nextCost + heuristic(nextRow, nextCol)) & BucketMask].push_back(next);
+					pending++;
+				}
+				return true;
+			});
+		}
+
+		pending -= bucket.size();
+		bucket.clear();
+	}
+
+	// Entries an early stop left behind
+	if (pending > 0)
+	{
+		for (auto &bucket : buckets)
+			bucket.clear();
+	}
+	search->checks += checks;
+	return expansions;
+}
+
+template <typename Conn>
+int HierarchicalSearch<Conn>::GetCluster(const int id) const
+{
+	const auto row = this->m_attached->GetRow(id);
+	const auto col = this->m_attached->GetCol(id);
+	return row / CLUSTER_SIZE * this->m_clusterCols + col / CLUSTER_SIZE;
+}
+
+template <typename Conn>
+void HierarchicalSearch<Conn>::GetClusterBounds(const int cluster, int *top, int *left, int *bottom, int *right) const
+{
+	*top = cluster / this->m_clusterCols * CLUSTER_SIZE;
+	*left = cluster % this->m_clusterCols * CLUSTER_SIZE;
+	*bottom = std::min(*top + CLUSTER_SIZE, this->m_attached->GetRows());
+	*right = std::min(*left + CLUSTER_SIZE, this->m_attached->GetCols());
+}
+
+template <typename Conn>
+int HierarchicalSearch<Conn>::GetLocalIndex(const int cluster, const int id) const
+{
+	const auto top = cluster / this->m_clusterCols * CLUSTER_SIZE;
+	const auto left = cluster % this->m_clusterCols * CLUSTER_SIZE;
+	return (this->m_attached->GetRow(id) - top) * CLUSTER_SIZE + this->m_attached->GetCol(id) - left;
+}
+
+template <typename Conn>
+void HierarchicalSearch<Conn>::Relax(const int node, const int cost, const int parent)
+{
+	auto &cluster = this->m_clusters[GetCluster(node)];
+	if (cluster.stamp != this->m_stamp)
+	{
+		cluster.stamp = this->m_stamp;
+		cluster.cost.assign(cluster.nodes.size(), INT_MAX);
+		cluster.parent.assign(cluster.nodes.size(), NO_CELL);
+	}
+
+	this->m_stats.neighborChecks++;
+	const auto index = this->m_nodeIndex[node];
+	if (index < 0 || cost >= cluster.cost[index])
+		return;
+
+	if (cluster.cost[index] != INT_MAX)
+		this->m_stats.duplicatePushes++;
+	cluster.cost[index] = cost;
+	cluster.parent[index] = parent;
+
+	const auto grid = this->m_grid;
+	const auto goal = grid->GetGoal();
+	const auto heuristic = Conn::Cost(grid->GetRow(goal) - grid->GetRow(node), grid->GetCol(goal) - grid->GetCol(node));
+	this->m_open.Push({ cost + heuristic, cost, node });
+}
+
+template <typename Conn>
+void HierarchicalSearch<Conn>::Query()
+{
+	const auto grid = this->m_grid;
+	const auto start = grid->GetStart();
+	const auto goal = grid->GetGoal();
+	if (start == NO_CELL || goal == NO_CELL || grid->IsWall(start) || grid->IsWall(goal))
+	{
+		Finish(NO_CELL);
+		return;
+	}
+
+	EnsureBuilt();
+	if (++this->m_stamp == 0)
+	{
+		for (auto &cluster : this->m_clusters)
+			cluster.stamp = 0;
+		this->m_stamp = 1;
+	}
+
+	/*
+	 * HPA* query
+	 *
+	 * Flood the start's cluster for the costs to its nodes and the goal's
+	 * cluster for the costs from its nodes to the goal. Run A* over the nodes:
+	 * a node leads to the other nodes of its cluster at their precomputed
+	 * distance, across its transitions at one straight move, and in the goal's
+	 * cluster to the goal. The goal is accepted when popped.
+	 */
+
+	auto &search = this->m_scratch[0];
+	search.checks = 0;
+	const auto startCluster = GetCluster(start);
+	const auto goalCluster = GetCluster(goal);
+	this->m_open.Clear();
+	this->m_goalCostTotal = INT_MAX;
+	this->m_goalParent = NO_CELL;
+
+	auto local = SearchCluster(goalCluster, goal, NO_CELL, 0, &search, this->m_trace);
+	const auto &goalNodes = this->m_clusters[goalCluster].nodes;
+	this->m_goalCost.resize(goalNodes.size());
+	for (std::size_t node = 0; node < goalNodes.size(); node++)
+		this->m_goalCost[node] = search.GetCost(GetLocalIndex(goalCluster, goalNodes[node]));
+
+	// Sharing the cluster, the goal has to be settled as well
+	const auto startFirstNode = startCluster == goalCluster ? INT_MAX : 0;
+	local += SearchCluster(startCluster, start, NO_CELL, startFirstNode, &search, this->m_trace);
+	const auto &startNodes = this->m_clusters[startCluster].nodes;
+	this->m_startCost.resize(startNodes.size());
+	for (std::size_t node = 0; node < startNodes.size(); node++)
+		this->m_startCost[node] = search.GetCost(GetLocalIndex(startCluster, startNodes[node]));
+
+	// A route that never leaves the cluster
+	if (startCluster == goalCluster && search.GetCost(GetLocalIndex(startCluster, goal)) != INT_MAX)
+	{
+		this->m_goalCostTotal = search.GetCost(GetLocalIndex(startCluster, goal));
+		this->m_goalParent = start;
+		this->m_open.Push({ this->m_goalCostTotal, this->m_goalCostTotal, GoalEntry });
+	}
+
+	for (std::size_t node = 0; node < startNodes.size(); node++)
+	{
+		if (this->m_startCost[node] != INT_MAX)
+			Relax(startNodes[node], this->m_startCost[node], start);
+	}
+
+	auto found = false;
+	while (!this->m_open.IsEmpty())
+	{
+		const auto entry = this->m_open.Pop();
+		if (entry.id == GoalEntry)
+		{
+			if (entry.g != this->m_goalCostTotal)
+				continue;
+			found = true;
+			break;
+		}
+
+		const auto clusterIndex = GetCluster(entry.id);
+		const auto &cluster = this->m_clusters[clusterIndex];
+		const auto node = this->m_nodeIndex[entry.id];
+		if (entry.g != cluster.cost[node])
+			continue;
+
+		this->m_stats.expansions++;
+
+		const auto count = static_cast<int>(cluster.nodes.size());
+		for (auto other = 0; other < count; other++)
+		{
+			const auto distance = cluster.distances[node * count + other];
+			if (other != node && distance != INT_MAX)
+				Relax(cluster.nodes[other], entry.g + distance, entry.id);
+		}
+
+		for (const auto partner : cluster.partners[node])
+		{
+			if (partner != NO_CELL)
+				Relax(partner, entry.g + STRAIGHT_COST, entry.id);
+		}
+
+		if (clusterIndex == goalCluster && this->m_goalCost[node] != INT_MAX && entry.g + this->m_goalCost[node] < this->m_goalCostTotal)
+		{
+			this->m_goalCostTotal = entry.g + this->m_goalCost[node];
+			this->m_goalParent = entry.id;
+			this->m_open.Push({ this->m_goalCostTotal, this->m_goalCostTotal, GoalEntry });
+		}
+
+		if (this->m_open.GetSize() > this->m_stats.peakFrontier)
+			this->m_stats.peakFrontier = this->m_open.GetSize();
+	}
+
+	if (!found)
+	{
+		this->m_stats.expansions += local;
+
+		// Diagonal border crossings aren't transitions, only flat search can rule them out
+		constexpr auto complete = std::is_same<Conn, FourConnected>::value
+			|| std::is_same<Conn, EightConnected<CornerCutting::Forbid>>::value;
+		if (!complete)
+		{
+			this->m_flat.SetTrace(this->m_trace);
+			this->m_flat.Start(grid);
+			this->m_flat.Run();
+			const auto &flat = this->m_flat.GetStats();
+			this->m_stats.expansions += flat.expansions;
+			this->m_stats.neighborChecks += search.checks + flat.neighborChecks;
+			this->m_stats.duplicatePushes += flat.duplicatePushes;
+			this->m_stats.peakFrontier = std::max(this->m_stats.peakFrontier, flat.peakFrontier);
+			this->m_ownsState = false;
+			Finish(this->m_flat.GetResult());
+			return;
+		}
+
+		this->m_stats.neighborChecks += search.checks;
+		Finish(NO_CELL);
+		return;
+	}
+
+	// Nodes of the route, goal first
+	std::vector<int> route = { goal };
+	for (auto id = this->m_goalParent; id != start; )
+	{
+		route.push_back(id);
+		const auto &cluster = this->m_clusters[GetCluster(id)];
+		id = cluster.parent[this->m_nodeIndex[id]];
+	}
+	route.push_back(start);
+	std::reverse(route.begin(), route.end());
+
+	// Cell by cell between consecutive nodes, transitions are single moves
+	std::vector<int> path = { start };
+	for (std::size_t i = 1; i < route.size(); i++)
+	{
+		const auto from = route[i - 1];
+		const auto to = route[i];
+		const auto cluster = GetCluster(from);
+		if (from == to)
+			continue;
+		if (cluster != GetCluster(to))
+		{
+			path.push_back(to);
+			continue;
+		}
+
+		local += SearchCluster(cluster, from, to, 0, &search, this->m_trace);
+		const auto first = path.size();
+		for (auto id = to; id != from; id = search.parent[GetLocalIndex(cluster, id)])
+			path.push_back(id);
+		std::reverse(path.begin() + first, path.end());
+	}
+
+	this->m_stats.expansions += local;
+	this->m_stats.neighborChecks += search.checks;
+	WritePath(&path);
+	Finish(goal);
+}
+
+template <typename Conn>
+void HierarchicalSearch<Conn>::WritePath(std::vector<int> *path)
+{
+	// Segments refined one at a time can double back over each other, loops are cut out
+	auto &cells = this->m_lastPath;
+	auto &positions = this->m_pathPositions;
+	positions.clear();
+	for (const auto id : *path)
+	{
+		const auto seen = positions.find(id);
+		if (seen != positions.end())
+		{
+			while (cells.size() > seen->second + 1)
+			{
+				positions.erase(cells.back());
+				cells.pop_back();
+			}
+			continue;
+		}
+
+		positions.emplace(id, cells.size());
+		cells.push_back(id);
+	}
+
+	const auto grid = this->m_grid;
+	for (std::size_t i = 0; i < cells.size(); i++)
+	{
+		grid->SetVisited(cells[i], true);
+		grid->SetPrevious(cells[i], i > 0 ? cells[i - 1] : NO_CELL);
+		grid->SetDistance(cells[i], static_cast<int>(i));
+	}
+}
+
+INSTANTIATE_ENGINE(HierarchicalSearch)
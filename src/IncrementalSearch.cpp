@@ -0,0 +1,276 @@
+#include "IncrementalSearch.h"
+
+#include <algorithm>
+#include <climits>
+
+namespace
+{
+	// Cost of cells that can't be reached
+	const int Infinity = INT_MAX;
+}
+
+template <typename Conn>
+void IncrementalSearch<Conn>::Start(Grid *grid)
+{
+	SearchEngine::Start(grid);
+	this->m_open.clear();
+	this->m_g.assign(grid->GetCapacity(), Infinity);
+	this->m_rhs.assign(grid->GetCapacity(), Infinity);
+	this->m_path.clear();
+
+	const auto start = grid->GetStart();
+	const auto goal = grid->GetGoal();
+	if (start == NO_CELL || goal == NO_CELL)
+	{
+		Finish(NO_CELL);
+		return;
+	}
+	this->m_goalRow = grid->GetRow(goal);
+	this->m_goalCol = grid->GetCol(goal);
+
+	// Starting point, the only cell whose rhs is not taken from its neighbors
+	this->m_rhs[start] = 0;
+	this->m_open.push_back(GetKey(start));
+}
+
+template <typename Conn>
+bool IncrementalSearch<Conn>::Step()
+{
+	return Expand();
+}
+
+template <typename Conn>
+void IncrementalSearch<Conn>::Run()
+{
+	while (Expand())
+	{
+	}
+}
+
+template <typename Conn>
+void IncrementalSearch<Conn>::UpdateCell(const int id)
+{
+	// The cell's own rhs and, through corner cutting and costs, the rhs of its ring of neighbors
+	const auto stride = this->m_grid->GetStride();
+	for (auto row = -1; row <= 1; row++)
+	{
+		for (auto col = -1; col <= 1; col++)
+			UpdateVertex(id + row * stride + col);
+	}
+}
+
+template <typename Conn>
+bool IncrementalSearch<Conn>::Replan()
+{
+	if (this->m_grid->GetGoal() == NO_CELL || this->m_grid->GetStart() == NO_CELL)
+		return false;
+
+	this->m_finished = false;
+	this->m_result = NO_CELL;
+	this->m_stats = SearchStats();
+	Run();
+	return this->m_result != NO_CELL;
+}
+
+template <typename Conn>
+int IncrementalSearch<Conn>::Heuristic(const int id) const
+{
+	return Conn::Cost(this->m_goalRow - this->m_grid->GetRow(id), this->m_goalCol - this->m_grid->GetCol(id));
+}
+
+template <typename Conn>
+int IncrementalSearch<Conn>::GetMoveCost(const int id, const bool diagonal) const
+{
+	return this->m_grid->GetCost(id) * (diagonal ? DIAGONAL_COST : STRAIGHT_COST);
+}
+
+template <typename Conn>
+IncrementalEntry IncrementalSearch<Conn>::GetKey(const int id) const
+{
+	const auto cost = std::min(this->m_g[id], this->m_rhs[id]);
+	if (cost == Infinity)
+		return { LLONG_MAX, Infinity, id };
+	return { static_cast<long long>(cost) + Heuristic(id), cost, id };
+}
+
+template <typename Conn>
+void IncrementalSearch<Conn>::UpdateVertex(const int id)
+{
+	const auto grid = this->m_grid;
+	if (id != grid->GetStart())
+	{
+		// One-step lookahead: the cheapest way in from any neighbor
+		auto rhs = Infinity;
+		if (!grid->IsWall(id))
+		{
+			Conn::ForEach(grid, id, [&](const int previous, const bool diagonal)
+			{
+				if (this->m_g[previous] != Infinity)
+					rhs = std::min(rhs, this->m_g[previous] + GetMoveCost(id, diagonal));
+				return true;
+			});
+		}
+		this->m_rhs[id] = rhs;
+	}
+
+	// Inconsistent cells are queued, an older entry of the cell is skipped once its key is outdated
+	if (this->m_g[id] != this->m_rhs[id])
+	{
+		this->m_open.push_back(GetKey(id));
+		std::push_heap(this->m_open.begin(), this->m_open.end());
+	}
+}
+
+template <typename Conn>
+bool IncrementalSearch<Conn>::Expand()
+{
+	if (this->m_finished)
+		return false;
+
+	/*
+	 * LPA* algorithm
+	 *
+	 * Pop the inconsistent cell with the smallest key, skipping outdated
+	 * entries, until the goal is consistent and no queued key is smaller.
+	 * An overconsistent cell (g > rhs) takes its rhs and lowers the rhs of its
+	 * neighbors, an underconsistent one (g < rhs) is reset to infinity and it
+	 * and its neighbors are recomputed.
+	 */
+
+	const auto grid = this->m_grid;
+	const auto goal = grid->GetGoal();
+	while (!this->m_open.empty())
+	{
+		const auto &top = this->m_open.front();
+		const auto key = GetKey(top.id);
+		if (this->m_g[top.id] != this->m_rhs[top.id] && key.k1 == top.k1 && key.k2 == top.k2)
+			break;
+
+		std::pop_heap(this->m_open.begin(), this->m_open.end());
+		this->m_open.pop_back();
+	}
+
+	if (this->m_open.empty() || !(GetKey(goal) < this->m_open.front() || this->m_rhs[goal] != this->m_g[goal]))
+	{
+		FillPath();
+		Finish(this->m_g[goal] != Infinity ? goal : NO_CELL);
+		return false;
+	}
+
+	const auto current = this->m_open.front().id;
+	std::pop_heap(this->m_open.begin(), this->m_open.end());
+	this->m_open.pop_back();
+
+	grid->SetVisited(current, true);
+	this->m_stats.expansions++;
+	if (this->m_trace != nullptr)
+		this->m_trace->push_back(current);
+
+	auto checks = 0;
+	auto duplicates = 0;
+	if (this->m_g[current] > this->m_rhs[current])
+	{
+		const auto cost = this->m_rhs[current];
+		this->m_g[current] = cost;
+
+		Conn::ForEach(grid, current, [&](const int next, const bool diagonal)
+		{
+			checks++;
+			const auto nextCost = cost + GetMoveCost(next, diagonal);
+			if (next != grid->GetStart() && nextCost < this->m_rhs[next])
+			{
+				// An inconsistent cell is queued already, its old entry goes stale
+				if (this->m_rhs[next] != Infinity && this->m_rhs[next] != this->m_g[next])
+					duplicates++;
+
+				this->m_rhs[next] = nextCost;
+				if (this->m_g[next] != nextCost)
+				{
+					this->m_open.push_back(GetKey(next));
+					std::push_heap(this->m_open.begin(), this->m_open.end());
+				}
+			}
+			return true;
+		});
+	}
+	else
+	{
+		this->m_g[current] = Infinity;
+		UpdateVertex(current);
+
+		Conn::ForEach(grid, current, [&](const int next, bool)
+		{
+			checks++;
+			UpdateVertex(next);
+			return true;
+		});
+	}
+
+	this->m_stats.neighborChecks += checks;
+	this->m_stats.duplicatePushes += duplicates;
+	if (this->m_open.size() > this->m_stats.peakFrontier)
+		this->m_stats.peakFrontier = this->m_open.size();
+
+	return true;
+}
+
+template <typename Conn>
+std::size_t IncrementalSearch<Conn>::GetAllocatedBytes() const
+{
+	return SearchEngine::GetAllocatedBytes() + GetBufferBytes(this->m_open) + GetBufferBytes(this->m_g)
+		+ GetBufferBytes(this->m_rhs) + GetBufferBytes(this->m_path);
+}
+
+template <typename Conn>
+void IncrementalSearch<Conn>::FillPath()
+{
+	const auto grid = this->m_grid;
+
+	// Only the cells of the previous path were linked
+	for (const auto id : this->m_path)
+	{
+		grid->SetPrevious(id, NO_CELL);
+		grid->SetDistance(id, NO_DISTANCE);
+	}
+	this->m_path.clear();
+
+	const auto start = grid->GetStart();
+	const auto goal = grid->GetGoal();
+	if (this->m_g[goal] == Infinity)
+		return;
+
+	// Back from the goal through the neighbor the cell's cost came from
+	for (auto current = goal; current != start;)
+	{
+		this->m_path.push_back(current);
+
+		auto parent = NO_CELL;
+		auto best = Infinity;
+		Conn::ForEach(grid, current, [&](const int previous, const bool diagonal)
+		{
+			if (this->m_g[previous] != Infinity && this->m_g[previous] + GetMoveCost(current, diagonal) < best)
+			{
+				best = this->m_g[previous] + GetMoveCost(current, diagonal);
+				parent = previous;
+			}
+			return true;
+		});
+
+		if (parent == NO_CELL || this->m_path.size() > static_cast<std::size_t>(grid->GetCapacity()))
+		{
+			this->m_path.clear();
+			return;
+		}
+		current = parent;
+	}
+	this->m_path.push_back(start);
+	std::reverse(this->m_path.begin(), this->m_path.end());
+
+	for (std::size_t i = 0; i < this->m_path.size(); i++)
+	{
+		grid->SetPrevious(this->m_path[i], i == 0 ? NO_CELL : this->m_path[i - 1]);
+		grid->SetDistance(this->m_path[i], static_cast<int>(i));
+	}
+}
+
+INSTANTIATE_ENGINE(IncrementalSearch)
@@ -0,0 +1,423 @@
+#include "JumpPointSearch.h"
+
+#include <climits>
+
+namespace
+{
+	/*
+	 * Pruning and jump rules per connectivity policy. Directions are given as
+	 * (dRow, dCol) in -1..1 and every scan starts at the cell one step from
+	 * its parent. Successors(id, dRow, dCol, fn) calls fn(dRow, dCol) for every
+	 * direction worth scanning from a cell entered moving in (dRow, dCol).
+	 */
+	template <typename Conn>
+	struct JumpRules;
+
+	// Moves only along rows and columns
+	template <>
+	struct JumpRules<FourConnected>
+	{
+		static int Jump(const Grid *grid, int id, const int dRow, const int dCol)
+		{
+			const auto stride = grid->GetStride();
+			const auto step = dRow * stride + dCol;
+			const auto goal = grid->GetGoal();
+
+			while (!grid->IsWall(id))
+			{
+				if (id == goal)
+					return id;
+
+				if (dCol != 0)
+				{
+					// Forced neighbor above or below
+					if ((!grid->IsWall(id - stride) && grid->IsWall(id - dCol - stride))
+						|| (!grid->IsWall(id + stride) && grid->IsWall(id - dCol + stride)))
+						return id;
+				}
+				else
+				{
+					// Forced neighbor left or right
+					if ((!grid->IsWall(id - 1) && grid->IsWall(id - 1 - dRow * stride))
+						|| (!grid->IsWall(id + 1) && grid->IsWall(id + 1 - dRow * stride)))
+						return id;
+
+					// Vertical scans stop where a horizontal scan finds something
+					if (Jump(grid, id + 1, 0, 1) != NO_CELL || Jump(grid, id - 1, 0, -1) != NO_CELL)
+						return id;
+				}
+				id += step;
+			}
+			return NO_CELL;
+		}
+
+		template <typename Fn>
+		static void Successors(const Grid *grid, const int id, const int dRow, const int dCol, Fn &&fn)
+		{
+			const auto stride = grid->GetStride();
+
+			if (dCol != 0)
+			{
+				if (!grid->IsWall(id - stride))
+					fn(-1, 0);
+				if (!grid->IsWall(id + stride))
+					fn(1, 0);
+				if (!grid->IsWall(id + dCol))
+					fn(0, dCol);
+			}
+			else
+			{
+				if (!grid->IsWall(id - 1))
+					fn(0, -1);
+				if (!grid->IsWall(id + 1))
+					fn(0, 1);
+				if (!grid->IsWall(id + dRow * stride))
+					fn(dRow, 0);
+			}
+		}
+	};
+
+	// Diagonal moves are allowed even between two walls
+	template <>
+	struct JumpRules<EightConnected<CornerCutting::Allow>>
+	{
+		static int Jump(const Grid *grid, int id, const int dRow, const int dCol)
+		{
+			const auto stride = grid->GetStride();
+			const auto rowStep = dRow * stride;
+			const auto step = rowStep + dCol;
+			const auto goal = grid->GetGoal();
+
+			while (!grid->IsWall(id))
+			{
+				if (id == goal)
+					return id;
+
+				if (dRow != 0 && dCol != 0)
+				{
+					if ((!grid->IsWall(id - dCol + rowStep) && grid->IsWall(id - dCol))
+						|| (!grid->IsWall(id + dCol - rowStep) && grid->IsWall(id - rowStep)))
+						return id;
+
+					// Diagonal scans stop where a straight scan finds something
+					if (Jump(grid, id + dCol, 0, dCol) != NO_CELL || Jump(grid, id + rowStep, dRow, 0) != NO_CELL)
+						return id;
+				}
+				else if (dCol != 0)
+				{
+					if ((!grid->IsWall(id + dCol + stride) && grid->IsWall(id + stride))
+						|| (!grid->IsWall(id + dCol - stride) && grid->IsWall(id - stride)))
+						return id;
+				}
+				else
+				{
+					if ((!grid->IsWall(id + 1 + rowStep) && grid->IsWall(id + 1))
+						|| (!grid->IsWall(id - 1 + rowStep) && grid->IsWall(id - 1)))
+						return id;
+				}
+				id += step;
+			}
+			return NO_CELL;
+		}
+
+		template <typename Fn>
+		static void Successors(const Grid *grid, const int id, const int dRow, const int dCol, Fn &&fn)
+		{
+			const auto stride = grid->GetStride();
+			const auto rowStep = dRow * stride;
+
+			if (dRow != 0 && dCol != 0)
+			{
+				fn(dRow, 0);
+				fn(0, dCol);
+				fn(dRow, dCol);
+				if (grid->IsWall(id - dCol))
+					fn(dRow, -dCol);
+				if (grid->IsWall(id - rowStep))
+					fn(-dRow, dCol);
+			}
+			else if (dCol != 0)
+			{
+				fn(0, dCol);
+				if (grid->IsWall(id + stride))
+					fn(1, dCol);
+				if (grid->IsWall(id - stride))
+					fn(-1, dCol);
+			}
+			else
+			{
+				fn(dRow, 0);
+				if (grid->IsWall(id + 1))
+					fn(dRow, 1);
+				if (grid->IsWall(id - 1))
+					fn(dRow, -1);
+			}
+		}
+	};
+
+	// Diagonal moves need both cells they pass to be open
+	template <>
+	struct JumpRules<EightConnected<CornerCutting::Forbid>>
+	{
+		static int Jump(const Grid *grid, int id, const int dRow, const int dCol)
+		{
+			const auto stride = grid->GetStride();
+			const auto rowStep = dRow * stride;
+			const auto goal = grid->GetGoal();
+
+			while (!grid->IsWall(id))
+			{
+				if (id == goal)
+					return id;
+
+				if (dRow != 0 && dCol != 0)
+				{
+					// Diagonal scans stop where a straight scan finds something
+					if (Jump(grid, id + dCol, 0, dCol) != NO_CELL || Jump(grid, id + rowStep, dRow, 0) != NO_CELL)
+						return id;
+				}
+				else if (dCol != 0)
+				{
+					if ((!grid->IsWall(id - stride) && grid->IsWall(id - dCol - stride))
+						|| (!grid->IsWall(id + stride) && grid->IsWall(id - dCol + stride)))
+						return id;
+				}
+				else
+				{
+					if ((!grid->IsWall(id - 1) && grid->IsWall(id - 1 - rowStep))
+						|| (!grid->IsWall(id + 1) && grid->IsWall(id + 1 - rowStep)))
+						return id;
+				}
+
+				// The next move must not cut a corner
+				if (grid->IsWall(id + dCol) || grid->IsWall(id + rowStep))
+					return NO_CELL;
+				id += rowStep + dCol;
+			}
+			return NO_CELL;
+		}
+
+		template <typename Fn>
+		static void Successors(const Grid *grid, const int id, const int dRow, const int dCol, Fn &&fn)
+		{
+			const auto stride = grid->GetStride();
+
+			if (dRow != 0 && dCol != 0)
+			{
+				const auto vertical = !grid->IsWall(id + dRow * stride);
+				const auto horizontal = !grid->IsWall(id + dCol);
+				if (vertical)
+					fn(dRow, 0);
+				if (horizontal)
+					fn(0, dCol);
+				if (vertical && horizontal)
+					fn(dRow, dCol);
+			}
+			else if (dCol != 0)
+			{
+				const auto next = !grid->IsWall(id + dCol);
+				const auto below = !grid->IsWall(id + stride);
+				const auto above = !grid->IsWall(id - stride);
+				if (next)
+				{
+					fn(0, dCol);
+					if (below)
+						fn(1, dCol);
+					if (above)
+						fn(-1, dCol);
+				}
+				if (below)
+					fn(1, 0);
+				if (above)
+					fn(-1, 0);
+			}
+			else
+			{
+				const auto next = !grid->IsWall(id + dRow * stride);
+				const auto right = !grid->IsWall(id + 1);
+				const auto left = !grid->IsWall(id - 1);
+				if (next)
+				{
+					fn(dRow, 0);
+					if (right)
+						fn(dRow, 1);
+					if (left)
+						fn(dRow, -1);
+				}
+				if (right)
+					fn(0, 1);
+				if (left)
+					fn(0, -1);
+			}
+		}
+	};
+
+	int Sign(const int value)
+	{
+		return (value > 0) - (value < 0);
+	}
+}
+
+template <typename Conn>
+void JumpPointSearch<Conn>::Start(Grid *grid)
+{
+	SearchEngine::Start(grid);
+	this->m_open.Clear();
+	this->m_cost.assign(grid->GetCapacity(), INT_MAX);
+
+	const auto start = grid->GetStart();
+	const auto goal = grid->GetGoal();
+	this->m_goalRow = grid->GetRow(goal);
+	this->m_goalCol = grid->GetCol(goal);
+
+	// Starting point
+	this->m_cost[start] = 0;
+	this->m_open.Push({ Heuristic(start), 0, start });
+}
+
+template <typename Conn>
+bool JumpPointSearch<Conn>::Step()
+{
+	return Expand();
+}
+
+template <typename Conn>
+void JumpPointSearch<Conn>::Run()
+{
+	while (Expand())
+	{
+	}
+}
+
+template <typename Conn>
+std::size_t JumpPointSearch<Conn>::GetAllocatedBytes() const
+{
+	return SearchEngine::GetAllocatedBytes() + this->m_open.GetAllocatedBytes() + GetBufferBytes(this->m_cost);
+}
+
+template <typename Conn>
+int JumpPointSearch<Conn>::Heuristic(const int id) const
+{
+	return Conn::Cost(this->m_goalRow - this->m_grid->GetRow(id), this->m_goalCol - this->m_grid->GetCol(id));
+}
+
+template <typename Conn>
+inline bool JumpPointSearch<Conn>::Expand()
+{
+	if (this->m_finished)
+		return false;
+
+	const auto grid = this->m_grid;
+	auto current = NO_CELL;
+	auto cost = 0;
+	while (!this->m_open.IsEmpty())
+	{
+		const auto entry = this->m_open.Pop();
+		if (!grid->WasVisited(entry.id) && entry.g == this->m_cost[entry.id])
+		{
+			current = entry.id;
+			cost = entry.g;
+			break;
+		}
+	}
+
+	if (current == NO_CELL)
+	{
+		Finish(NO_CELL); // Goal NOT found
+		return false;
+	}
+
+	grid->SetVisited(current, true);
+	this->m_stats.expansions++;
+	if (this->m_trace != nullptr)
+		this->m_trace->push_back(current);
+
+	if (current == grid->GetGoal())
+	{
+		FillPath(current);
+		Finish(current); // Goal found
+		return false;
+	}
+
+	const auto stride = grid->GetStride();
+	const auto row = grid->GetRow(current);
+	const auto col = grid->GetCol(current);
+
+	// Scans a direction and pushes the jump point it ends at, a scan counts as one neighbor check
+	auto checks = 0;
+	auto duplicates = 0;
+	const auto scan = [&](const int dRow, const int dCol)
+	{
+		checks++;
+		const auto jumpPoint = JumpRules<Conn>::Jump(grid, current + dRow * stride + dCol, dRow, dCol);
+		if (jumpPoint == NO_CELL || grid->WasVisited(jumpPoint))
+			return;
+
+		const auto jumpRow = grid->GetRow(jumpPoint) - row;
+		const auto jumpCol = grid->GetCol(jumpPoint) - col;
+		const auto nextCost = cost + Conn::Cost(jumpRow, jumpCol);
+		if (nextCost < this->m_cost[jumpPoint])
+		{
+			if (this->m_cost[jumpPoint] != INT_MAX)
+				duplicates++;
+
+			this->m_cost[jumpPoint] = nextCost;
+			grid->SetPrevious(jumpPoint, current);
+			this->m_open.Push({ nextCost + Heuristic(jumpPoint), nextCost, jumpPoint });
+		}
+	};
+
+	const auto parent = grid->GetPrevious(current);
+	if (parent == NO_CELL)
+	{
+		// The start scans every open direction
+		Conn::ForEach(grid, current, [&](const int next, bool)
+		{
+			scan(grid->GetRow(next) - row, grid->GetCol(next) - col);
+			return true;
+		});
+	}
+	else
+	{
+		// Other cells only scan the directions pruning leaves
+		const auto dRow = Sign(row - grid->GetRow(parent));
+		const auto dCol = Sign(col - grid->GetCol(parent));
+		JumpRules<Conn>::Successors(grid, current, dRow, dCol, scan);
+	}
+
+	this->m_stats.neighborChecks += checks;
+	this->m_stats.duplicatePushes += duplicates;
+	if (this->m_open.GetSize() > this->m_stats.peakFrontier)
+		this->m_stats.peakFrontier = this->m_open.GetSize();
+
+	return true;
+}
+
+template <typename Conn>
+void JumpPointSearch<Conn>::FillPath(const int goal)
+{
+	const auto grid = this->m_grid;
+	const auto stride = grid->GetStride();
+
+	// Link every cell between two jump points to the cell before it
+	for (auto jumpPoint = goal; grid->GetPrevious(jumpPoint) != NO_CELL; )
+	{
+		const auto parent = grid->GetPrevious(jumpPoint);
+		const auto step = Sign(grid->GetRow(jumpPoint) - grid->GetRow(parent)) * stride
+			+ Sign(grid->GetCol(jumpPoint) - grid->GetCol(parent));
+
+		for (auto cell = jumpPoint; cell != parent; cell -= step)
+			grid->SetPrevious(cell, cell - step);
+
+		jumpPoint = parent;
+	}
+
+	// Number the moves along the path
+	auto distance = 0;
+	for (const auto cell : grid->GetPath(goal))
+		grid->SetDistance(cell, distance++);
+}
+
+template class JumpPointSearch<FourConnected>;
+template class JumpPointSearch<EightConnected<CornerCutting::Allow>>;
+template class JumpPointSearch<EightConnected<CornerCutting::Forbid>>;
@@ -0,0 +1,395 @@
+#include "MapFile.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#ifdef _WIN32
+#include <fstream>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+	const char MapMagic[8] = { 'G', 'R', 'I', 'D', 'M', 'A', 'P', '\0' };
+
+	// Sections start on multiples of this
+	const std::uint64_t SectionAlignment = 64;
+
+	// Read-only view of a whole file, mapped where the platform allows it
+	class MappedFile
+	{
+	public:
+		MappedFile() = default;
+		~MappedFile();
+
+		MappedFile(const MappedFile &) = delete;
+		MappedFile &operator=(const MappedFile &) = delete;
+
+		bool Open(const std::string &path, std::string *error);
+
+		const char *GetData() const { return this->m_data; }
+		std::size_t GetSize() const { return this->m_size; }
+	private:
+		const char *m_data = nullptr;
+		std::size_t m_size = 0;
+#ifdef _WIN32
+		std::vector<char> m_buffer;
+#endif
+	};
+
+	MappedFile::~MappedFile()
+	{
+#ifndef _WIN32
+		if (this->m_data != nullptr)
+			munmap(const_cast<char*>(this->m_data), this->m_size);
+#endif
+	}
+
+	bool MappedFile::Open(const std::string &path, std::string *error)
+	{
+#ifdef _WIN32
+		std::ifstream file(path, std::ios::binary | std::ios::ate);
+		if (!file)
+		{
+			*error = "Cannot open " + path;
+			return false;
+		}
+		this->m_buffer.resize(static_cast<std::size_t>(file.tellg()));
+		file.seekg(0);
+		file.read(this->m_buffer.data(), static_cast<std::streamsize>(this->m_buffer.size()));
+		this->m_data = this->m_buffer.data();
+		this->m_size = this->m_buffer.size();
+#else
+		const auto descriptor = open(path.c_str(), O_RDONLY);
+		if (descriptor < 0)
+		{
+			*error = "Cannot open " + path;
+			return false;
+		}
+
+		struct stat status {};
+		if (fstat(descriptor, &status) != 0 || status.st_size == 0)
+		{
+			close(descriptor);
+			*error = "Cannot read " + path;
+			return false;
+		}
+
+		// The mapping stays valid after the descriptor is closed
+		const auto size = static_cast<std::size_t>(status.st_size);
+		const auto data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+		close(descriptor);
+		if (data == MAP_FAILED)
+		{
+			*error = "Cannot map " + path;
+			return false;
+		}
+
+		// Read front to back once
+		madvise(data, size, MADV_SEQUENTIAL);
+		this->m_data = static_cast<const char*>(data);
+		this->m_size = size;
+#endif
+		return true;
+	}
+
+	using FilePointer = std::unique_ptr<std::FILE, int(*)(std::FILE*)>;
+
+	FilePointer OpenForWriting(const std::string &path, std::string *error)
+	{
+		FilePointer file(std::fopen(path.c_str(), "wb"), &std::fclose);
+		if (file == nullptr)
+			*error = "Cannot write " + path;
+		return file;
+	}
+
+	std::uint64_t Align(const std::uint64_t offset)
+	{
+		return (offset + SectionAlignment - 1) / SectionAlignment * SectionAlignment;
+	}
+
+	// Checks if the dimensions fit an int cell id including the border; each side is bounded first so the product can't overflow
+	bool IsValidSize(const long long rows, const long long cols)
+	{
+		const auto maxSide = 0x7fffffffLL / 2;
+		return rows > 0 && cols > 0 && rows <= maxSide && cols <= maxSide && (rows + 2) * (cols + 2) <= 0x7fffffffLL;
+	}
+
+	// Puts a missing start on the first and a missing goal on the last open cell
+	void PlaceDefaultEnds(Grid *grid)
+	{
+		const auto begin = grid->GetStride();
+		const auto end = grid->GetCapacity() - grid->GetStride();
+		auto first = NO_CELL;
+		auto last = NO_CELL;
+		for (auto id = begin; id < end && first == NO_CELL; id++)
+		{
+			if (!grid->IsWall(id))
+				first = id;
+		}
+		for (auto id = end - 1; id >= begin && last == NO_CELL; id--)
+		{
+			if (!grid->IsWall(id))
+				last = id;
+		}
+
+		// Fully walled maps get the corners, which are opened
+		if (first == NO_CELL)
+		{
+			first = grid->GetId(0, 0);
+			last = grid->GetId(grid->GetRows() - 1, grid->GetCols() - 1);
+		}
+
+		if (grid->GetStart() == NO_CELL)
+			grid->SetStart(first);
+		if (grid->GetGoal() == NO_CELL)
+			grid->SetGoal(last);
+	}
+
+	bool LoadBinaryMap(const MappedFile &file, Grid *grid, std::string *metadata, std::string *error)
+	{
+		MapHeader header;
+		std::memcpy(&header, file.GetData(), sizeof(header));
+
+		if (header.version < 1 || header.version > MAP_FORMAT_VERSION)
+		{
+			*error = "Unsupported map version " + std::to_string(header.version);
+			return false;
+		}
+		if (!IsValidSize(header.rows, header.cols))
+		{
+			*error = "Invalid map size";
+			return false;
+		}
+
+		const auto cells = static_cast<long long>(header.rows) * header.cols;
+		if (header.start < -1 || header.start >= cells || header.goal < -1 || header.goal >= cells)
+		{
+			*error = "Start or goal outside the map";
+			return false;
+		}
+
+		// Every section has to lie inside the file
+		const auto capacity = static_cast<std::uint64_t>(header.rows + 2) * (header.cols + 2);
+		const auto wallBytes = (capacity + 63) / 64 * sizeof(GridWord);
+		const auto fits = [&](const std::uint64_t offset, const std::uint64_t size)
+		{
+			return offset >= sizeof(MapHeader) && offset <= file.GetSize() && size <= file.GetSize() - offset;
+		};
+		const auto hasCosts = (header.sections & MAP_SECTION_COSTS) != 0;
+		const auto hasMetadata = (header.sections & MAP_SECTION_METADATA) != 0;
+		if (!fits(header.wallsOffset, wallBytes) || header.wallsOffset % sizeof(GridWord) != 0
+			|| (hasCosts && !fits(header.costsOffset, capacity))
+			|| (hasMetadata && !fits(header.metadataOffset, header.metadataSize)))
+		{
+			*error = "Truncated map file";
+			return false;
+		}
+
+		grid->Resize(header.rows, header.cols);
+		if (header.start >= 0)
+			grid->SetStart(grid->GetId(header.start / header.cols, header.start % header.cols));
+		if (header.goal >= 0)
+			grid->SetGoal(grid->GetId(header.goal / header.cols, header.goal % header.cols));
+
+		// Straight from the mapping, the words are already in the grid's layout
+		grid->SetWallWords(reinterpret_cast<const GridWord*>(file.GetData() + header.wallsOffset));
+		if (hasCosts)
+			grid->SetCostData(reinterpret_cast<const CellCost*>(file.GetData() + header.costsOffset));
+
+		if (metadata != nullptr)
+		{
+			metadata->clear();
+			if (hasMetadata)
+				metadata->assign(file.GetData() + header.metadataOffset, header.metadataSize);
+		}
+
+		PlaceDefaultEnds(grid);
+		return true;
+	}
+
+	// Reads the next line without its line break, returns false at the end of the text
+	bool NextLine(const char **cursor, const char *end, const char **line, std::size_t *length)
+	{
+		if (*cursor >= end)
+			return false;
+
+		*line = *cursor;
+		const auto lineEnd = static_cast<const char*>(std::memchr(*cursor, '\n', end - *cursor));
+		*cursor = lineEnd == nullptr ? end : lineEnd + 1;
+		*length = (lineEnd == nullptr ? end : lineEnd) - *line;
+
+		if (*length > 0 && (*line)[*length - 1] == '\r')
+			(*length)--;
+		return true;
+	}
+
+	bool ParseMovingAiMap(const char *text, const std::size_t size, Grid *grid, std::string *error)
+	{
+		const auto end = text + size;
+		auto cursor = text;
+		const char *line = nullptr;
+		std::size_t length = 0;
+		long long rows = -1;
+		long long cols = -1;
+
+		// Header lines up to "map"
+		while (true)
+		{
+			if (!NextLine(&cursor, end, &line, &length))
+			{
+				*error = "Missing map section";
+				return false;
+			}
+
+			const std::string header(line, length);
+			if (header == "map")
+				break;
+
+			// strtoll saturates out-of-range numbers, which IsValidSize then rejects
+			if (header.compare(0, 7, "height ") == 0)
+				rows = std::strtoll(header.c_str() + 7, nullptr, 10);
+			else if (header.compare(0, 6, "width ") == 0)
+				cols = std::strtoll(header.c_str() + 6, nullptr, 10);
+		}
+
+		if (!IsValidSize(rows, cols))
+		{
+			*error = "Invalid map size";
+			return false;
+		}
+
+		// Walls are collected in the grid's word layout and handed over at once
+		grid->Resize(static_cast<int>(rows), static_cast<int>(cols));
+		std::vector<GridWord> walls(grid->GetWordCount(), 0);
+		for (auto row = 0; row < rows; row++)
+		{
+			if (!NextLine(&cursor, end, &line, &length) || length < static_cast<std::size_t>(cols))
+			{
+				*error = "Map row " + std::to_string(row) + " is missing or too short";
+				return false;
+			}
+
+			const auto first = grid->GetId(row, 0);
+			for (auto col = 0; col < cols; col++)
+			{
+				const auto terrain = line[col];
+				const auto id = first + col;
+				if (terrain != '.' && terrain != 'G' && terrain != 'S')
+					walls[id >> 6] |= GridWord(1) << (id & 63);
+			}
+		}
+		grid->SetWallWords(walls.data());
+
+		PlaceDefaultEnds(grid);
+		return true;
+	}
+}
+
+bool LoadMap(const std::string &path, Grid *grid, std::string *metadata, std::string *error)
+{
+	MappedFile file;
+	if (!file.Open(path, error))
+		return false;
+
+	if (file.GetSize() >= sizeof(MapHeader) && std::memcmp(file.GetData(), MapMagic, sizeof(MapMagic)) == 0)
+		return LoadBinaryMap(file, grid, metadata, error);
+
+	if (metadata != nullptr)
+		metadata->clear();
+	return ParseMovingAiMap(file.GetData(), file.GetSize(), grid, error);
+}
+
+bool SaveMap(const std::string &path, const Grid &grid, const std::string &metadata, std::string *error)
+{
+	const auto file = OpenForWriting(path, error);
+	if (file == nullptr)
+		return false;
+
+	const auto wallBytes = static_cast<std::uint64_t>(grid.GetWordCount()) * sizeof(GridWord);
+	const auto costBytes = grid.IsUniformCost() ? 0 : static_cast<std::uint64_t>(grid.GetCapacity());
+
+	MapHeader header {};
+	std::memcpy(header.magic, MapMagic, sizeof(MapMagic));
+	header.version = MAP_FORMAT_VERSION;
+	header.sections = (costBytes > 0 ? MAP_SECTION_COSTS : 0) | (metadata.empty() ? 0 : MAP_SECTION_METADATA);
+	header.rows = grid.GetRows();
+	header.cols = grid.GetCols();
+	header.start = grid.GetStart() == NO_CELL ? -1 : grid.GetCellNumber(grid.GetStart());
+	header.goal = grid.GetGoal() == NO_CELL ? -1 : grid.GetCellNumber(grid.GetGoal());
+	header.wallsOffset = Align(sizeof(MapHeader));
+	auto end = header.wallsOffset + wallBytes;
+	if (costBytes > 0)
+	{
+		header.costsOffset = Align(end);
+		end = header.costsOffset + costBytes;
+	}
+	if (!metadata.empty())
+		header.metadataOffset = Align(end);
+	header.metadataSize = metadata.size();
+
+	// Sections in order, zero padded to their offsets
+	const char padding[SectionAlignment] = {};
+	std::uint64_t offset = 0;
+	const auto write = [&](const std::uint64_t at, const void *data, const std::uint64_t size)
+	{
+		const auto ok = std::fwrite(padding, 1, at - offset, file.get()) == at - offset
+			&& std::fwrite(data, 1, size, file.get()) == size;
+		offset = at + size;
+		return ok;
+	};
+
+	auto ok = write(0, &header, sizeof(header))
+		&& write(header.wallsOffset, grid.GetWallWords(), wallBytes);
+	if (ok && costBytes > 0)
+		ok = write(header.costsOffset, grid.GetCostData(), costBytes);
+	if (ok && !metadata.empty())
+		ok = write(header.metadataOffset, metadata.data(), metadata.size());
+
+	if (!ok || std::fflush(file.get()) != 0)
+	{
+		*error = "Cannot write " + path;
+		return false;
+	}
+	return true;
+}
+
+bool ImportMovingAiMap(const std::string &path, Grid *grid, std::string *error)
+{
+	MappedFile file;
+	if (!file.Open(path, error))
+		return false;
+	return ParseMovingAiMap(file.GetData(), file.GetSize(), grid, error);
+}
+
+bool ExportMovingAiMap(const std::string &path, const Grid &grid, std::string *error)
+{
+	const auto file = OpenForWriting(path, error);
+	if (file == nullptr)
+		return false;
+
+	auto ok = std::fprintf(file.get(), "type octile\nheight %d\nwidth %d\nmap\n", grid.GetRows(), grid.GetCols()) > 0;
+
+	// One row at a time
+	std::string line(static_cast<std::size_t>(grid.GetCols()) + 1, '\n');
+	for (auto row = 0; ok && row < grid.GetRows(); row++)
+	{
+		for (auto col = 0; col < grid.GetCols(); col++)
+			line[col] = grid.IsWall(grid.GetId(row, col)) ? '@' : '.';
+		ok = std::fwrite(line.data(), 1, line.size(), file.get()) == line.size();
+	}
+
+	if (!ok || std::fflush(file.get()) != 0)
+	{
+		*error = "Cannot write " + path;
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,501 @@
+#include "MapGenerator.h"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+#include "ThreadPool.h"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace
+{
+	// Maps smaller than this are generated on the calling thread
+	const int ParallelCells = 1 << 18;
+
+	// Chambers of a maze divided up front for every thread to take from
+	const int ChambersPerThread = 16;
+
+	// Separates the stream of the links between rooms from the one of the rooms
+	const std::uint64_t LinkSalt = 0x6a09e667f3bcc909ULL;
+
+	// Walls of a map row by row with the grid's border around the cells, in padded rows and
+	// columns: map cell (row, col) is bit col + 1 of row row + 1, and every row starts on a word
+	struct WallRows
+	{
+		WallRows(const int rows, const int cols)
+			: rows(rows)
+			, cols(cols)
+			, rowWords((cols + 2 + 63) / 64)
+			, words(static_cast<std::size_t>(rows + 2) * rowWords, 0)
+		{
+		}
+
+		GridWord *GetRow(const int row)
+		{
+			return &this->words[static_cast<std::size_t>(row) * this->rowWords];
+		}
+
+		int rows;
+		int cols;
+		int rowWords;
+		std::vector<GridWord> words;
+	};
+
+	// Open area of a maze still to be divided, [top, bottom) x [left, right) in map cells
+	struct Chamber
+	{
+		int top;
+		int left;
+		int bottom;
+		int right;
+	};
+
+	// Room of a rooms layout in map cells, same bounds as a chamber
+	struct Room
+	{
+		int top;
+		int left;
+		int bottom;
+		int right;
+
+		int GetCenterRow() const { return (this->top + this->bottom - 1) / 2; }
+		int GetCenterCol() const { return (this->left + this->right - 1) / 2; }
+	};
+
+	// Sets or clears bits of a word other threads may write as well
+	void SetSharedBits(GridWord *word, const GridWord bits, const bool set)
+	{
+#ifdef _MSC_VER
+		static_assert(sizeof(GridWord) == sizeof(__int64), "wall words must be 64-bit");
+		const auto volatileWord = reinterpret_cast<volatile __int64*>(word);
+		set ? _InterlockedOr64(volatileWord, static_cast<__int64>(bits)) : _InterlockedAnd64(volatileWord, static_cast<__int64>(~bits));
+#else
+		set ? __atomic_fetch_or(word, bits, __ATOMIC_RELAXED) : __atomic_fetch_and(word, ~bits, __ATOMIC_RELAXED);
+#endif
+	}
+
+	// Maps 32 random bits to [0, count) with a multiplication instead of a division
+	inline int PickBelow(const std::uint32_t random, const int count)
+	{
+		return static_cast<int>((static_cast<std::uint64_t>(random) * static_cast<std::uint32_t>(count)) >> 32);
+	}
+
+	// Walls or opens the padded columns [first, last) of a padded row, safe across threads
+	void FillRun(WallRows *walls, const int row, const int first, const int last, const bool wall)
+	{
+		const auto words = walls->GetRow(row);
+		for (auto col = first; col < last;)
+		{
+			const auto word = col >> 6;
+			const auto end = std::min(last, (word + 1) << 6);
+			const auto high = end - (word << 6);
+			const auto bits = (high == 64 ? ~GridWord(0) : (GridWord(1) << high) - 1) & ~((GridWord(1) << (col & 63)) - 1);
+			SetSharedBits(&words[word], bits, wall);
+			col = end;
+		}
+	}
+
+	// Walls the border rows and columns, and the bits past the last column
+	void WallBorder(WallRows *walls)
+	{
+		for (auto row = 0; row < walls->rows + 2; row++)
+		{
+			const auto words = walls->GetRow(row);
+			if (row == 0 || row == walls->rows + 1)
+			{
+				std::fill(words, words + walls->rowWords, ~GridWord(0));
+				continue;
+			}
+			words[0] |= 1;
+			FillRun(walls, row, walls->cols + 1, walls->rowWords * 64, true);
+		}
+	}
+
+	// Runs fn(first, last) over consecutive bands of [0, count), one per worker
+	template <typename Fn>
+	void ForEachBand(ThreadPool *pool, const int count, const Fn &fn)
+	{
+		if (pool == nullptr)
+		{
+			fn(0, count);
+			return;
+		}
+
+		const auto workers = pool->GetThreadCount();
+		pool->Run([&](const int worker)
+		{
+			fn(static_cast<int>(static_cast<std::int64_t>(count) * worker / workers),
+				static_cast<int>(static_cast<std::int64_t>(count) * (worker + 1) / workers));
+		});
+	}
+
+	// Fills every word with random walls, word i drawing from counter i
+	void FillNoise(WallRows *walls, const std::uint64_t seed, const double density, ThreadPool *pool)
+	{
+		const auto level = GetWallLevel(density);
+		ForEachBand(pool, walls->rows + 2, [&](const int first, const int last)
+		{
+			const auto begin = static_cast<std::size_t>(first) * walls->rowWords;
+			const auto end = static_cast<std::size_t>(last) * walls->rowWords;
+			for (auto index = begin; index < end; index++)
+				walls->words[index] = GetRandomWallWord(seed, index, level);
+		});
+	}
+
+	// Adds one bit per cell to four-bit counters held as bit planes, lowest plane first
+	inline void AddPlane(GridWord bits, GridWord *counts)
+	{
+		for (auto plane = 0; plane < 4; plane++)
+		{
+			const auto carry = counts[plane] & bits;
+			counts[plane] ^= bits;
+			bits = carry;
+		}
+	}
+
+	// Opens an L-shaped corridor in map cells, along the row of from first, then along the column of to
+	void CarveCorridor(WallRows *walls, const int fromRow, const int fromCol, const int toRow, const int toCol)
+	{
+		FillRun(walls, fromRow + 1, std::min(fromCol, toCol) + 1, std::max(fromCol, toCol) + 2, false);
+		for (auto row = std::min(fromRow, toRow); row <= std::max(fromRow, toRow); row++)
+			FillRun(walls, row + 1, toCol + 1, toCol + 2, false);
+	}
+
+	/*
+	 * Caves
+	 *
+	 * Start from noise and apply the 4-5 rule a few times: a cell becomes a
+	 * wall if at least five of the nine cells of its 3x3 block are. The nine
+	 * counts of 64 cells are summed at once with bit-sliced adders on whole
+	 * words, the east and west neighbors are the row words shifted by a bit.
+	 */
+	void GenerateCaves(WallRows *walls, const GeneratorOptions &options, Grid *grid, ThreadPool *pool)
+	{
+		FillNoise(walls, options.seed, options.caveDensity, pool);
+		WallBorder(walls);
+
+		// Walls of the border columns and the bits past them, per word of a row
+		WallRows edges(1, walls->cols);
+		WallBorder(&edges);
+		const auto edge = edges.GetRow(1);
+
+		auto next = *walls;
+		const auto rowWords = walls->rowWords;
+		for (auto step = 0; step < options.caveSteps; step++)
+		{
+			ForEachBand(pool, walls->rows, [&](const int first, const int last)
+			{
+				for (auto row = first + 1; row < last + 1; row++)
+				{
+					const GridWord *source[3] = { walls->GetRow(row - 1), walls->GetRow(row), walls->GetRow(row + 1) };
+					const auto target = next.GetRow(row);
+					for (auto word = 0; word < rowWords; word++)
+					{
+						GridWord counts[4] = {};
+						for (const auto cells : source)
+						{
+							const auto center = cells[word];
+							const auto before = word > 0 ? cells[word - 1] : ~GridWord(0);
+							const auto after = word + 1 < rowWords ? cells[word + 1] : ~GridWord(0);
+							AddPlane(center, counts);
+							AddPlane((center << 1) | (before >> 63), counts);
+							AddPlane((center >> 1) | (after << 63), counts);
+						}
+
+						// Five to nine walls: 0101, 0110, 0111, 1000, 1001
+						target[word] = counts[3] | (counts[2] & (counts[1] | counts[0])) | edge[word];
+					}
+				}
+			});
+			std::swap(walls->words, next.words);
+		}
+
+		// Start and goal, often sealed in a corner, get a corridor to the center, so they meet
+		// whichever pockets the smoothing left them in
+		for (const auto id : { grid->GetStart(), grid->GetGoal() })
+		{
+			if (id != NO_CELL)
+				CarveCorridor(walls, grid->GetRow(id), grid->GetCol(id), walls->rows / 2, walls->cols / 2);
+		}
+		WallBorder(walls);
+	}
+
+	// Draws one wall across a chamber, with a gap, and adds the two halves to the list;
+	// returns false if the chamber is too small to divide. The chamber's corner and size
+	// seed its random word, so the maze doesn't depend on the order chambers are divided in
+	bool DivideChamber(WallRows *walls, const std::uint64_t seed, const Chamber &chamber, std::vector<Chamber> *chambers)
+	{
+		const auto height = chamber.bottom - chamber.top;
+		const auto width = chamber.right - chamber.left;
+		// A wall across a single row or column would be all gap
+		if ((height < 3 && width < 3) || height == 1 || width == 1)
+			return false;
+
+		const auto corner = GetRandomWord(seed, (static_cast<std::uint64_t>(chamber.top) << 32) | static_cast<std::uint32_t>(chamber.left));
+		const auto random = GetRandomWord(corner, (static_cast<std::uint64_t>(height) << 32) | static_cast<std::uint32_t>(width));
+
+		// Cut across the longer side, either way for squares
+		const auto horizontal = width < 3 || (height >= 3 && (height > width || (height == width && (random & 1) != 0)));
+		const auto length = horizontal ? height : width;
+		const auto across = horizontal ? width : height;
+
+		// Chambers start on even rows and columns, walls go on odd ones and gaps on even ones,
+		// so no wall ever closes the gap of another
+		const auto wall = 1 + 2 * PickBelow(static_cast<std::uint32_t>(random >> 1), (length - 1) / 2);
+		const auto gap = 2 * PickBelow(static_cast<std::uint32_t>(random >> 32), (across + 1) / 2);
+
+		if (horizontal)
+		{
+			const auto row = chamber.top + wall;
+			const auto gapCol = chamber.left + gap;
+			FillRun(walls, row + 1, chamber.left + 1, gapCol + 1, true);
+			FillRun(walls, row + 1, gapCol + 2, chamber.right + 1, true);
+			chambers->push_back({ chamber.top, chamber.left, row, chamber.right });
+			chambers->push_back({ row + 1, chamber.left, chamber.bottom, chamber.right });
+		}
+		else
+		{
+			// One bit in the same word of every row
+			const auto col = chamber.left + wall;
+			const auto word = (col + 1) >> 6;
+			const auto bit = GridWord(1) << ((col + 1) & 63);
+			for (auto row = chamber.top; row < chamber.bottom; row++)
+			{
+				if (row != chamber.top + gap)
+					SetSharedBits(&walls->GetRow(row + 1)[word], bit, true);
+			}
+			chambers->push_back({ chamber.top, chamber.left, chamber.bottom, col });
+			chambers->push_back({ chamber.top, col + 1, chamber.bottom, chamber.right });
+		}
+		return true;
+	}
+
+	/*
+	 * Recursive division maze
+	 *
+	 * Start from an open map and divide it with a wall that has a single gap,
+	 * then divide both halves the same way until they are at most two cells
+	 * across. On maps of odd size every open cell is reachable from every
+	 * other one by exactly one route, an even size leaves a few loops along
+	 * the last row and column. The first divisions run breadth first until there are enough
+	 * chambers, the threads then take whole chambers and divide them depth
+	 * first on their own.
+	 */
+	void GenerateMaze(WallRows *walls, const GeneratorOptions &options, ThreadPool *pool)
+	{
+		std::vector<Chamber> chambers = { { 0, 0, walls->rows, walls->cols } };
+		const auto workers = pool != nullptr ? pool->GetThreadCount() : 1;
+		const auto wanted = workers > 1 ? static_cast<std::size_t>(workers) * ChambersPerThread : 0;
+
+		std::vector<Chamber> divided;
+		while (chambers.size() < wanted)
+		{
+			divided.clear();
+			for (const auto &chamber : chambers)
+				DivideChamber(walls, options.seed, chamber, &divided);
+			if (divided.empty())
+				break;
+			std::swap(chambers, divided);
+		}
+
+		std::atomic<std::size_t> next(0);
+		const auto divide = [&](int)
+		{
+			std::vector<Chamber> stack;
+			for (auto index = next++; index < chambers.size(); index = next++)
+			{
+				stack.push_back(chambers[index]);
+				while (!stack.empty())
+				{
+					const auto chamber = stack.back();
+					stack.pop_back();
+					DivideChamber(walls, options.seed, chamber, &stack);
+				}
+			}
+		};
+		pool != nullptr ? pool->Run(divide) : divide(0);
+	}
+
+	// Room of a sector, one cell of wall from the sector's edges if the sector is large enough
+	Room GetRoom(const WallRows &walls, const std::uint64_t seed, const int sector, const int sectorRow, const int sectorCol)
+	{
+		const auto random = GetRandomWord(seed, (static_cast<std::uint64_t>(sectorRow) << 32) | static_cast<std::uint32_t>(sectorCol));
+
+		// Extent along one axis from 16 random bits for the size and 16 for the offset
+		const auto place = [&](const int begin, const int end, const int shift, int *first, int *last)
+		{
+			const auto extent = end - begin;
+			if (extent < 3)
+			{
+				*first = begin + extent / 2;
+				*last = *first + 1;
+				return;
+			}
+
+			const auto inner = extent - 2;
+			const auto smallest = std::max(1, inner / 2);
+			const auto size = smallest + PickBelow(static_cast<std::uint32_t>(random >> shift) << 16, inner - smallest + 1);
+			const auto offset = PickBelow(static_cast<std::uint32_t>(random >> (shift + 16)) << 16, inner - size + 1);
+			*first = begin + 1 + offset;
+			*last = *first + size;
+		};
+
+		Room room {};
+		place(sectorRow * sector, std::min((sectorRow + 1) * sector, walls.rows), 0, &room.top, &room.bottom);
+		place(sectorCol * sector, std::min((sectorCol + 1) * sector, walls.cols), 32, &room.left, &room.right);
+		return room;
+	}
+
+	/*
+	 * Rooms and corridors
+	 *
+	 * The map is cut into square sectors with one room each. Every room is
+	 * joined to the room east of it, and to the room south of it in the first
+	 * column and at random elsewhere, which keeps all rooms connected. The
+	 * threads take rows of sectors; rooms are computed from their sector
+	 * alone, so a neighbor's room is recomputed instead of shared.
+	 */
+	void GenerateRooms(WallRows *walls, const GeneratorOptions &options, Grid *grid, ThreadPool *pool)
+	{
+		std::fill(walls->words.begin(), walls->words.end(), ~GridWord(0));
+
+		const auto sector = std::max(options.roomSector, 1);
+		const auto sectorRows = (walls->rows + sector - 1) / sector;
+		const auto sectorCols = (walls->cols + sector - 1) / sector;
+
+		std::atomic<int> next(0);
+		const auto carve = [&](int)
+		{
+			for (auto sectorRow = next++; sectorRow < sectorRows; sectorRow = next++)
+			{
+				for (auto sectorCol = 0; sectorCol < sectorCols; sectorCol++)
+				{
+					const auto room = GetRoom(*walls, options.seed, sector, sectorRow, sectorCol);
+					for (auto row = room.top; row < room.bottom; row++)
+						FillRun(walls, row + 1, room.left + 1, room.right + 1, false);
+
+					if (sectorCol + 1 < sectorCols)
+					{
+						const auto east = GetRoom(*walls, options.seed, sector, sectorRow, sectorCol + 1);
+						CarveCorridor(walls, room.GetCenterRow(), room.GetCenterCol(), east.GetCenterRow(), east.GetCenterCol());
+					}
+
+					const auto link = GetRandomWord(options.seed ^ LinkSalt, static_cast<std::uint64_t>(sectorRow) * sectorCols + sectorCol);
+					if (sectorRow + 1 < sectorRows && (sectorCol == 0 || (link & 1) != 0))
+					{
+						const auto south = GetRoom(*walls, options.seed, sector, sectorRow + 1, sectorCol);
+						CarveCorridor(walls, south.GetCenterRow(), south.GetCenterCol(), room.GetCenterRow(), room.GetCenterCol());
+					}
+				}
+			}
+		};
+		pool != nullptr ? pool->Run(carve) : carve(0);
+
+		// Start and goal get a corridor to the room of their sector
+		for (const auto id : { grid->GetStart(), grid->GetGoal() })
+		{
+			if (id == NO_CELL)
+				continue;
+
+			const auto row = grid->GetRow(id);
+			const auto col = grid->GetCol(id);
+			const auto room = GetRoom(*walls, options.seed, sector, row / sector, col / sector);
+			CarveCorridor(walls, row, col, room.GetCenterRow(), room.GetCenterCol());
+		}
+		WallBorder(walls);
+	}
+
+	// Copies the walls into the grid's padded id layout, where rows don't start on a word
+	void StoreWalls(const WallRows &walls, Grid *grid)
+	{
+		std::vector<GridWord> words(grid->GetWordCount(), 0);
+		const auto stride = grid->GetStride();
+
+		for (auto row = 0; row < walls.rows + 2; row++)
+		{
+			const auto source = &walls.words[static_cast<std::size_t>(row) * walls.rowWords];
+			const auto first = static_cast<std::uint64_t>(row) * stride;
+			for (auto word = 0; word < walls.rowWords; word++)
+			{
+				auto bits = source[word];
+				const auto count = stride - word * 64;
+				if (count < 64)
+					bits &= (GridWord(1) << count) - 1;
+
+				const auto position = first + static_cast<std::uint64_t>(word) * 64;
+				const auto index = static_cast<std::size_t>(position >> 6);
+				const auto shift = static_cast<int>(position & 63);
+				words[index] |= bits << shift;
+				if (shift != 0 && index + 1 < words.size())
+					words[index + 1] |= bits >> (64 - shift);
+			}
+		}
+		grid->SetWallWords(words.data());
+	}
+}
+
+std::string GetMapLayoutName(const MapLayout layout)
+{
+	switch (layout)
+	{
+	case MapLayout::Maze:
+		return "maze";
+	case MapLayout::Caves:
+		return "caves";
+	case MapLayout::Rooms:
+		return "rooms";
+	case MapLayout::Uniform:
+	default:
+		return "uniform";
+	}
+}
+
+bool ParseMapLayout(const std::string &name, MapLayout *layout)
+{
+	for (const auto candidate : GetMapLayouts())
+	{
+		if (GetMapLayoutName(candidate) == name)
+		{
+			*layout = candidate;
+			return true;
+		}
+	}
+	return false;
+}
+
+const std::vector<MapLayout> &GetMapLayouts()
+{
+	static const std::vector<MapLayout> layouts = { MapLayout::Uniform, MapLayout::Maze, MapLayout::Caves, MapLayout::Rooms };
+	return layouts;
+}
+
+void GenerateMap(Grid *grid, const GeneratorOptions &options)
+{
+	const auto threads = grid->GetSize() < ParallelCells ? 1
+		: options.threads > 0 ? options.threads : ThreadPool::GetDefaultThreadCount();
+	std::unique_ptr<ThreadPool> pool;
+	if (threads > 1)
+		pool.reset(new ThreadPool(threads));
+
+	WallRows walls(grid->GetRows(), grid->GetCols());
+	switch (options.layout)
+	{
+	case MapLayout::Maze:
+		GenerateMaze(&walls, options, pool.get());
+		break;
+	case MapLayout::Caves:
+		GenerateCaves(&walls, options, grid, pool.get());
+		break;
+	case MapLayout::Rooms:
+		GenerateRooms(&walls, options, grid, pool.get());
+		break;
+	case MapLayout::Uniform:
+	default:
+		FillNoise(&walls, options.seed, options.density, pool.get());
+		break;
+	}
+	StoreWalls(walls, grid);
+}
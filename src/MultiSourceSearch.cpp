@@ -0,0 +1,189 @@
+#include "MultiSourceSearch.h"
+
+#include <algorithm>
+
+DistanceFields::DistanceFields(const int sources, const int capacity)
+	: m_sources(sources)
+	, m_capacity(capacity)
+	, m_distances(static_cast<std::size_t>((sources + SOURCES_PER_PASS - 1) / SOURCES_PER_PASS) * capacity * SOURCES_PER_PASS, NO_DISTANCE)
+{
+}
+
+int DistanceFields::GetSourceCount() const
+{
+	return this->m_sources;
+}
+
+int DistanceFields::GetCapacity() const
+{
+	return this->m_capacity;
+}
+
+int DistanceFields::GetDistance(const int source, const int id) const
+{
+	return this->m_distances[GetIndex(source, id)];
+}
+
+void DistanceFields::SetDistance(const int source, const int id, const int distance)
+{
+	this->m_distances[GetIndex(source, id)] = distance;
+}
+
+std::size_t DistanceFields::GetIndex(const int source, const int id) const
+{
+	const auto group = static_cast<std::size_t>(source / SOURCES_PER_PASS);
+	return (group * this->m_capacity + id) * SOURCES_PER_PASS + source % SOURCES_PER_PASS;
+}
+
+std::vector<int> DistanceFields::GetMatrix(const std::vector<int> &targets) const
+{
+	std::vector<int> matrix;
+	matrix.reserve(static_cast<std::size_t>(this->m_sources) * targets.size());
+
+	for (auto source = 0; source < this->m_sources; source++)
+	{
+		for (const auto target : targets)
+			matrix.push_back(target == NO_CELL ? NO_DISTANCE : GetDistance(source, target));
+	}
+	return matrix;
+}
+
+MultiSourceSearch::MultiSourceSearch(const Connectivity connectivity)
+	: m_connectivity(connectivity)
+{
+}
+
+void MultiSourceSearch::SetThreadCount(const int threads)
+{
+	this->m_threadCount = threads;
+}
+
+const SearchStats &MultiSourceSearch::GetStats() const
+{
+	return this->m_stats;
+}
+
+DistanceFields MultiSourceSearch::Run(const Grid *grid, const std::vector<int> &sources)
+{
+	const auto count = static_cast<int>(sources.size());
+	const auto batches = (count + SOURCES_PER_PASS - 1) / SOURCES_PER_PASS;
+	DistanceFields fields(count, grid->GetCapacity());
+	this->m_stats = SearchStats();
+
+	if (batches == 0)
+		return fields;
+
+	// No more threads than batches, reuse the pool while the count stays the same
+	const auto configured = this->m_threadCount > 0 ? this->m_threadCount : ThreadPool::GetDefaultThreadCount();
+	const auto threads = std::min(configured, batches);
+	if (this->m_pool == nullptr || this->m_pool->GetThreadCount() != threads)
+	{
+		this->m_pool.reset(new ThreadPool(threads));
+		this->m_states.assign(threads, LaneState());
+	}
+
+	std::atomic<int> nextBatch(0);
+	const auto job = [&](const int worker)
+	{
+		auto &state = this->m_states[worker];
+		state.stats = SearchStats();
+
+		for (auto batch = nextBatch.fetch_add(1); batch < batches; batch = nextBatch.fetch_add(1))
+		{
+			const auto first = batch * SOURCES_PER_PASS;
+			const auto size = std::min(SOURCES_PER_PASS, count - first);
+
+			DispatchConnectivity(this->m_connectivity, [&](auto policy)
+			{
+				RunBatch<decltype(policy)>(grid, sources, first, size, &state, &fields);
+			});
+		}
+	};
+
+	if (threads == 1)
+		job(0);
+	else
+		this->m_pool->Run(job);
+
+	for (const auto &state : this->m_states)
+	{
+		this->m_stats.expansions += state.stats.expansions;
+		this->m_stats.peakFrontier = std::max(this->m_stats.peakFrontier, state.stats.peakFrontier);
+	}
+	return fields;
+}
+
+template <typename Conn>
+void MultiSourceSearch::RunBatch(const Grid *grid, const std::vector<int> &sources, const int first, const int count,
+	LaneState *state, DistanceFields *fields) const
+{
+	const auto capacity = static_cast<std::size_t>(grid->GetCapacity());
+	const auto words = grid->GetWordCount();
+	auto &seen = state->seen;
+	auto &visit = state->visit;
+	auto &visitNext = state->visitNext;
+	seen.assign(capacity, 0);
+	visit.assign(capacity, 0);
+	visitNext.assign(capacity, 0);
+	state->frontier.assign(words, 0);
+	state->next.assign(words, 0);
+
+	// Starting points, sources on the same cell share it
+	std::size_t frontierSize = 0;
+	for (auto lane = 0; lane < count; lane++)
+	{
+		const auto source = sources[first + lane];
+		if (source == NO_CELL || grid->IsWall(source))
+			continue;
+
+		if (visit[source] == 0)
+			frontierSize++;
+		state->frontier[source >> 6] |= GridWord(1) << (source & 63);
+		visit[source] |= GridWord(1) << lane;
+		seen[source] |= GridWord(1) << lane;
+		fields->SetDistance(first + lane, source, 0);
+	}
+
+	for (auto distance = 1; frontierSize != 0; distance++)
+	{
+		state->stats.expansions += frontierSize;
+		state->stats.peakFrontier = std::max(state->stats.peakFrontier, frontierSize);
+		frontierSize = 0;
+
+		// Frontier cells in id order, so the lane words of neighbors stay in cache
+		for (auto word = 0; word < words; word++)
+		{
+			for (auto bits = state->frontier[word]; bits != 0; bits &= bits - 1)
+			{
+				const auto current = word * 64 + LowestBit(bits);
+				const auto lanes = visit[current];
+				visit[current] = 0;
+
+				Conn::ForEach(grid, current, [&](const int next, bool)
+				{
+					// Lanes reaching the neighbor for the first time
+					const auto reached = lanes & ~seen[next];
+					if (reached == 0)
+						return true;
+
+					if (visitNext[next] == 0)
+					{
+						state->next[next >> 6] |= GridWord(1) << (next & 63);
+						frontierSize++;
+					}
+					visitNext[next] |= reached;
+					seen[next] |= reached;
+
+					for (auto remaining = reached; remaining != 0; remaining &= remaining - 1)
+						fields->SetDistance(first + LowestBit(remaining), next, distance);
+					return true;
+				});
+			}
+			state->frontier[word] = 0;
+		}
+
+		// The next level becomes the frontier, the cleared lanes are the buffer of the one after
+		std::swap(visit, visitNext);
+		std::swap(state->frontier, state->next);
+	}
+}
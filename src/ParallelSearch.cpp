@@ -0,0 +1,179 @@
+#include "ParallelSearch.h"
+
+#include <algorithm>
+
+namespace
+{
+	// Frontier cells handed out at once
+	const std::size_t ChunkSize = 256;
+
+	// Smaller levels are expanded by the calling thread alone
+	const std::size_t ParallelThreshold = 4 * ChunkSize;
+}
+
+template <typename Conn>
+void ParallelSearch<Conn>::SetThreadCount(const int threads)
+{
+	this->m_threadCount = threads;
+}
+
+template <typename Conn>
+void ParallelSearch<Conn>::Start(Grid *grid)
+{
+	SearchEngine::Start(grid);
+
+	// Reuse the pool while the thread count stays the same
+	const auto threads = this->m_threadCount > 0 ? this->m_threadCount : ThreadPool::GetDefaultThreadCount();
+	if (this->m_pool == nullptr || this->m_pool->GetThreadCount() != threads)
+	{
+		this->m_pool.reset(new ThreadPool(threads));
+		this->m_ranges.reset(new ChunkRange[threads]);
+	}
+	this->m_local.assign(threads, std::vector<int>());
+	this->m_frontier.clear();
+	this->m_distance = 0;
+	this->m_goalFound = false;
+
+	// Starting point
+	const auto start = grid->GetStart();
+	grid->SetVisited(start, true);
+	grid->SetDistance(start, 0);
+	this->m_frontier.push_back(start);
+
+	if (start == grid->GetGoal())
+		Finish(start);
+}
+
+template <typename Conn>
+bool ParallelSearch<Conn>::Step()
+{
+	if (this->m_finished)
+		return false;
+
+	if (this->m_frontier.empty())
+	{
+		Finish(NO_CELL); // Goal NOT found
+		return false;
+	}
+
+	const auto frontier = this->m_frontier.size();
+	const auto distance = this->m_distance + 1;
+
+	this->m_stats.expansions += frontier;
+	if (this->m_trace != nullptr)
+		this->m_trace->insert(this->m_trace->end(), this->m_frontier.begin(), this->m_frontier.end());
+
+	for (auto &local : this->m_local)
+		local.clear();
+
+	const auto threads = this->m_pool->GetThreadCount();
+	if (threads == 1 || frontier < ParallelThreshold)
+	{
+		this->m_stats.neighborChecks += ExpandRange(0, 0, frontier, distance);
+	}
+	else
+	{
+		// Hand every worker an even share of the chunks
+		const auto chunks = (frontier + ChunkSize - 1) / ChunkSize;
+		for (auto worker = 0; worker < threads; worker++)
+		{
+			this->m_ranges[worker].next.store(chunks * worker / threads, std::memory_order_relaxed);
+			this->m_ranges[worker].end = chunks * (worker + 1) / threads;
+		}
+
+		std::atomic<std::uint64_t> checks(0);
+		this->m_pool->Run([&](const int worker)
+		{
+			std::size_t chunk;
+			std::uint64_t workerChecks = 0;
+			while (!this->m_goalFound.load(std::memory_order_relaxed) && ClaimChunk(worker, &chunk))
+			{
+				const auto begin = chunk * ChunkSize;
+				workerChecks += ExpandRange(worker, begin, std::min(frontier, begin + ChunkSize), distance);
+			}
+			checks.fetch_add(workerChecks, std::memory_order_relaxed);
+		});
+		this->m_stats.neighborChecks += checks.load(std::memory_order_relaxed);
+	}
+
+	// Gather the next level
+	this->m_frontier.clear();
+	for (const auto &local : this->m_local)
+		this->m_frontier.insert(this->m_frontier.end(), local.begin(), local.end());
+
+	if (this->m_frontier.size() > this->m_stats.peakFrontier)
+		this->m_stats.peakFrontier = this->m_frontier.size();
+	this->m_distance = distance;
+
+	if (this->m_goalFound)
+	{
+		Finish(this->m_grid->GetGoal()); // Goal found
+		return false;
+	}
+	return true;
+}
+
+template <typename Conn>
+std::uint64_t ParallelSearch<Conn>::ExpandRange(const int worker, const std::size_t begin, const std::size_t end, const int distance)
+{
+	const auto grid = this->m_grid;
+	const auto goal = grid->GetGoal();
+	auto &next = this->m_local[worker];
+	std::uint64_t checks = 0;
+
+	for (auto i = begin; i < end; i++)
+	{
+		const auto current = this->m_frontier[i];
+
+		Conn::ForEach(grid, current, [&](const int adjacent, bool)
+		{
+			checks++;
+
+			// Only the thread that sets the visited bit owns the cell
+			if (!grid->ClaimVisited(adjacent))
+				return true;
+
+			grid->SetPrevious(adjacent, current);
+			grid->SetDistance(adjacent, distance);
+			next.push_back(adjacent);
+
+			if (adjacent == goal)
+				this->m_goalFound.store(true, std::memory_order_relaxed);
+			return true;
+		});
+	}
+	return checks;
+}
+
+template <typename Conn>
+std::size_t ParallelSearch<Conn>::GetAllocatedBytes() const
+{
+	auto bytes = SearchEngine::GetAllocatedBytes() + GetBufferBytes(this->m_frontier) + GetBufferBytes(this->m_local);
+	for (const auto &local : this->m_local)
+		bytes += GetBufferBytes(local);
+	return bytes;
+}
+
+template <typename Conn>
+bool ParallelSearch<Conn>::ClaimChunk(const int worker, std::size_t *chunk)
+{
+	const auto threads = this->m_pool->GetThreadCount();
+
+	// Own share first, then steal from the others
+	for (auto offset = 0; offset < threads; offset++)
+	{
+		auto &range = this->m_ranges[(worker + offset) % threads];
+		if (range.next.load(std::memory_order_relaxed) >= range.end)
+			continue;
+
+		const auto claimed = range.next.fetch_add(1, std::memory_order_relaxed);
+		if (claimed < range.end)
+		{
+			*chunk = claimed;
+			return true;
+		}
+	}
+	return false;
+}
+
+INSTANTIATE_ENGINE(ParallelSearch)
@@ -0,0 +1,962 @@
+/*
+ * Path query service for other processes on the same host.
+ *
+ * Loads or generates a map once and answers start/goal queries as JSON lines,
+ * read from stdin and written to stdout, or exchanged with any number of
+ * clients over a Unix domain socket. A request is one object per line:
+ *
+ *   {"id": 1, "start": [row, col], "goal": [row, col], "engine": "astar", "path": true}
+ *
+ * where engine defaults to --engine and path to true; the reply echoes the id:
+ *
+ *   {"id": 1, "found": true, "moves": 12, "path": [[row, col], ...], "expansions": 40, "shared": false, "us": 35.2}
+ *
+ * {"stats": true} replies with the number of answered queries and their p50
+ * and p99 latency in microseconds, measured from the arrival of a request to
+ * its reply. Malformed requests get {"id": ..., "error": "..."}.
+ *
+ * The map can be edited while it's being searched:
+ *
+ *   {"id": 2, "wall": [row, col], "set": true}
+ *   {"id": 3, "cost": [row, col], "value": 5}
+ *
+ * Edits and queries are served in the order they arrived: an edit is
+ * published as a new version of the map once the queries that came before it
+ * are answered, and replied to with {"id": 2, "version": 7}. So a query sees
+ * exactly the edits that arrived before it, and its reply carries the version
+ * it was answered on.
+ *
+ * Requests that arrive while a batch is being served form the next batch.
+ * The queries between two edits of a batch are spread over a thread pool. Each thread pins the current version of
+ * the map without taking a lock, brings its own copy of the grid up to it,
+ * and searches that copy with the same engines as the GUI and the benchmark.
+ * Breadth-first queries of a batch that share a start share one multi-source
+ * BFS pass over their goals: the pass floods the copy from every goal at once,
+ * and each path follows the falling distances of its goal from the start.
+ *
+ * Usage: BFS-DFS-Daemon (--map FILE | --size RxC [--layout L] [--density D] [--seed S]) [--socket PATH] [--engine NAME] [--connectivity C]
+ *                       [--threads N] [--batch-memory MiB]
+ */
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "Grid.h"
+#include "GridStore.h"
+#include "MapFile.h"
+#include "MapGenerator.h"
+#include "MultiSourceSearch.h"
+#include "SearchEngine.h"
+#include "ThreadPool.h"
+
+namespace
+{
+	using Clock = std::chrono::steady_clock;
+
+	// Latencies kept for the percentiles, the oldest are replaced first
+	const std::size_t LatencyWindow = 1 << 16;
+
+	// Engines whose paths have the fewest moves, which a multi-source BFS pass reproduces
+	const std::vector<std::string> BreadthFirstEngines = { "bfs", "dobfs", "pbfs", "bibfs", "wavefront" };
+
+	struct DaemonOptions
+	{
+		std::string map;
+		int rows = 0;
+		int cols = 0;
+		MapLayout layout = MapLayout::Uniform;
+		double density = 0.33;
+		unsigned seed = 1;
+		std::string socket;
+		std::string engine = "astar";
+		Connectivity connectivity = Connectivity::Four;
+		int threads = 0;
+		std::size_t batchMemory = 64;
+	};
+
+	void PrintUsage(const char *program)
+	{
+		std::fprintf(stderr,
+			"Usage: %s (--map FILE | --size RxC [--layout L] [--density D] [--seed S]) [--socket PATH] [--engine NAME] [--connectivity C]\n"
+			"          [--threads N] [--batch-memory MiB]\n"
+			"  --map FILE          binary or MovingAI map to answer queries on\n"
+			"  --size RxC          generate a map of R rows and C columns instead\n"
+			"  --layout L          generated map: uniform, maze, caves or rooms, default uniform\n"
+			"  --density D         probability of a cell being a wall in uniform maps, default 0.33\n"
+			"  --seed S            seed of the map generator, default 1\n"
+			"  --socket PATH       serve clients on a Unix domain socket instead of stdin/stdout\n"
+			"  --engine NAME       engine of requests that don't name one, default astar\n"
+			"  --connectivity C    4, 8, 8nc (no corner cutting) or hex, default 4\n"
+			"  --threads N         threads serving a batch, default one per core\n"
+			"  --batch-memory MiB  largest distance fields of a shared multi-source pass, default 64\n"
+			"Requests are JSON lines {\"id\": 1, \"start\": [row, col], \"goal\": [row, col], \"engine\": \"astar\", \"path\": true};\n"
+			"{\"stats\": true} reports the p50/p99 latency in microseconds; {\"wall\": [row, col], \"set\": true} and\n"
+			"{\"cost\": [row, col], \"value\": N} edit the map.\n",
+			program);
+	}
+
+	bool ParseOptions(const int argc, char *argv[], DaemonOptions *options)
+	{
+		for (auto i = 1; i < argc; i++)
+		{
+			const std::string arg = argv[i];
+			const auto hasValue = i + 1 < argc;
+
+			if (arg == "--map" && hasValue)
+			{
+				options->map = argv[++i];
+			}
+			else if (arg == "--size" && hasValue)
+			{
+				if (std::sscanf(argv[++i], "%dx%d", &options->rows, &options->cols) != 2 || options->rows < 1 || options->cols < 1)
+					return false;
+			}
+			else if (arg == "--layout" && hasValue)
+			{
+				if (!ParseMapLayout(argv[++i], &options->layout))
+					return false;
+			}
+			else if (arg == "--density" && hasValue)
+			{
+				options->density = std::atof(argv[++i]);
+			}
+			else if (arg == "--seed" && hasValue)
+			{
+				options->seed = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+			}
+			else if (arg == "--socket" && hasValue)
+			{
+				options->socket = argv[++i];
+			}
+			else if (arg == "--engine" && hasValue)
+			{
+				options->engine = argv[++i];
+			}
+			else if (arg == "--connectivity" && hasValue)
+			{
+				if (!ParseConnectivity(argv[++i], &options->connectivity))
+					return false;
+			}
+			else if (arg == "--threads" && hasValue)
+			{
+				options->threads = std::atoi(argv[++i]);
+			}
+			else if (arg == "--batch-memory" && hasValue)
+			{
+				options->batchMemory = static_cast<std::size_t>(std::strtoull(argv[++i], nullptr, 10));
+			}
+			else
+			{
+				return false;
+			}
+		}
+
+		const auto &names = GetSearchEngineNames();
+		if (std::find(names.begin(), names.end(), options->engine) == names.end())
+			return false;
+		return options->map.empty() != (options->rows == 0);
+	}
+
+	// Value of a request field: a string, a number, true/false/null, or an array of numbers
+	struct JsonValue
+	{
+		std::string text;
+		std::vector<double> numbers;
+		bool isString = false;
+		bool isArray = false;
+	};
+
+	// Reads one flat JSON object, nested objects are not part of the protocol
+	bool ParseJsonObject(const std::string &line, std::map<std::string, JsonValue> *fields)
+	{
+		std::size_t at = 0;
+		const auto skip = [&]
+		{
+			while (at < line.size() && std::isspace(static_cast<unsigned char>(line[at])))
+				at++;
+		};
+		const auto parseString = [&](std::string *text)
+		{
+			if (at >= line.size() || line[at] != '"')
+				return false;
+			for (at++; at < line.size() && line[at] != '"'; at++)
+			{
+				if (line[at] == '\\' && ++at >= line.size())
+					return false;
+				*text += line[at];
+			}
+			return at++ < line.size();
+		};
+		const auto parseNumber = [&](double *number)
+		{
+			const auto begin = line.c_str() + at;
+			char *end = nullptr;
+			*number = std::strtod(begin, &end);
+			at += static_cast<std::size_t>(end - begin);
+			return end != begin;
+		};
+
+		skip();
+		if (at >= line.size() || line[at++] != '{')
+			return false;
+		skip();
+		if (at < line.size() && line[at] == '}')
+			return true;
+
+		while (at < line.size())
+		{
+			std::string key;
+			JsonValue value;
+			skip();
+			if (!parseString(&key))
+				return false;
+			skip();
+			if (at >= line.size() || line[at++] != ':')
+				return false;
+			skip();
+
+			const auto begin = at;
+			if (at < line.size() && line[at] == '"')
+			{
+				value.isString = true;
+				if (!parseString(&value.text))
+					return false;
+			}
+			else if (at < line.size() && line[at] == '[')
+			{
+				value.isArray = true;
+				at++;
+				skip();
+				while (at < line.size() && line[at] != ']')
+				{
+					double number;
+					if (!parseNumber(&number))
+						return false;
+					value.numbers.push_back(number);
+					skip();
+					if (at < line.size() && line[at] == ',')
+						at++;
+					skip();
+				}
+				if (at++ >= line.size())
+					return false;
+			}
+			else
+			{
+				while (at < line.size() && line[at] != ',' && line[at] != '}' && !std::isspace(static_cast<unsigned char>(line[at])))
+					at++;
+				if (at == begin)
+					return false;
+			}
+
+			// Ids are echoed the way they were written
+			if (!value.isString)
+				value.text = line.substr(begin, at - begin);
+			else if (key == "id")
+				value.text = line.substr(begin, at - begin);
+			(*fields)[key] = value;
+
+			skip();
+			if (at < line.size() && line[at] == ',')
+			{
+				at++;
+				continue;
+			}
+			return at < line.size() && line[at] == '}';
+		}
+		return false;
+	}
+
+	// Destination of replies, a socket or stdout; writes of one line don't interleave
+	class Client
+	{
+	public:
+		explicit Client(const int socket) : m_socket(socket) {}
+		~Client()
+		{
+			if (this->m_socket >= 0)
+				close(this->m_socket);
+		}
+
+		Client(const Client &) = delete;
+		Client &operator=(const Client &) = delete;
+
+		void Send(const std::string &line)
+		{
+			std::lock_guard<std::mutex> lock(this->m_mutex);
+			if (this->m_socket < 0)
+			{
+				std::fwrite(line.data(), 1, line.size(), stdout);
+				std::fflush(stdout);
+				return;
+			}
+
+			// A client that went away just misses its replies
+			for (std::size_t sent = 0; sent < line.size();)
+			{
+				const auto written = send(this->m_socket, line.data() + sent, line.size() - sent, MSG_NOSIGNAL);
+				if (written <= 0)
+					return;
+				sent += static_cast<std::size_t>(written);
+			}
+		}
+	private:
+		int m_socket;
+		std::mutex m_mutex;
+	};
+
+	// One start/goal query, a wall or cost edit, or a request for the latency statistics
+	struct Request
+	{
+		std::shared_ptr<Client> client;
+		std::string id;
+		std::string engine;
+		int start = NO_CELL;
+		int goal = NO_CELL;
+		bool path = true;
+		bool stats = false;
+		Clock::time_point received;
+
+		// Edited cell, a wall if wall is set and a cost otherwise
+		bool edit = false;
+		bool wall = false;
+		int row = 0;
+		int col = 0;
+		bool set = true;
+		CellCost cost = 1;
+	};
+
+	// Requests between the readers and the dispatcher
+	class RequestQueue
+	{
+	public:
+		// Queues the requests read together, they join the same batch
+		void Push(std::vector<Request> *requests)
+		{
+			{
+				std::lock_guard<std::mutex> lock(this->m_mutex);
+				for (auto &request : *requests)
+					this->m_pending.push_back(std::move(request));
+			}
+			requests->clear();
+			this->m_wake.notify_one();
+		}
+
+		// No more requests will come
+		void Close()
+		{
+			{
+				std::lock_guard<std::mutex> lock(this->m_mutex);
+				this->m_closed = true;
+			}
+			this->m_wake.notify_one();
+		}
+
+		// Waits for requests and takes all of them, false once closed and empty
+		bool TakeAll(std::vector<Request> *batch)
+		{
+			std::unique_lock<std::mutex> lock(this->m_mutex);
+			this->m_wake.wait(lock, [this] { return !this->m_pending.empty() || this->m_closed; });
+			batch->clear();
+			batch->swap(this->m_pending);
+			return !batch->empty();
+		}
+	private:
+		std::mutex m_mutex;
+		std::condition_variable m_wake;
+		std::vector<Request> m_pending;
+		bool m_closed = false;
+	};
+
+	// Latencies of the answered queries
+	class LatencyStats
+	{
+	public:
+		void Add(const double microseconds)
+		{
+			std::lock_guard<std::mutex> lock(this->m_mutex);
+			if (this->m_latencies.size() < LatencyWindow)
+				this->m_latencies.push_back(microseconds);
+			else
+				this->m_latencies[this->m_count % LatencyWindow] = microseconds;
+			this->m_count++;
+		}
+
+		void AddShared(const std::size_t queries)
+		{
+			std::lock_guard<std::mutex> lock(this->m_mutex);
+			this->m_shared += queries;
+		}
+
+		void AddBatch()
+		{
+			std::lock_guard<std::mutex> lock(this->m_mutex);
+			this->m_batches++;
+		}
+
+		std::string Format()
+		{
+			std::vector<double> sorted;
+			std::uint64_t count;
+			std::uint64_t batches;
+			std::uint64_t shared;
+			{
+				std::lock_guard<std::mutex> lock(this->m_mutex);
+				sorted = this->m_latencies;
+				count = this->m_count;
+				batches = this->m_batches;
+				shared = this->m_shared;
+			}
+			std::sort(sorted.begin(), sorted.end());
+
+			char text[256];
+			std::snprintf(text, sizeof(text), "\"queries\": %llu, \"batches\": %llu, \"shared\": %llu, \"p50_us\": %.1f, \"p99_us\": %.1f",
+				static_cast<unsigned long long>(count), static_cast<unsigned long long>(batches),
+				static_cast<unsigned long long>(shared), Percentile(sorted, 0.50), Percentile(sorted, 0.99));
+			return text;
+		}
+	private:
+		// Nearest-rank percentile of sorted values
+		static double Percentile(const std::vector<double> &sorted, const double fraction)
+		{
+			if (sorted.empty())
+				return 0;
+			const auto rank = static_cast<std::size_t>(std::ceil(fraction * sorted.size()));
+			return sorted[std::max<std::size_t>(rank, 1) - 1];
+		}
+
+		std::mutex m_mutex;
+		std::vector<double> m_latencies;
+		std::uint64_t m_count = 0;
+		std::uint64_t m_batches = 0;
+		std::uint64_t m_shared = 0;
+	};
+
+	// Replies to a request that can't be answered
+	void SendError(const Request &request, const std::string &error)
+	{
+		request.client->Send("{\"id\": " + (request.id.empty() ? std::string("null") : request.id)
+			+ ", \"error\": \"" + error + "\"}\n");
+	}
+
+	// Reads the cell and value of a wall or cost edit, false with the error if it's invalid
+	bool ParseEdit(std::map<std::string, JsonValue> &fields, Request *request, std::string *error)
+	{
+		request->edit = true;
+		request->wall = fields.count("wall") != 0;
+		const auto &cell = request->wall ? fields["wall"] : fields["cost"];
+		if (cell.numbers.size() != 2)
+		{
+			*error = "edited cell is not a [row, col] pair";
+			return false;
+		}
+		request->row = static_cast<int>(cell.numbers[0]);
+		request->col = static_cast<int>(cell.numbers[1]);
+
+		if (request->wall)
+		{
+			request->set = fields.count("set") == 0 || fields["set"].text != "false";
+			return true;
+		}
+
+		const auto value = fields.count("value") != 0 ? std::atof(fields["value"].text.c_str()) : 0;
+		if (value < 1 || value > 255)
+		{
+			*error = "cost value is not between 1 and 255";
+			return false;
+		}
+		request->cost = static_cast<CellCost>(value);
+		return true;
+	}
+
+	// Publishes a wall or cost edit and replies with the new version, or with an error if the cell is outside the map
+	void ApplyEdit(const Request &request, GridStore *store)
+	{
+		const auto applied = request.wall
+			? store->SetWall(request.row, request.col, request.set)
+			: store->SetCost(request.row, request.col, request.cost);
+		if (!applied)
+		{
+			SendError(request, "edited cell is not a cell [row, col] of the map");
+			return;
+		}
+
+		request.client->Send("{\"id\": " + (request.id.empty() ? std::string("null") : request.id)
+			+ ", \"version\": " + std::to_string(store->Publish()) + "}\n");
+	}
+
+	// Turns a line into a request, or replies with the error and returns false
+	bool ParseRequest(const std::string &line, GridStore *store, const DaemonOptions &options, Request *request)
+	{
+		std::map<std::string, JsonValue> fields;
+		std::string error;
+		if (!ParseJsonObject(line, &fields))
+		{
+			error = "malformed JSON object";
+		}
+		else
+		{
+			if (fields.count("id") != 0)
+				request->id = fields["id"].text;
+			request->stats = fields.count("stats") != 0 && fields["stats"].text == "true";
+			request->path = fields.count("path") == 0 || fields["path"].text != "false";
+			request->engine = fields.count("engine") != 0 ? fields["engine"].text : options.engine;
+
+			// Edits are applied by the dispatcher, in order with the queries
+			if (fields.count("wall") != 0 || fields.count("cost") != 0)
+			{
+				if (ParseEdit(fields, request, &error))
+					return true;
+				SendError(*request, error);
+				return false;
+			}
+
+			// Cells have to be inside the map; whether they are open is checked on the version the query
+			// runs on, edits that arrived before it may not be published yet
+			const auto snapshot = store->Pin();
+			const auto getCell = [&](const char *key, int *id)
+			{
+				const auto field = fields.find(key);
+				if (field == fields.end() || field->second.numbers.size() != 2)
+					return false;
+				const auto row = static_cast<int>(field->second.numbers[0]);
+				const auto col = static_cast<int>(field->second.numbers[1]);
+				if (row < 0 || col < 0 || row >= snapshot.GetRows() || col >= snapshot.GetCols())
+					return false;
+				*id = snapshot.GetId(row, col);
+				return true;
+			};
+
+			const auto &names = GetSearchEngineNames();
+			if (request->stats)
+				return true;
+			if (!getCell("start", &request->start))
+				error = "start is not a cell [row, col] of the map";
+			else if (!getCell("goal", &request->goal))
+				error = "goal is not a cell [row, col] of the map";
+			else if (std::find(names.begin(), names.end(), request->engine) == names.end())
+				error = "unknown engine";
+			else
+				return true;
+		}
+
+		SendError(*request, error);
+		return false;
+	}
+
+	// Reply to a query, the latency is taken when it's sent
+	void SendReply(const Request &request, const GridReplica &replica, const std::vector<int> &path, const std::uint64_t expansions,
+		const bool shared, LatencyStats *stats)
+	{
+		const auto &grid = *replica.GetGrid();
+		std::string line = "{\"id\": " + (request.id.empty() ? std::string("null") : request.id);
+		line += ", \"found\": " + std::string(path.empty() ? "false" : "true");
+		line += ", \"moves\": " + std::to_string(path.empty() ? -1 : static_cast<int>(path.size()) - 1);
+		if (request.path)
+		{
+			line += ", \"path\": [";
+			for (std::size_t i = 0; i < path.size(); i++)
+			{
+				line += i == 0 ? "[" : ", [";
+				line += std::to_string(grid.GetRow(path[i])) + ", " + std::to_string(grid.GetCol(path[i])) + "]";
+			}
+			line += "]";
+		}
+		line += ", \"expansions\": " + std::to_string(expansions);
+		line += ", \"shared\": " + std::string(shared ? "true" : "false");
+		line += ", \"version\": " + std::to_string(replica.GetVersion());
+
+		const auto microseconds = std::chrono::duration<double, std::micro>(Clock::now() - request.received).count();
+		char latency[64];
+		std::snprintf(latency, sizeof(latency), ", \"us\": %.1f}\n", microseconds);
+		request.client->Send(line + latency);
+		stats->Add(microseconds);
+	}
+
+	// Search state of one thread of the pool
+	struct Worker
+	{
+		GridReplica replica;
+		std::map<std::string, std::unique_ptr<SearchEngine>> engines;
+		std::string lastEngine;
+		MultiSourceSearch multiSource;
+	};
+
+	// Work item of a batch: one query, or queries sharing a start that share a multi-source pass
+	struct Task
+	{
+		std::vector<const Request*> requests;
+		bool shared = false;
+	};
+
+	class Daemon
+	{
+	public:
+		Daemon(GridStore *store, const DaemonOptions &options)
+			: m_store(store)
+			, m_options(options)
+			, m_pool(options.threads > 0 ? options.threads : ThreadPool::GetDefaultThreadCount())
+		{
+			// Searches write their state into the grid, every thread gets its own copy
+			for (auto thread = 0; thread < this->m_pool.GetThreadCount(); thread++)
+			{
+				this->m_workers.emplace_back(new Worker());
+				this->m_workers.back()->replica.Load(store->Pin());
+				this->m_workers.back()->multiSource = MultiSourceSearch(options.connectivity);
+				this->m_workers.back()->multiSource.SetThreadCount(1);
+			}
+
+			// Goals of one pass, limited by the memory of their distance fields
+			const auto fieldBytes = static_cast<std::size_t>(this->m_workers.front()->replica.GetGrid()->GetCapacity()) * sizeof(int);
+			this->m_maxSharedGoals = static_cast<int>(std::min<std::size_t>(SOURCES_PER_PASS,
+				options.batchMemory * 1024 * 1024 / std::max<std::size_t>(fieldBytes, 1)));
+		}
+
+		RequestQueue &GetQueue()
+		{
+			return this->m_queue;
+		}
+
+		LatencyStats &GetStats()
+		{
+			return this->m_stats;
+		}
+
+		// Serves batches until the queue is closed
+		void Serve()
+		{
+			std::vector<Request> batch;
+			while (this->m_queue.TakeAll(&batch))
+				ServeBatch(batch);
+		}
+	private:
+		void ServeBatch(const std::vector<Request> &batch)
+		{
+			this->m_stats.AddBatch();
+
+			// The queries before an edit are answered before it's published
+			std::vector<const Request*> queries;
+			for (const auto &request : batch)
+			{
+				if (!request.edit)
+				{
+					queries.push_back(&request);
+					continue;
+				}
+
+				ServeQueries(queries);
+				queries.clear();
+				ApplyEdit(request, this->m_store);
+			}
+			ServeQueries(queries);
+		}
+
+		// Answers queries on the current version
+		void ServeQueries(const std::vector<const Request*> &queries)
+		{
+			if (queries.empty())
+				return;
+
+			// Breadth-first queries from the same start share a pass, the others run one by one
+			std::vector<Task> tasks;
+			std::map<std::pair<std::string, int>, std::vector<const Request*>> groups;
+			std::vector<const Request*> statsRequests;
+			for (const auto request : queries)
+			{
+				if (request->stats)
+				{
+					statsRequests.push_back(request);
+					continue;
+				}
+
+				const auto breadthFirst = std::find(BreadthFirstEngines.begin(), BreadthFirstEngines.end(), request->engine)
+					!= BreadthFirstEngines.end();
+				if (breadthFirst && this->m_maxSharedGoals >= 2)
+					groups[{ request->engine, request->start }].push_back(request);
+				else
+					tasks.push_back(Task { { request }, false });
+			}
+			for (const auto &group : groups)
+			{
+				const auto &requests = group.second;
+				if (requests.size() == 1)
+				{
+					tasks.push_back(Task { requests, false });
+					continue;
+				}
+				for (std::size_t first = 0; first < requests.size(); first += this->m_maxSharedGoals)
+				{
+					const auto last = std::min(requests.size(), first + this->m_maxSharedGoals);
+					tasks.push_back(Task { std::vector<const Request*>(requests.begin() + first, requests.begin() + last), last - first > 1 });
+				}
+			}
+
+			std::atomic<std::size_t> next(0);
+			this->m_pool.Run([&](const int worker)
+			{
+				for (auto task = next++; task < tasks.size(); task = next++)
+				{
+					if (tasks[task].shared)
+						RunShared(tasks[task], this->m_workers[worker].get());
+					else
+						RunSingle(*tasks[task].requests.front(), this->m_workers[worker].get());
+				}
+			});
+
+			// Statistics include the queries that arrived with them
+			for (const auto request : statsRequests)
+				request->client->Send("{\"id\": " + (request->id.empty() ? std::string("null") : request->id) + ", "
+					+ this->m_stats.Format() + "}\n");
+		}
+
+		// Brings the worker's grid to the current version, false with an error reply for each query whose cells are walls in it
+		bool LoadVersion(const std::vector<const Request*> &requests, Worker *worker, std::vector<const Request*> *open)
+		{
+			// Start and goal of the last query would stay open in the copy
+			const auto grid = worker->replica.GetGrid();
+			grid->SetStart(NO_CELL);
+			grid->SetGoal(NO_CELL);
+			worker->replica.Load(this->m_store->Pin());
+
+			for (const auto request : requests)
+			{
+				if (grid->IsWall(request->start) || grid->IsWall(request->goal))
+					SendError(*request, "start or goal is a wall in version " + std::to_string(worker->replica.GetVersion()));
+				else
+					open->push_back(request);
+			}
+			return !open->empty();
+		}
+
+		// Runs one query with its engine on the worker's grid
+		void RunSingle(const Request &request, Worker *worker)
+		{
+			std::vector<const Request*> open;
+			if (!LoadVersion({ &request }, worker, &open))
+				return;
+
+			auto &engine = worker->engines[request.engine];
+			if (engine == nullptr)
+			{
+				engine.reset(CreateSearchEngine(request.engine, this->m_options.connectivity));
+
+				// Queries are the parallel work
+				engine->SetThreadCount(1);
+			}
+
+			// Engines that keep state between their own queries expect a grid no other engine touched
+			const auto grid = worker->replica.GetGrid();
+			if (worker->lastEngine != request.engine)
+			{
+				grid->ResetSearch();
+				worker->lastEngine = request.engine;
+			}
+
+			grid->SetStart(request.start);
+			grid->SetGoal(request.goal);
+			engine->Start(grid);
+			engine->Run();
+			SendReply(request, worker->replica, grid->GetPath(engine->GetResult()), engine->GetStats().expansions, false, &this->m_stats);
+		}
+
+		// Floods from every goal at once, then walks down each goal's distances from the shared start
+		void RunShared(const Task &task, Worker *worker)
+		{
+			std::vector<const Request*> requests;
+			if (!LoadVersion(task.requests, worker, &requests))
+				return;
+
+			std::vector<int> goals;
+			for (const auto request : requests)
+				goals.push_back(request->goal);
+
+			// Passes only read the walls, the copy has neither start nor goal set
+			const auto grid = worker->replica.GetGrid();
+			const auto fields = worker->multiSource.Run(grid, goals);
+			const auto expansions = worker->multiSource.GetStats().expansions;
+			this->m_stats.AddShared(requests.size());
+
+			const auto start = requests.front()->start;
+			for (std::size_t lane = 0; lane < goals.size(); lane++)
+			{
+				std::vector<int> path;
+				auto distance = fields.GetDistance(static_cast<int>(lane), start);
+				if (distance != NO_DISTANCE)
+				{
+					path.push_back(start);
+					DispatchConnectivity(this->m_options.connectivity, [&](auto policy)
+					{
+						using Conn = decltype(policy);
+						for (auto cell = start; distance > 0; distance--)
+						{
+							Conn::ForEach(grid, cell, [&](const int next, bool)
+							{
+								if (fields.GetDistance(static_cast<int>(lane), next) != distance - 1)
+									return true;
+								cell = next;
+								return false;
+							});
+							path.push_back(cell);
+						}
+					});
+				}
+				SendReply(*requests[lane], worker->replica, path, expansions, true, &this->m_stats);
+			}
+		}
+
+		// Versions of the map, each worker searches its own copy of the latest one
+		GridStore *m_store;
+		const DaemonOptions &m_options;
+
+		ThreadPool m_pool;
+		std::vector<std::unique_ptr<Worker>> m_workers;
+		int m_maxSharedGoals;
+
+		RequestQueue m_queue;
+		LatencyStats m_stats;
+	};
+
+	// Reads request lines from a client until it disconnects
+	void ReadRequests(Daemon *daemon, GridStore *store, const DaemonOptions &options, const std::shared_ptr<Client> &client, const int socket)
+	{
+		std::string buffer;
+		std::vector<Request> requests;
+		char chunk[65536];
+		while (true)
+		{
+			const auto count = socket >= 0 ? recv(socket, chunk, sizeof(chunk), 0) : read(STDIN_FILENO, chunk, sizeof(chunk));
+			if (count <= 0)
+				break;
+			buffer.append(chunk, static_cast<std::size_t>(count));
+
+			std::size_t begin = 0;
+			for (auto end = buffer.find('\n'); end != std::string::npos; end = buffer.find('\n', begin))
+			{
+				const auto line = buffer.substr(begin, end - begin);
+				begin = end + 1;
+				if (line.find_first_not_of(" \t\r") == std::string::npos)
+					continue;
+
+				Request request;
+				request.client = client;
+				request.received = Clock::now();
+				if (ParseRequest(line, store, options, &request))
+					requests.push_back(std::move(request));
+			}
+			buffer.erase(0, begin);
+
+			if (!requests.empty())
+				daemon->GetQueue().Push(&requests);
+		}
+	}
+
+	// Accepts clients on a Unix domain socket, each read on a thread of its own
+	bool ListenOnSocket(Daemon *daemon, GridStore *store, const DaemonOptions &options)
+	{
+		sockaddr_un address {};
+		address.sun_family = AF_UNIX;
+		if (options.socket.size() >= sizeof(address.sun_path))
+		{
+			std::fprintf(stderr, "Socket path too long: %s\n", options.socket.c_str());
+			return false;
+		}
+		std::strcpy(address.sun_path, options.socket.c_str());
+
+		const auto listener = socket(AF_UNIX, SOCK_STREAM, 0);
+		unlink(options.socket.c_str());
+		if (listener < 0 || bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(listener, 64) != 0)
+		{
+			std::fprintf(stderr, "Cannot listen on %s: %s\n", options.socket.c_str(), std::strerror(errno));
+			return false;
+		}
+
+		std::thread([daemon, store, &options, listener]
+		{
+			while (true)
+			{
+				const auto connection = accept(listener, nullptr, nullptr);
+				if (connection < 0)
+					continue;
+
+				const auto client = std::make_shared<Client>(connection);
+				std::thread(ReadRequests, daemon, store, std::cref(options), client, connection).detach();
+			}
+		}).detach();
+		return true;
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	DaemonOptions options;
+	if (!ParseOptions(argc, argv, &options))
+	{
+		PrintUsage(argv[0]);
+		return 1;
+	}
+
+	Grid grid;
+	if (!options.map.empty())
+	{
+		std::string error;
+		if (!LoadMap(options.map, &grid, nullptr, &error))
+		{
+			std::fprintf(stderr, "%s\n", error.c_str());
+			return 1;
+		}
+	}
+	else
+	{
+		grid.Resize(options.rows, options.cols);
+		GeneratorOptions generator;
+		generator.layout = options.layout;
+		generator.seed = options.seed;
+		generator.density = options.density;
+		generator.threads = options.threads;
+		GenerateMap(&grid, generator);
+	}
+
+	GridStore store(grid);
+	Daemon daemon(&store, options);
+	if (!options.socket.empty())
+	{
+		if (!ListenOnSocket(&daemon, &store, options))
+			return 1;
+		std::fprintf(stderr, "Serving %dx%d map on %s\n", grid.GetRows(), grid.GetCols(), options.socket.c_str());
+
+		// Runs until the process is stopped
+		daemon.Serve();
+		return 0;
+	}
+
+	// Replies go to stdout, the requests of stdin are one client
+	std::thread reader([&]
+	{
+		ReadRequests(&daemon, &store, options, std::make_shared<Client>(-1), -1);
+		daemon.GetQueue().Close();
+	});
+	daemon.Serve();
+	reader.join();
+
+	std::fprintf(stderr, "{%s}\n", daemon.GetStats().Format().c_str());
+	return 0;
+}
@@ -1,283 +1,311 @@
 #include "PathFinder.h"
 
-PathFinder::PathFinder(QHash<int, Vertex*>* listOfIds, const int rows, const int cols, QObject* parent)
-	: m_hash(listOfIds)
-	, m_queue(nullptr)
-	, m_stack(nullptr)
-	, m_rows(rows)
-	, m_cols(cols)
-	, m_interrupted(false)
+#include <chrono>
+#include <ctime>
+
+namespace
+{
+	using Clock = std::chrono::steady_clock;
+
+	std::uint64_t GetNanoseconds(const Clock::time_point begin)
+	{
+		return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - begin).count());
+	}
+}
+
+PathFinder::PathFinder(Grid *grid, QObject *parent)
+	: QObject(parent)
+	, m_grid(grid)
+	, m_connectivity(Connectivity::Four)
+	, m_components(nullptr)
 {
 	// Init timers
-	this->m_bfsTick = new QTimer(this); 
-	this->m_dfsTick = new QTimer(this);
+	this->m_tick = new QTimer(this);
 	this->m_timer = new QElapsedTimer();
 	this->m_timeElapsed = 0;
 
-	// Connect algorithm steps with timers
-	connect(this->m_bfsTick, SIGNAL(timeout()), this, SLOT(RouteBFS()));
-	connect(this->m_dfsTick, SIGNAL(timeout()), this, SLOT(RouteDFS()));
+	// Poll the worker on every tick
+	connect(this->m_tick, SIGNAL(timeout()), this, SLOT(Route()));
 }
 
-void PathFinder::Setup(VertexHashIDList *listOfIds, const int rows, const int cols)
+void PathFinder::Setup(Grid *grid, const Connectivity connectivity)
 {
-	this->m_rows = rows;
-	this->m_cols = cols;
-	this->m_hash = listOfIds;
+	this->m_grid = grid;
+	this->m_connectivity = connectivity;
 }
 
-void PathFinder::StartBreadthFirstSearch()
+void PathFinder::SetComponentIndex(ComponentIndex *components)
 {
-	// Setup queue and timer to use for BFS
-	this->m_queue = new QQueue<Vertex*>();
-	this->m_timer->restart();
-
-	// Starting point
-	Vertex *start = this->m_hash->value(0);
-	this->m_queue->enqueue(start);
+	this->m_components = components;
+}
 
-	// On each tick, take one vertex off the queue and search
-	this->m_bfsTick->blockSignals(false);
-	this->m_bfsTick->start(TICK_RATE);
+void PathFinder::StartBreadthFirstSearch()
+{
+	StartSearch("bfs");
 }
 
 void PathFinder::StartDepthFirstSearch()
 {
-	// Setup stack and timer to use for DFS
-	this->m_stack = new QStack<Vertex*>();
-	this->m_timer->restart();
+	StartSearch("dfs");
+}
 
-	// Starting point
-	Vertex *start = this->m_hash->value(0);
-	this->m_stack->push(start);
+void PathFinder::StartDijkstraSearch()
+{
+	StartSearch("dijkstra");
+}
 
-	// On each tick, take one vertex off the stack and search
-	this->m_dfsTick->blockSignals(false);
-	this->m_dfsTick->start(TICK_RATE);
+void PathFinder::StartAStarSearch()
+{
+	StartSearch("astar");
 }
 
-quint64 PathFinder::GetElapsedTime() const
+void PathFinder::StartJumpPointSearch()
 {
-	return this->m_timeElapsed;
+	StartSearch("jps");
 }
 
-void PathFinder::TriggerInterrupt()
+void PathFinder::StartDirectionOptimizingSearch()
 {
-	this->m_timeElapsed = this->m_timer->elapsed();
-	this->m_timer->invalidate();
-	m_interrupted = true;
+	StartSearch("dobfs");
 }
 
-QList<Vertex*>* PathFinder::GetNeighbors(const int id) const
+void PathFinder::StartParallelSearch()
 {
-	auto neighbors = new QList<Vertex*>();
-	const auto numVertices = this->m_rows * this->m_cols;
+	StartSearch("pbfs");
+}
 
-	Vertex *adjacentVertex;
+void PathFinder::StartBidirectionalSearch()
+{
+	StartSearch("bibfs");
+}
 
-	// South
-	if ((id) < (numVertices - this->m_cols))
-	{
-		adjacentVertex = this->m_hash->value(id + this->m_cols);
-		if (!adjacentVertex->IsWall() && !adjacentVertex->WasVisited())
-		{
-			neighbors->append(adjacentVertex);
-		}
-	}
+void PathFinder::StartWavefrontSearch()
+{
+	StartSearch("wavefront");
+}
 
-	// North
-	if (id > this->m_cols)
-	{
-		adjacentVertex = this->m_hash->value(id - this->m_cols);
-		if (!adjacentVertex->IsWall() && !adjacentVertex->WasVisited())
-		{
-			neighbors->append(adjacentVertex);
-		}
-	}
+void PathFinder::StartIncrementalSearch()
+{
+	StartSearch("lpa");
+}
 
-	// East
-	if (((id + 1) % this->m_cols) != 0)
-	{
-		adjacentVertex = this->m_hash->value(id + 1);
-		if (!adjacentVertex->IsWall() && (id + 1) <= numVertices && !adjacentVertex->WasVisited())
-		{
-			neighbors->append(adjacentVertex);
-		}
-	}
+void PathFinder::StartHierarchicalSearch()
+{
+	StartSearch("hpa");
+}
 
-	// West
-	if (id != 0 && ((id) % this->m_cols) != 0)
-	{
-		adjacentVertex = this->m_hash->value(id - 1);
-		if (!adjacentVertex->IsWall() && !adjacentVertex->WasVisited())
-		{
-			neighbors->append(adjacentVertex);
-		}
-	}
-	return neighbors;
+const SearchEngine *PathFinder::GetEngine() const
+{
+	// A cancelled step may still be running on the worker
+	return this->m_worker.IsRunning() ? nullptr : this->m_engine.get();
+}
+
+bool PathFinder::CanReplan() const
+{
+	return this->m_engine != nullptr && !this->m_worker.IsRunning() && this->m_engine->IsFinished()
+		&& dynamic_cast<IncrementalSearchBase*>(this->m_engine.get()) != nullptr;
 }
 
-void PathFinder::Stop(Vertex* vertex)
+void PathFinder::Replan()
 {
-	// Stop ALL timers
+	if (!CanReplan())
+		return;
+
+	// Repairs run on the calling thread, they only expand the cells around the edit
+	const auto incremental = static_cast<IncrementalSearchBase*>(this->m_engine.get());
+	incremental->SetTrace(&this->m_trace);
+	this->m_trace.clear();
+	this->m_timer->restart();
+
+	// Every edit since the last load reaches the engine's grid through a new version
+	std::vector<int> changed;
+	LoadVersion(&changed);
+
+	// Only the cells whose cost changed are expanded again
+	auto begin = Clock::now();
+	for (const auto id : changed)
+		incremental->UpdateCell(id);
+	incremental->Replan();
+	this->m_record.setupNs = 0;
+	this->m_record.searchNs = GetNanoseconds(begin);
+
 	this->m_timeElapsed = this->m_timer->elapsed();
 	this->m_timer->invalidate();
 
-	this->m_bfsTick->blockSignals(true);
-	this->m_bfsTick->stop();
+	for (const auto cell : this->m_trace)
+		emit CellVisited(cell);
 
-	this->m_dfsTick->blockSignals(true);
-	this->m_dfsTick->stop();
+	begin = Clock::now();
+	this->m_record.pathCells = GetPath(incremental->GetResult()).size();
+	this->m_record.pathNs = GetNanoseconds(begin);
+	this->m_record.found = incremental->GetResult() != NO_CELL;
+	CollectSearchRecord(*incremental, &this->m_record);
 
-	// Clear containers
-	if (this->m_queue != nullptr)
-		this->m_queue->clear();
+	emit DisplayGoal(incremental->GetResult());
+}
 
-	if (this->m_stack != nullptr)
-		this->m_stack->clear();
+std::vector<int> PathFinder::GetPath(const int last) const
+{
+	return this->m_replica.GetGrid()->GetPath(last);
+}
 
-	// Display the path
-	emit DisplayGoal(vertex);
+void PathFinder::Release()
+{
+	// The worker may still be in a step of the engine, it's freed when the worker is joined;
+	// a hierarchical engine is kept for the next search instead
+	this->m_worker.Cancel();
+	if (this->m_engine != nullptr && (this->m_worker.IsRunning() || this->m_record.engine == "hpa"))
+		this->m_retired = std::move(this->m_engine);
+	this->m_engine.reset();
 }
 
-void PathFinder::RouteBFS()
+void PathFinder::StartSearch(const std::string &name)
 {
-	// Check if this algorithm has been interrupted while running
-	if (this->m_interrupted)
-	{
-		this->m_bfsTick->blockSignals(false);
-		this->m_bfsTick->stop();
-		this->m_interrupted = false;
-		Stop(nullptr); // Interrupt the search, pass in nullptr as the goal hasn't been found
-		return;
-	}
+	// The worker lets go of the previous engine and the replica first, a cancelled step may still have to end
+	this->m_worker.Cancel();
+	this->m_worker.Wait();
+	if (this->m_engine == nullptr)
+		this->m_engine = std::move(this->m_retired);
+	this->m_retired.reset();
+
+	// Engine specialized for the selected movement. The hierarchical engine keeps its abstract graph while the
+	// engine and the movement stay the same, the next load reports the edits since; any other engine owns the
+	// replica's search state after its run, so the hierarchical one can't be reused after it
+	const auto reuse = this->m_engine != nullptr && name == "hpa" && this->m_record.engine == name
+		&& this->m_record.connectivity == GetConnectivityName(this->m_connectivity);
+	if (!reuse)
+		this->m_engine.reset(CreateSearchEngine(name, this->m_connectivity));
+	this->m_timer->restart();
 
-	Vertex *next;
-	auto validVertexCounter = 0;
-	auto goalFound = false;
+	this->m_record = SearchRecord();
+	this->m_record.engine = name;
+	this->m_record.connectivity = GetConnectivityName(this->m_connectivity);
+	this->m_record.rows = this->m_grid->GetRows();
+	this->m_record.cols = this->m_grid->GetCols();
 
-	/*
-	 * Breadth-First Search algorithm
-	 * 
-	 * Dequeue a vertex from the queue.
-	 * Get adjacent nodes and iterate over them at random and check if they're goals.
-	 * It not, enqueue them on the queue.
-	 */
+	// The search keeps this version however the grid is edited meanwhile
+	LoadVersion();
+	const auto grid = this->m_replica.GetGrid();
 
-	if (!this->m_queue->isEmpty())
+	// Start and goal in different regions, no need to flood the start's region;
+	// incremental engines still search, so a later edit can be repaired
+	auto search = true;
+	if (this->m_components != nullptr && dynamic_cast<IncrementalSearchBase*>(this->m_engine.get()) == nullptr)
 	{
-		auto current = this->m_queue->dequeue();
-
-		if (current->WasVisited())
-			return;
+		this->m_components->SetConnectivity(this->m_connectivity);
+		search = this->m_components->IsConnected(this->m_grid->GetStart(), this->m_grid->GetGoal());
+	}
 
-		const auto currentId = current->GetId();
-		auto neighbors = GetNeighbors(currentId);
+	// The worker expands one cell per tick, the tick polls what it did
+	this->m_worker.Start(this->m_engine.get(), grid, search, std::chrono::milliseconds(TICK_RATE));
+	this->m_tick->blockSignals(false);
+	this->m_tick->start(TICK_RATE);
+}
 
-		while (!neighbors->empty())
-		{
-			next = neighbors->takeFirst();
+quint64 PathFinder::GetElapsedTime() const
+{
+	return this->m_timeElapsed;
+}
 
-			// Ignore walls or nodes that are already visited
-			if (next->IsWall() || next->WasVisited())
-				continue;
+const SearchRecord &PathFinder::GetRecord() const
+{
+	return this->m_record;
+}
 
-			validVertexCounter++;
-			next->SetPrevious(current);
-			this->m_queue->enqueue(next);
+void PathFinder::TriggerInterrupt()
+{
+	if (!this->m_worker.IsRunning())
+		return;
 
-			if (next->IsGoal())
-			{
-				goalFound = true;
-				break;
-			}
-		}
-		current->SetVisited(true);
+	// Returns at once, a step in progress ends in the background and its cells are dropped
+	this->m_worker.Cancel();
 
-		if (goalFound)
-			Stop(next); // Goal found
-	}
+	// The search may have finished just before, its thread is then about to return
+	auto result = NO_CELL;
+	if (DrainProgress(&result))
+		this->m_worker.Wait();
 	else
-	{
-		Stop(nullptr); // Goal NOT found
-		return;
-	}
+		result = NO_CELL; // Interrupt the search, the goal hasn't been found
+	EmitVisitedCells();
 
-	// No vertex has been updated in current tick
-	if (validVertexCounter == 0)
-	{
-		validVertexCounter = 0;
-		RouteBFS();
-	}
+	Stop(result);
 }
 
-void PathFinder::RouteDFS()
+void PathFinder::Stop(const int goal)
 {
-	// Check if this algorithm has been interrupted while running
-	if (this->m_interrupted)
+	// Stop the timer
+	if (this->m_timer->isValid())
 	{
-		this->m_dfsTick->blockSignals(false);
-		this->m_dfsTick->stop();
-		this->m_interrupted = false;
-		Stop(nullptr); // Interrupt the search, pass in nullptr as the goal hasn't been found
-		return;
+		this->m_timeElapsed = this->m_timer->elapsed();
+		this->m_timer->invalidate();
 	}
 
-	Vertex *next;
-	auto validVertexCounter = 0;
-	auto goalFound = false;
-
-	/*
-	 * Depth-First Search algorithm
-	 *
-	 * Pop a node off of the stack.
-	 * Get adjacent nodes and iterate over them and check if they're goals.
-	 * It not, push them onto the stack.
-	 */
+	this->m_tick->blockSignals(true);
+	this->m_tick->stop();
 
-	if (!this->m_stack->isEmpty())
-	{
-		auto current = this->m_stack->pop();
-
-		const auto currentId = current->GetId();
-		auto neighbors = GetNeighbors(currentId);
-
-		while (!neighbors->isEmpty())
-		{
-			for (auto i = 0; i < neighbors->size(); i++)
-				next = neighbors->takeAt(i);
-
-			// Ignore walls and visited nodes
-			if (next->IsWall() || next->WasVisited())
-				continue;
-
-			validVertexCounter++;
-			next->SetPrevious(current);
-			this->m_stack->push(next);
-
-			if (next->IsGoal())
-			{
-				goalFound = true;
-				break;
-			}
-		}
-		current->SetVisited(true);
-
-		if (goalFound)
-			Stop(next); // Goal found
-	}
+	// Final counters once the engine is idle, a cancelled step keeps those of the last report
+	if (!this->m_worker.IsRunning())
+		CollectSearchRecord(*this->m_engine, &this->m_record);
 	else
+		this->m_record.timestamp = static_cast<std::int64_t>(std::time(nullptr));
+
+	// Display the path
+	emit DisplayGoal(goal);
+}
+
+void PathFinder::LoadVersion(std::vector<int> *changed)
+{
+	// Tiles the grid shares with the last version are neither copied nor reloaded
+	this->m_store.Assign(*this->m_grid);
+	this->m_store.Publish();
+
+	// The replica would keep its old start and goal open, whatever the version holds there
+	const auto grid = this->m_replica.GetGrid();
+	grid->SetStart(NO_CELL);
+	grid->SetGoal(NO_CELL);
+	this->m_replica.Load(this->m_store.Pin(), changed);
+	grid->SetStart(this->m_grid->GetStart());
+	grid->SetGoal(this->m_grid->GetGoal());
+}
+
+void PathFinder::Route()
+{
+	auto result = NO_CELL;
+	const auto finished = DrainProgress(&result);
+
+	// Every cell of a finished search was queued before its last report
+	EmitVisitedCells();
+
+	if (finished)
 	{
-		Stop(nullptr); // Goal NOT found
-		return;
+		this->m_worker.Wait();
+		Stop(result);
 	}
+}
 
-	// No vertex has been updated in current tick
-	if (validVertexCounter == 0)
+bool PathFinder::DrainProgress(int *result)
+{
+	auto finished = false;
+	SearchProgress progress;
+	while (this->m_worker.PopProgress(&progress))
 	{
-		validVertexCounter = 0;
-		this->m_dfsTick->stop();
-		RouteDFS();
-		this->m_dfsTick->start(TICK_RATE);
+		this->m_record.stats = progress.stats;
+		this->m_record.allocatedBytes = progress.allocatedBytes;
+		this->m_record.setupNs = progress.setupNs;
+		this->m_record.searchNs = progress.searchNs;
+		this->m_record.pathNs = progress.pathNs;
+		this->m_record.found = progress.finished && progress.result != NO_CELL;
+		this->m_record.pathCells = progress.pathCells;
+
+		finished = progress.finished;
+		*result = progress.result;
 	}
+	return finished;
+}
+
+void PathFinder::EmitVisitedCells()
+{
+	auto id = NO_CELL;
+	while (this->m_worker.PopCell(&id))
+		emit CellVisited(id);
 }
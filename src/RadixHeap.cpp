@@ -0,0 +1,53 @@
+#include "RadixHeap.h"
+
+RadixHeap::RadixHeap()
+	: m_last(0)
+	, m_size(0)
+{
+}
+
+void RadixHeap::Clear()
+{
+	for (auto &bucket : this->m_buckets)
+		bucket.clear();
+	this->m_last = 0;
+	this->m_size = 0;
+}
+
+RadixHeap::Entry RadixHeap::Pop()
+{
+	if (this->m_buckets[0].empty())
+	{
+		// Refill bucket 0 from the first non-empty bucket
+		auto index = 1;
+		while (this->m_buckets[index].empty())
+			index++;
+
+		auto &bucket = this->m_buckets[index];
+		auto last = bucket.front().first;
+		for (const auto &entry : bucket)
+		{
+			if (entry.first < last)
+				last = entry.first;
+		}
+
+		// Every entry lands in a lower bucket relative to the new minimum
+		this->m_last = last;
+		for (const auto &entry : bucket)
+			this->m_buckets[BucketOf(entry.first, last)].push_back(entry);
+		bucket.clear();
+	}
+
+	const auto entry = this->m_buckets[0].back();
+	this->m_buckets[0].pop_back();
+	this->m_size--;
+	return entry;
+}
+
+std::size_t RadixHeap::GetAllocatedBytes() const
+{
+	std::size_t bytes = 0;
+	for (const auto &bucket : this->m_buckets)
+		bytes += bucket.capacity() * sizeof(Entry);
+	return bytes;
+}
@@ -0,0 +1,90 @@
+#include "Scenario.h"
+
+#include <cmath>
+#include <fstream>
+#include <sstream>
+
+bool LoadScenarios(const std::string &path, std::vector<Scenario> *scenarios, std::string *error)
+{
+	std::ifstream file(path);
+	if (!file)
+	{
+		*error = "Cannot open " + path;
+		return false;
+	}
+
+	std::string line;
+	if (!std::getline(file, line) || line.compare(0, 7, "version") != 0)
+	{
+		*error = "Missing version line in " + path;
+		return false;
+	}
+
+	scenarios->clear();
+	for (auto number = 2; std::getline(file, line); number++)
+	{
+		if (line.empty() || line == "\r")
+			continue;
+
+		// bucket, map, map width, map height, start x, start y, goal x, goal y, optimal length
+		std::istringstream fields(line);
+		Scenario scenario;
+		std::string map;
+		int width;
+		int height;
+		if (!(fields >> scenario.bucket >> map >> width >> height
+			>> scenario.startCol >> scenario.startRow >> scenario.goalCol >> scenario.goalRow >> scenario.optimalLength))
+		{
+			*error = path + ":" + std::to_string(number) + ": malformed scenario";
+			return false;
+		}
+		scenarios->push_back(scenario);
+	}
+	return true;
+}
+
+double GetOctileLength(const Grid &grid, const std::vector<int> &path)
+{
+	auto straight = 0;
+	auto diagonal = 0;
+	for (std::size_t i = 1; i < path.size(); i++)
+	{
+		const auto rowChanged = grid.GetRow(path[i]) != grid.GetRow(path[i - 1]);
+		const auto colChanged = grid.GetCol(path[i]) != grid.GetCol(path[i - 1]);
+		rowChanged && colChanged ? diagonal++ : straight++;
+	}
+	return straight + diagonal * std::sqrt(2.0);
+}
+
+long long GetPathCost(const Grid &grid, const std::vector<int> &path)
+{
+	long long cost = 0;
+	for (std::size_t i = 1; i < path.size(); i++)
+	{
+		const auto rowChanged = grid.GetRow(path[i]) != grid.GetRow(path[i - 1]);
+		const auto colChanged = grid.GetCol(path[i]) != grid.GetCol(path[i - 1]);
+		cost += static_cast<long long>(grid.GetCost(path[i])) * (rowChanged && colChanged ? DIAGONAL_COST : STRAIGHT_COST);
+	}
+	return cost;
+}
+
+bool GetOptimalCost(const double optimalLength, long long *cost)
+{
+	// sqrt(2) is irrational, so only one count of diagonal moves leaves a whole number of straight ones;
+	// scenario files round lengths to 8 decimals
+	const auto Epsilon = 1e-6;
+	auto bestError = Epsilon;
+	auto found = false;
+	for (long long diagonal = 0; diagonal * std::sqrt(2.0) <= optimalLength + Epsilon; diagonal++)
+	{
+		const auto straight = optimalLength - diagonal * std::sqrt(2.0);
+		const auto error = std::fabs(straight - std::round(straight));
+		if (error < bestError)
+		{
+			bestError = error;
+			*cost = static_cast<long long>(std::round(straight)) * STRAIGHT_COST + diagonal * DIAGONAL_COST;
+			found = true;
+		}
+	}
+	return found;
+}
@@ -0,0 +1,342 @@
+/*
+ * Headless runner of MovingAI scenario files.
+ *
+ * Loads a map and its .scen file, runs every query with each engine and
+ * checks the length of every found path against the scenario's optimal
+ * length. A longer path the engines price no higher than the optimal one is
+ * optimal for them and isn't counted as a mismatch. Queries are spread over threads, each with its own copy of the grid.
+ *
+ * Usage: BFS-DFS-Scenarios --map FILE --scen FILE [--engine NAME]... [--connectivity C] [--threads N] [--tolerance T] [--csv | --json]
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Grid.h"
+#include "MapFile.h"
+#include "Scenario.h"
+#include "SearchEngine.h"
+#include "ThreadPool.h"
+
+namespace
+{
+	enum class OutputFormat
+	{
+		Table,
+		Csv,
+		Json,
+	};
+
+	struct RunnerOptions
+	{
+		std::string map;
+		std::string scenarios;
+		std::vector<std::string> engines;
+		Connectivity connectivity = Connectivity::EightNoCornerCutting;
+		int threads = 0;
+		double tolerance = 1e-3;
+		OutputFormat format = OutputFormat::Table;
+	};
+
+	// Outcome of one query
+	struct QueryResult
+	{
+		double seconds = 0;
+		std::uint64_t expansions = 0;
+		bool found = false;
+		double length = 0;
+		long long cost = 0;
+	};
+
+	// Summary of the queries of one bucket, or of all of them
+	struct BucketReport
+	{
+		std::string engine;
+		std::string bucket;
+		std::size_t queries = 0;
+		std::size_t failed = 0;
+		std::size_t mismatched = 0;
+		double maxError = 0;
+		double p50 = 0;
+		double p90 = 0;
+		double p99 = 0;
+		double meanExpansions = 0;
+		double queriesPerSecond = 0;
+	};
+
+	void PrintUsage(const char *program)
+	{
+		std::fprintf(stderr,
+			"Usage: %s --map FILE --scen FILE [--engine NAME]... [--connectivity C] [--threads N] [--tolerance T] [--csv | --json]\n"
+			"  --map FILE          MovingAI .map or binary map the scenarios refer to\n"
+			"  --scen FILE         MovingAI .scen file\n"
+			"  --engine NAME       engine to run (repeatable), default all\n"
+			"  --connectivity C    4, 8, 8nc (no corner cutting) or hex, default 8nc as the scenarios assume\n"
+			"  --threads N         queries run in parallel, default one per core\n"
+			"  --tolerance T       largest accepted difference to the optimal length, default 0.001\n"
+			"  --csv               print comma separated values\n"
+			"  --json              print a JSON array\n"
+			"Latencies are percentiles in microseconds. queries/s is per thread for buckets\n"
+			"and the wall clock rate over all threads for the \"all\" row. The engines price\n"
+			"diagonals at DIAGONAL_COST / STRAIGHT_COST = 1.4, so a path that is optimal for\n"
+			"them can be up to about 1%% longer in octile length. Such a path costs them no\n"
+			"more than the optimal one and counts as optimal, with an error of 0.\n",
+			program);
+	}
+
+	bool ParseOptions(const int argc, char *argv[], RunnerOptions *options)
+	{
+		for (auto i = 1; i < argc; i++)
+		{
+			const std::string arg = argv[i];
+			const auto hasValue = i + 1 < argc;
+
+			if (arg == "--map" && hasValue)
+			{
+				options->map = argv[++i];
+			}
+			else if (arg == "--scen" && hasValue)
+			{
+				options->scenarios = argv[++i];
+			}
+			else if (arg == "--engine" && hasValue)
+			{
+				options->engines.push_back(argv[++i]);
+			}
+			else if (arg == "--connectivity" && hasValue)
+			{
+				if (!ParseConnectivity(argv[++i], &options->connectivity))
+					return false;
+			}
+			else if (arg == "--threads" && hasValue)
+			{
+				options->threads = std::atoi(argv[++i]);
+			}
+			else if (arg == "--tolerance" && hasValue)
+			{
+				options->tolerance = std::atof(argv[++i]);
+			}
+			else if (arg == "--csv")
+			{
+				options->format = OutputFormat::Csv;
+			}
+			else if (arg == "--json")
+			{
+				options->format = OutputFormat::Json;
+			}
+			else
+			{
+				return false;
+			}
+		}
+
+		// Reachability queries have no path to measure
+		if (options->engines.empty())
+		{
+			options->engines = GetSearchEngineNames();
+			options->engines.erase(std::remove(options->engines.begin(), options->engines.end(), "reach"), options->engines.end());
+		}
+		return !options->map.empty() && !options->scenarios.empty();
+	}
+
+	// Nearest-rank percentile of sorted values
+	double Percentile(const std::vector<double> &sorted, const double fraction)
+	{
+		if (sorted.empty())
+			return 0;
+		const auto rank = static_cast<std::size_t>(std::ceil(fraction * sorted.size()));
+		return sorted[std::max<std::size_t>(rank, 1) - 1];
+	}
+
+	BucketReport Summarize(const std::vector<Scenario> &scenarios, const std::vector<QueryResult> &results,
+		const std::vector<std::size_t> &queries, const double tolerance)
+	{
+		BucketReport report;
+		report.queries = queries.size();
+
+		std::vector<double> latencies;
+		auto seconds = 0.0;
+		auto expansions = 0.0;
+		for (const auto query : queries)
+		{
+			const auto &result = results[query];
+			latencies.push_back(result.seconds * 1e6);
+			seconds += result.seconds;
+			expansions += static_cast<double>(result.expansions);
+
+			if (!result.found)
+			{
+				report.failed++;
+				continue;
+			}
+
+			// Paths the engines price no higher than the optimal length are optimal under their move costs
+			auto error = std::fabs(result.length - scenarios[query].optimalLength);
+			long long optimalCost = 0;
+			if (GetOptimalCost(scenarios[query].optimalLength, &optimalCost) && result.cost <= optimalCost)
+				error = 0;
+			report.maxError = std::max(report.maxError, error);
+			if (error > tolerance)
+				report.mismatched++;
+		}
+
+		std::sort(latencies.begin(), latencies.end());
+		report.p50 = Percentile(latencies, 0.50);
+		report.p90 = Percentile(latencies, 0.90);
+		report.p99 = Percentile(latencies, 0.99);
+		report.meanExpansions = queries.empty() ? 0 : expansions / queries.size();
+		report.queriesPerSecond = seconds > 0 ? queries.size() / seconds : 0;
+		return report;
+	}
+
+	void PrintReports(const std::vector<BucketReport> &reports, const OutputFormat format)
+	{
+		if (format == OutputFormat::Csv)
+			std::printf("engine,bucket,queries,failed,mismatched,max_error,p50_us,p90_us,p99_us,mean_expansions,queries_per_sec\n");
+		else if (format == OutputFormat::Table)
+			std::printf("%-10s %6s %8s %7s %10s %10s %10s %10s %10s %12s %12s\n",
+				"engine", "bucket", "queries", "failed", "mismatched", "max_error", "p50_us", "p90_us", "p99_us", "expansions", "queries/s");
+		else
+			std::printf("[\n");
+
+		for (std::size_t i = 0; i < reports.size(); i++)
+		{
+			const auto &report = reports[i];
+			if (format == OutputFormat::Json)
+			{
+				std::printf("  {\"engine\": \"%s\", \"bucket\": \"%s\", \"queries\": %zu, \"failed\": %zu, \"mismatched\": %zu, "
+					"\"max_error\": %.6f, \"p50_us\": %.3f, \"p90_us\": %.3f, \"p99_us\": %.3f, \"mean_expansions\": %.1f, "
+					"\"queries_per_sec\": %.1f}%s\n",
+					report.engine.c_str(), report.bucket.c_str(), report.queries, report.failed, report.mismatched,
+					report.maxError, report.p50, report.p90, report.p99, report.meanExpansions, report.queriesPerSecond,
+					i + 1 < reports.size() ? "," : "");
+				continue;
+			}
+
+			std::printf(format == OutputFormat::Csv
+				? "%s,%s,%zu,%zu,%zu,%.6f,%.3f,%.3f,%.3f,%.1f,%.1f\n"
+				: "%-10s %6s %8zu %7zu %10zu %10.6f %10.3f %10.3f %10.3f %12.1f %12.1f\n",
+				report.engine.c_str(), report.bucket.c_str(), report.queries, report.failed, report.mismatched,
+				report.maxError, report.p50, report.p90, report.p99, report.meanExpansions, report.queriesPerSecond);
+		}
+
+		if (format == OutputFormat::Json)
+			std::printf("]\n");
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	RunnerOptions options;
+	if (!ParseOptions(argc, argv, &options))
+	{
+		PrintUsage(argv[0]);
+		return 1;
+	}
+
+	Grid grid;
+	std::vector<Scenario> scenarios;
+	std::string error;
+	if (!LoadMap(options.map, &grid, nullptr, &error) || !LoadScenarios(options.scenarios, &scenarios, &error))
+	{
+		std::fprintf(stderr, "%s\n", error.c_str());
+		return 1;
+	}
+
+	// Queries have to stay on the map's open cells, starting on a wall would open it
+	std::map<int, std::vector<std::size_t>> buckets;
+	std::vector<std::size_t> all;
+	for (std::size_t query = 0; query < scenarios.size(); query++)
+	{
+		const auto &scenario = scenarios[query];
+		const auto inside = [&](const int row, const int col)
+		{
+			return row >= 0 && col >= 0 && row < grid.GetRows() && col < grid.GetCols() && !grid.IsWall(grid.GetId(row, col));
+		};
+		if (!inside(scenario.startRow, scenario.startCol) || !inside(scenario.goalRow, scenario.goalCol))
+		{
+			std::fprintf(stderr, "Query %zu starts or ends outside the open cells of the map\n", query);
+			return 1;
+		}
+		buckets[scenario.bucket].push_back(query);
+		all.push_back(query);
+	}
+
+	ThreadPool pool(options.threads > 0 ? options.threads : ThreadPool::GetDefaultThreadCount());
+	const auto threads = pool.GetThreadCount();
+
+	// Searches write their state into the grid, every thread gets its own copy
+	std::vector<Grid> grids(threads, grid);
+	std::vector<BucketReport> reports;
+
+	for (const auto &name : options.engines)
+	{
+		std::vector<std::unique_ptr<SearchEngine>> engines;
+		for (auto worker = 0; worker < threads; worker++)
+		{
+			engines.emplace_back(CreateSearchEngine(name, options.connectivity));
+			if (engines.back() == nullptr)
+			{
+				std::fprintf(stderr, "Unknown engine: %s\n", name.c_str());
+				return 1;
+			}
+
+			// The queries are the parallel work
+			engines.back()->SetThreadCount(1);
+		}
+
+		std::vector<QueryResult> results(scenarios.size());
+		std::atomic<std::size_t> next(0);
+
+		const auto begin = std::chrono::steady_clock::now();
+		pool.Run([&](const int worker)
+		{
+			auto &local = grids[worker];
+			const auto &engine = engines[worker];
+
+			for (auto query = next++; query < scenarios.size(); query = next++)
+			{
+				const auto &scenario = scenarios[query];
+				local.SetStart(local.GetId(scenario.startRow, scenario.startCol));
+				local.SetGoal(local.GetId(scenario.goalRow, scenario.goalCol));
+
+				const auto queryBegin = std::chrono::steady_clock::now();
+				engine->Start(&local);
+				engine->Run();
+				const auto queryEnd = std::chrono::steady_clock::now();
+
+				auto &result = results[query];
+				result.seconds = std::chrono::duration<double>(queryEnd - queryBegin).count();
+				result.expansions = engine->GetStats().expansions;
+				result.found = engine->GetResult() != NO_CELL;
+				const auto path = local.GetPath(engine->GetResult());
+				result.length = GetOctileLength(local, path);
+				result.cost = GetPathCost(local, path);
+			}
+		});
+		const auto wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+		for (const auto &bucket : buckets)
+		{
+			reports.push_back(Summarize(scenarios, results, bucket.second, options.tolerance));
+			reports.back().engine = name;
+			reports.back().bucket = std::to_string(bucket.first);
+		}
+
+		reports.push_back(Summarize(scenarios, results, all, options.tolerance));
+		reports.back().engine = name;
+		reports.back().bucket = "all";
+		reports.back().queriesPerSecond = wallSeconds > 0 ? scenarios.size() / wallSeconds : 0;
+	}
+
+	PrintReports(reports, options.format);
+	return 0;
+}
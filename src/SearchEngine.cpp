@@ -0,0 +1,336 @@
+#include "SearchEngine.h"
+
+#include "AStarSearch.h"
+#include "BidirectionalSearch.h"
+#include "DijkstraSearch.h"
+#include "DirectionOptimizingSearch.h"
+#include "HierarchicalSearch.h"
+#include "IncrementalSearch.h"
+#include "JumpPointSearch.h"
+#include "ParallelSearch.h"
+#include "WavefrontSearch.h"
+
+#include <type_traits>
+
+SearchEngine::SearchEngine()
+	: m_grid(nullptr)
+	, m_trace(nullptr)
+	, m_finished(true)
+	, m_result(NO_CELL)
+{
+}
+
+void SearchEngine::Start(Grid *grid)
+{
+	this->m_grid = grid;
+	this->m_grid->ResetSearch();
+	this->m_finished = false;
+	this->m_result = NO_CELL;
+	this->m_stats = SearchStats();
+}
+
+void SearchEngine::Run()
+{
+	while (Step())
+	{
+	}
+}
+
+bool SearchEngine::IsFinished() const
+{
+	return this->m_finished;
+}
+
+int SearchEngine::GetResult() const
+{
+	return this->m_result;
+}
+
+void SearchEngine::SetTrace(std::vector<int> *trace)
+{
+	this->m_trace = trace;
+}
+
+void SearchEngine::SetThreadCount(int)
+{
+}
+
+const SearchStats &SearchEngine::GetStats() const
+{
+	return this->m_stats;
+}
+
+std::size_t SearchEngine::GetAllocatedBytes() const
+{
+	return this->m_grid != nullptr ? this->m_grid->GetSearchStateBytes() : 0;
+}
+
+void SearchEngine::Finish(const int result)
+{
+	this->m_finished = true;
+	this->m_result = result;
+}
+
+template <typename Conn>
+void BreadthFirstSearch<Conn>::Start(Grid *grid)
+{
+	SearchEngine::Start(grid);
+	this->m_queue.clear();
+	this->m_head = 0;
+
+	// Starting point
+	const auto start = grid->GetStart();
+	grid->SetVisited(start, true);
+	grid->SetDistance(start, 0);
+	this->m_queue.push_back(start);
+
+	if (start == grid->GetGoal())
+		Finish(start);
+}
+
+template <typename Conn>
+bool BreadthFirstSearch<Conn>::Step()
+{
+	return Expand();
+}
+
+template <typename Conn>
+void BreadthFirstSearch<Conn>::Run()
+{
+	while (Expand())
+	{
+	}
+}
+
+template <typename Conn>
+std::size_t BreadthFirstSearch<Conn>::GetAllocatedBytes() const
+{
+	return SearchEngine::GetAllocatedBytes() + GetBufferBytes(this->m_queue);
+}
+
+template <typename Conn>
+inline bool BreadthFirstSearch<Conn>::Expand()
+{
+	if (this->m_finished)
+		return false;
+
+	/*
+	 * Breadth-First Search algorithm
+	 *
+	 * Dequeue a cell from the queue.
+	 * Mark its unvisited neighbors as visited when they are discovered, so every
+	 * cell is queued once and its parent is on a shortest path.
+	 * Stop as soon as the goal is discovered.
+	 */
+
+	if (this->m_head == this->m_queue.size())
+	{
+		Finish(NO_CELL); // Goal NOT found
+		return false;
+	}
+
+	const auto current = this->m_queue[this->m_head++];
+	const auto distance = this->m_grid->GetDistance(current) + 1;
+	const auto goal = this->m_grid->GetGoal();
+
+	this->m_stats.expansions++;
+	if (this->m_trace != nullptr)
+		this->m_trace->push_back(current);
+
+	auto checks = 0;
+	Conn::ForEach(this->m_grid, current, [&](const int next, bool)
+	{
+		checks++;
+		if (this->m_grid->WasVisited(next))
+			return true;
+
+		this->m_grid->SetVisited(next, true);
+		this->m_grid->SetPrevious(next, current);
+		this->m_grid->SetDistance(next, distance);
+		this->m_queue.push_back(next);
+
+		if (next == goal)
+		{
+			Finish(next); // Goal found
+			return false;
+		}
+		return true;
+	});
+
+	this->m_stats.neighborChecks += checks;
+	const auto frontier = this->m_queue.size() - this->m_head;
+	if (frontier > this->m_stats.peakFrontier)
+		this->m_stats.peakFrontier = frontier;
+
+	return !this->m_finished;
+}
+
+template <typename Conn>
+void DepthFirstSearch<Conn>::Start(Grid *grid)
+{
+	SearchEngine::Start(grid);
+	this->m_stack.clear();
+
+	// Starting point
+	const auto start = grid->GetStart();
+	grid->SetDistance(start, 0);
+	this->m_stack.push_back(start);
+
+	if (start == grid->GetGoal())
+		Finish(start);
+}
+
+template <typename Conn>
+bool DepthFirstSearch<Conn>::Step()
+{
+	return Expand();
+}
+
+template <typename Conn>
+void DepthFirstSearch<Conn>::Run()
+{
+	while (Expand())
+	{
+	}
+}
+
+template <typename Conn>
+std::size_t DepthFirstSearch<Conn>::GetAllocatedBytes() const
+{
+	return SearchEngine::GetAllocatedBytes() + GetBufferBytes(this->m_stack);
+}
+
+template <typename Conn>
+inline bool DepthFirstSearch<Conn>::Expand()
+{
+	if (this->m_finished)
+		return false;
+
+	/*
+	 * Depth-First Search algorithm
+	 *
+	 * Pop cells off the stack until an unvisited one is found and mark it visited.
+	 * Push its unvisited neighbors onto the stack, a cell may be pushed more than
+	 * once before it is expanded.
+	 * Stop as soon as the goal is pushed.
+	 */
+
+	auto current = NO_CELL;
+	while (!this->m_stack.empty())
+	{
+		current = this->m_stack.back();
+		this->m_stack.pop_back();
+
+		if (!this->m_grid->WasVisited(current))
+			break;
+
+		current = NO_CELL;
+	}
+
+	if (current == NO_CELL)
+	{
+		Finish(NO_CELL); // Goal NOT found
+		return false;
+	}
+
+	this->m_grid->SetVisited(current, true);
+	this->m_stats.expansions++;
+	if (this->m_trace != nullptr)
+		this->m_trace->push_back(current);
+
+	const auto distance = this->m_grid->GetDistance(current) + 1;
+	const auto goal = this->m_grid->GetGoal();
+
+	auto checks = 0;
+	auto duplicates = 0;
+	Conn::ForEach(this->m_grid, current, [&](const int next, bool)
+	{
+		checks++;
+		if (this->m_grid->WasVisited(next))
+			return true;
+
+		// Pushed cells have a distance, a cell pushed again keeps its older entry on the stack
+		if (this->m_grid->GetDistance(next) != NO_DISTANCE)
+			duplicates++;
+
+		this->m_grid->SetPrevious(next, current);
+		this->m_grid->SetDistance(next, distance);
+		this->m_stack.push_back(next);
+
+		if (next == goal)
+		{
+			Finish(next); // Goal found
+			return false;
+		}
+		return true;
+	});
+
+	this->m_stats.neighborChecks += checks;
+	this->m_stats.duplicatePushes += duplicates;
+	if (this->m_stack.size() > this->m_stats.peakFrontier)
+		this->m_stats.peakFrontier = this->m_stack.size();
+
+	return !this->m_finished;
+}
+
+INSTANTIATE_ENGINE(BreadthFirstSearch)
+INSTANTIATE_ENGINE(DepthFirstSearch)
+
+SearchEngine *CreateSearchEngine(const std::string &name, const Connectivity connectivity)
+{
+	return DispatchConnectivity(connectivity, [&](auto policy) -> SearchEngine*
+	{
+		using Conn = decltype(policy);
+
+		if (name == "bfs")
+			return new BreadthFirstSearch<Conn>();
+		if (name == "dfs")
+			return new DepthFirstSearch<Conn>();
+		if (name == "dobfs")
+			return new DirectionOptimizingSearch<Conn>();
+		if (name == "pbfs")
+			return new ParallelSearch<Conn>();
+		if (name == "bibfs")
+			return new BidirectionalSearch<Conn>();
+		if (name == "wavefront")
+			return new WavefrontSearch<Conn>();
+		if (name == "reach")
+			return new WavefrontSearch<Conn>(WavefrontMode::Reachability);
+		if (name == "dijkstra")
+			return new DijkstraSearch<Conn>();
+		if (name == "astar")
+			return new AStarSearch<Conn>();
+		if (name == "lpa")
+			return new IncrementalSearch<Conn>();
+		if (name == "hpa")
+			return new HierarchicalSearch<Conn>();
+		if (name == "jps")
+		{
+			// Jump rules exist for square grids only
+			if constexpr (std::is_same<Conn, HexConnected>::value)
+				return new AStarSearch<Conn>();
+			else
+				return new JumpPointSearch<Conn>();
+		}
+		return nullptr;
+	});
+}
+
+const std::vector<std::string> &GetSearchEngineNames()
+{
+	static const std::vector<std::string> names = {
+		"bfs",
+		"dfs",
+		"dobfs",
+		"pbfs",
+		"bibfs",
+		"wavefront",
+		"reach",
+		"dijkstra",
+		"astar",
+		"jps",
+		"lpa",
+		"hpa",
+	};
+	return names;
+}
@@ -0,0 +1,119 @@
+#include "SearchReport.h"
+
+#include <cstdio>
+#include <ctime>
+#include <memory>
+
+namespace
+{
+	// Quotes a string for JSON, names are plain ASCII but control characters and quotes are escaped anyway
+	std::string QuoteJson(const std::string &text)
+	{
+		std::string quoted = "\"";
+		for (const auto c : text)
+		{
+			if (c == '"' || c == '\\')
+			{
+				quoted += '\\';
+				quoted += c;
+			}
+			else if (static_cast<unsigned char>(c) < 0x20)
+			{
+				char escaped[8];
+				std::snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned>(c));
+				quoted += escaped;
+			}
+			else
+			{
+				quoted += c;
+			}
+		}
+		return quoted + "\"";
+	}
+
+	bool EndsWith(const std::string &text, const std::string &suffix)
+	{
+		return text.size() >= suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+	}
+
+	using FilePointer = std::unique_ptr<std::FILE, int(*)(std::FILE*)>;
+}
+
+double SearchRecord::GetNsPerExpansion() const
+{
+	return this->stats.expansions > 0 ? static_cast<double>(this->searchNs) / this->stats.expansions : 0.0;
+}
+
+void CollectSearchRecord(const SearchEngine &engine, SearchRecord *record)
+{
+	record->stats = engine.GetStats();
+	record->allocatedBytes = engine.GetAllocatedBytes();
+	record->timestamp = static_cast<std::int64_t>(std::time(nullptr));
+}
+
+std::string FormatSearchRecordJson(const SearchRecord &record)
+{
+	char numbers[512];
+	std::snprintf(numbers, sizeof(numbers),
+		"\"rows\":%d,\"cols\":%d,\"found\":%s,\"path_cells\":%zu,\"expansions\":%llu,\"neighbor_checks\":%llu,"
+		"\"duplicate_pushes\":%llu,\"peak_frontier\":%zu,\"allocated_bytes\":%zu,\"setup_ns\":%llu,\"search_ns\":%llu,"
+		"\"path_ns\":%llu,\"ns_per_expansion\":%.2f,\"timestamp\":%lld",
+		record.rows, record.cols, record.found ? "true" : "false", record.pathCells,
+		static_cast<unsigned long long>(record.stats.expansions), static_cast<unsigned long long>(record.stats.neighborChecks),
+		static_cast<unsigned long long>(record.stats.duplicatePushes), record.stats.peakFrontier, record.allocatedBytes,
+		static_cast<unsigned long long>(record.setupNs), static_cast<unsigned long long>(record.searchNs),
+		static_cast<unsigned long long>(record.pathNs), record.GetNsPerExpansion(), static_cast<long long>(record.timestamp));
+
+	return "{\"engine\":" + QuoteJson(record.engine) + ",\"connectivity\":" + QuoteJson(record.connectivity) + "," + numbers + "}";
+}
+
+std::string GetSearchRecordCsvHeader()
+{
+	return "engine,connectivity,rows,cols,found,path_cells,expansions,neighbor_checks,duplicate_pushes,peak_frontier,"
+		"allocated_bytes,setup_ns,search_ns,path_ns,ns_per_expansion,timestamp";
+}
+
+std::string FormatSearchRecordCsv(const SearchRecord &record)
+{
+	char numbers[512];
+	std::snprintf(numbers, sizeof(numbers), "%d,%d,%d,%zu,%llu,%llu,%llu,%zu,%zu,%llu,%llu,%llu,%.2f,%lld",
+		record.rows, record.cols, record.found ? 1 : 0, record.pathCells,
+		static_cast<unsigned long long>(record.stats.expansions), static_cast<unsigned long long>(record.stats.neighborChecks),
+		static_cast<unsigned long long>(record.stats.duplicatePushes), record.stats.peakFrontier, record.allocatedBytes,
+		static_cast<unsigned long long>(record.setupNs), static_cast<unsigned long long>(record.searchNs),
+		static_cast<unsigned long long>(record.pathNs), record.GetNsPerExpansion(), static_cast<long long>(record.timestamp));
+
+	// Names never hold commas
+	return record.engine + "," + record.connectivity + "," + numbers;
+}
+
+bool AppendSearchRecord(const std::string &path, const SearchRecord &record, std::string *error)
+{
+	FilePointer file(std::fopen(path.c_str(), "ab"), &std::fclose);
+	if (file == nullptr)
+	{
+		*error = "Cannot write " + path;
+		return false;
+	}
+
+	std::string lines;
+	if (EndsWith(path, ".csv"))
+	{
+		// Append mode starts at the end, an empty file needs the header first
+		std::fseek(file.get(), 0, SEEK_END);
+		if (std::ftell(file.get()) == 0)
+			lines = GetSearchRecordCsvHeader() + "\n";
+		lines += FormatSearchRecordCsv(record) + "\n";
+	}
+	else
+	{
+		lines = FormatSearchRecordJson(record) + "\n";
+	}
+
+	if (std::fwrite(lines.data(), 1, lines.size(), file.get()) != lines.size() || std::fflush(file.get()) != 0)
+	{
+		*error = "Cannot write " + path;
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,143 @@
+#include "SearchWorker.h"
+
+namespace
+{
+	using Clock = std::chrono::steady_clock;
+
+	std::uint64_t GetNanoseconds(const Clock::time_point begin)
+	{
+		return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - begin).count());
+	}
+}
+
+SearchWorker::SearchWorker()
+	: m_cancelled(false)
+	, m_returned(true)
+	, m_cells(WORKER_CELL_QUEUE)
+	, m_progress(WORKER_PROGRESS_QUEUE)
+{
+}
+
+SearchWorker::~SearchWorker()
+{
+	Cancel();
+	Wait();
+}
+
+void SearchWorker::Start(SearchEngine *engine, Grid *grid, const bool search, const std::chrono::microseconds interval)
+{
+	Cancel();
+	Wait();
+
+	// Nothing else uses the queues while no thread runs
+	this->m_cells.Clear();
+	this->m_progress.Clear();
+	this->m_cancelled = false;
+	this->m_returned = false;
+	this->m_thread = std::thread(&SearchWorker::Run, this, engine, grid, search, interval);
+}
+
+void SearchWorker::Cancel()
+{
+	{
+		std::lock_guard<std::mutex> lock(this->m_mutex);
+		this->m_cancelled = true;
+	}
+	this->m_wake.notify_all();
+}
+
+void SearchWorker::Wait()
+{
+	if (this->m_thread.joinable())
+		this->m_thread.join();
+}
+
+bool SearchWorker::IsRunning() const
+{
+	return this->m_thread.joinable() && !this->m_returned.load(std::memory_order_acquire);
+}
+
+bool SearchWorker::PopCell(int *id)
+{
+	return this->m_cells.TryPop(id);
+}
+
+bool SearchWorker::PopProgress(SearchProgress *progress)
+{
+	return this->m_progress.TryPop(progress);
+}
+
+void SearchWorker::Run(SearchEngine *engine, Grid *grid, const bool search, const std::chrono::microseconds interval)
+{
+	SearchProgress progress;
+	this->m_trace.clear();
+	engine->SetTrace(&this->m_trace);
+
+	auto begin = Clock::now();
+	engine->Start(grid);
+	progress.setupNs = GetNanoseconds(begin);
+
+	auto running = search && !engine->IsFinished();
+	while (running && !this->m_cancelled.load(std::memory_order_relaxed))
+	{
+		this->m_trace.clear();
+		begin = Clock::now();
+		running = engine->Step();
+		progress.searchNs += GetNanoseconds(begin);
+
+		if (!PublishCells())
+			break;
+
+		if (running)
+		{
+			PublishProgress(*engine, &progress);
+
+			// Pause before the next step unless cancelled meanwhile
+			std::unique_lock<std::mutex> lock(this->m_mutex);
+			this->m_wake.wait_for(lock, interval, [this] { return this->m_cancelled.load(); });
+		}
+	}
+
+	// A cancelled search is abandoned, its owner stopped listening
+	if (this->m_cancelled)
+	{
+		this->m_returned.store(true, std::memory_order_release);
+		return;
+	}
+
+	begin = Clock::now();
+	progress.pathCells = grid->GetPath(engine->GetResult()).size();
+	progress.pathNs = GetNanoseconds(begin);
+	progress.finished = true;
+	progress.result = engine->GetResult();
+	PublishProgress(*engine, &progress);
+	this->m_returned.store(true, std::memory_order_release);
+}
+
+bool SearchWorker::PublishCells()
+{
+	for (const auto id : this->m_trace)
+	{
+		while (!this->m_cells.TryPush(id))
+		{
+			if (this->m_cancelled.load(std::memory_order_relaxed))
+				return false;
+			std::this_thread::yield();
+		}
+	}
+	return true;
+}
+
+void SearchWorker::PublishProgress(const SearchEngine &engine, SearchProgress *progress)
+{
+	progress->stats = engine.GetStats();
+	progress->allocatedBytes = engine.GetAllocatedBytes();
+
+	// Reports in between are superseded by the next one, the last has to arrive
+	while (!this->m_progress.TryPush(*progress) && progress->finished)
+	{
+		if (this->m_cancelled.load(std::memory_order_relaxed))
+			return;
+		std::this_thread::yield();
+	}
+}
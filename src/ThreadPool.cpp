@@ -0,0 +1,96 @@
+#include "ThreadPool.h"
+
+namespace
+{
+	// Polls before a waiting thread yields to the scheduler or goes to sleep
+	const int SpinCount = 2000;
+}
+
+ThreadPool::ThreadPool(const int threads)
+	: m_job(nullptr)
+	, m_generation(0)
+	, m_pending(0)
+	, m_stopping(false)
+{
+	for (auto worker = 1; worker < threads; worker++)
+		this->m_workers.emplace_back(&ThreadPool::WorkerLoop, this, worker);
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(this->m_mutex);
+		this->m_stopping = true;
+	}
+	this->m_wake.notify_all();
+
+	for (auto &worker : this->m_workers)
+		worker.join();
+}
+
+int ThreadPool::GetThreadCount() const
+{
+	return static_cast<int>(this->m_workers.size()) + 1;
+}
+
+int ThreadPool::GetDefaultThreadCount()
+{
+	const auto threads = static_cast<int>(std::thread::hardware_concurrency());
+	return threads > 0 ? threads : 1;
+}
+
+void ThreadPool::Run(const std::function<void(int)> &job)
+{
+	if (this->m_workers.empty())
+	{
+		job(0);
+		return;
+	}
+
+	// Publish the job
+	this->m_job = &job;
+	this->m_pending.store(static_cast<int>(this->m_workers.size()), std::memory_order_relaxed);
+	{
+		std::lock_guard<std::mutex> lock(this->m_mutex);
+		this->m_generation.fetch_add(1, std::memory_order_release);
+	}
+	this->m_wake.notify_all();
+
+	job(0);
+
+	// Wait for the other workers
+	for (auto spin = 0; this->m_pending.load(std::memory_order_acquire) != 0; spin++)
+	{
+		if (spin >= SpinCount)
+			std::this_thread::yield();
+	}
+}
+
+void ThreadPool::WorkerLoop(const int worker)
+{
+	std::uint64_t seen = 0;
+
+	while (true)
+	{
+		// Spin for the next generation, then sleep
+		auto spin = 0;
+		while (this->m_generation.load(std::memory_order_acquire) == seen && !this->m_stopping)
+		{
+			if (++spin < SpinCount)
+				continue;
+
+			std::unique_lock<std::mutex> lock(this->m_mutex);
+			this->m_wake.wait(lock, [&]
+			{
+				return this->m_generation.load(std::memory_order_acquire) != seen || this->m_stopping;
+			});
+		}
+
+		if (this->m_stopping)
+			return;
+
+		seen = this->m_generation.load(std::memory_order_acquire);
+		(*this->m_job)(worker);
+		this->m_pending.fetch_sub(1, std::memory_order_acq_rel);
+	}
+}
@@ -0,0 +1,530 @@
+#include "TiledMap.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+	const char TiledMagic[8] = { 'G', 'R', 'I', 'D', 'T', 'I', 'L', 'E' };
+
+	// Bytes of one tile in the file
+	const std::uint64_t TileBytes = TILE_SIZE * sizeof(GridWord);
+
+	static_assert(TILE_SIZE == 64, "a tile row has to fill one GridWord");
+
+	// Spreads the low 16 bits of a value to the even bit positions
+	std::uint64_t SpreadBits(std::uint64_t value)
+	{
+		value &= 0xffff;
+		value = (value | (value << 8)) & 0x00ff00ff;
+		value = (value | (value << 4)) & 0x0f0f0f0f;
+		value = (value | (value << 2)) & 0x33333333;
+		value = (value | (value << 1)) & 0x55555555;
+		return value;
+	}
+
+	// Rounds towards negative infinity, windows may start above or left of the map
+	int FloorDiv(const int value, const int divisor)
+	{
+		return value >= 0 ? value / divisor : -((-value + divisor - 1) / divisor);
+	}
+
+	// Ors count bits into the bitset starting at bit first
+	void OrBits(GridWord *words, const int first, const GridWord bits, const int count)
+	{
+		const auto shift = first & 63;
+		words[first >> 6] |= bits << shift;
+		if (shift + count > 64)
+			words[(first >> 6) + 1] |= bits >> (64 - shift);
+	}
+
+	// Lowest count bits set
+	GridWord LowBits(const int count)
+	{
+		return count >= 64 ? ~GridWord(0) : (GridWord(1) << count) - 1;
+	}
+
+	// Fills in the layout of a map of the given size
+	TiledMapHeader MakeHeader(const int rows, const int cols)
+	{
+		TiledMapHeader header {};
+		std::memcpy(header.magic, TiledMagic, sizeof(TiledMagic));
+		header.version = TILED_MAP_FORMAT_VERSION;
+		header.tileSize = TILE_SIZE;
+		header.rows = rows;
+		header.cols = cols;
+		header.tileRows = (rows + TILE_SIZE - 1) / TILE_SIZE;
+		header.tileCols = (cols + TILE_SIZE - 1) / TILE_SIZE;
+		header.blockShift = TILE_BLOCK_SHIFT;
+		header.tilesOffset = sizeof(TiledMapHeader);
+
+		const auto blockSide = 1 << TILE_BLOCK_SHIFT;
+		const auto blockRows = static_cast<std::uint64_t>((header.tileRows + blockSide - 1) / blockSide);
+		const auto blockCols = static_cast<std::uint64_t>((header.tileCols + blockSide - 1) / blockSide);
+		header.tileCount = (blockRows * blockCols) << (2 * TILE_BLOCK_SHIFT);
+		return header;
+	}
+}
+
+TiledMap::TiledMap()
+	: m_header()
+	, m_writable(false)
+#ifndef _WIN32
+	, m_data(nullptr)
+	, m_size(0)
+#endif
+	, m_capacity(DEFAULT_TILE_CACHE_CAPACITY)
+	, m_clock(0)
+{
+}
+
+TiledMap::~TiledMap()
+{
+	Close();
+}
+
+bool TiledMap::Create(const std::string &path, const int rows, const int cols, std::string *error)
+{
+	Close();
+	if (rows <= 0 || cols <= 0)
+	{
+		*error = "Invalid map size";
+		return false;
+	}
+
+	// The file is extended without writing the tiles, they read as open cells
+	const auto header = MakeHeader(rows, cols);
+	const auto size = header.tilesOffset + header.tileCount * TileBytes;
+#ifdef _WIN32
+	{
+		std::ofstream file(path, std::ios::binary | std::ios::trunc);
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.seekp(static_cast<std::streamoff>(size - 1));
+		file.put('\0');
+		if (!file)
+		{
+			*error = "Cannot write " + path;
+			return false;
+		}
+	}
+#else
+	const auto descriptor = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (descriptor < 0)
+	{
+		*error = "Cannot write " + path;
+		return false;
+	}
+	const auto written = pwrite(descriptor, &header, sizeof(header), 0) == static_cast<ssize_t>(sizeof(header))
+		&& ftruncate(descriptor, static_cast<off_t>(size)) == 0;
+	close(descriptor);
+	if (!written)
+	{
+		*error = "Cannot write " + path;
+		return false;
+	}
+#endif
+
+	if (!Open(path, true, error))
+		return false;
+
+	// Walls past the edge, only the last tile row and column have any
+	const std::vector<GridWord> open(TILE_SIZE, 0);
+	for (auto tileCol = 0; tileCol < this->m_header.tileCols; tileCol++)
+		WriteTile(this->m_header.tileRows - 1, tileCol, open.data());
+	for (auto tileRow = 0; tileRow < this->m_header.tileRows - 1; tileRow++)
+		WriteTile(tileRow, this->m_header.tileCols - 1, open.data());
+	return true;
+}
+
+bool TiledMap::Open(const std::string &path, const bool writable, std::string *error)
+{
+	Close();
+	if (!MapData(path, writable, error))
+		return false;
+
+	this->m_writable = writable;
+	return true;
+}
+
+bool TiledMap::MapData(const std::string &path, const bool writable, std::string *error)
+{
+	TiledMapHeader header {};
+	std::uint64_t fileSize = 0;
+#ifdef _WIN32
+	this->m_file.open(path, std::ios::binary | std::ios::in | (writable ? std::ios::out : std::ios::in));
+	if (!this->m_file)
+	{
+		*error = "Cannot open " + path;
+		return false;
+	}
+	this->m_file.seekg(0, std::ios::end);
+	fileSize = static_cast<std::uint64_t>(this->m_file.tellg());
+	this->m_file.seekg(0);
+	this->m_file.read(reinterpret_cast<char*>(&header), sizeof(header));
+	if (!this->m_file)
+		fileSize = 0;
+#else
+	const auto descriptor = open(path.c_str(), writable ? O_RDWR : O_RDONLY);
+	if (descriptor < 0)
+	{
+		*error = "Cannot open " + path;
+		return false;
+	}
+
+	struct stat status {};
+	if (fstat(descriptor, &status) != 0 || pread(descriptor, &header, sizeof(header), 0) != static_cast<ssize_t>(sizeof(header)))
+	{
+		close(descriptor);
+		*error = "Cannot read " + path;
+		return false;
+	}
+	fileSize = static_cast<std::uint64_t>(status.st_size);
+#endif
+
+	// The layout has to be the one this build computes, and fit the file
+	const auto expected = MakeHeader(header.rows > 0 ? header.rows : 1, header.cols > 0 ? header.cols : 1);
+	auto valid = std::memcmp(header.magic, TiledMagic, sizeof(TiledMagic)) == 0;
+	if (valid && (header.version < 1 || header.version > TILED_MAP_FORMAT_VERSION))
+	{
+		*error = "Unsupported tiled map version " + std::to_string(header.version);
+		valid = false;
+	}
+	else if (!valid || header.tileSize != TILE_SIZE || header.blockShift != TILE_BLOCK_SHIFT
+		|| header.rows <= 0 || header.cols <= 0 || header.tileRows != expected.tileRows || header.tileCols != expected.tileCols
+		|| header.tileCount != expected.tileCount || header.tilesOffset < sizeof(header)
+		|| header.tilesOffset > fileSize || header.tileCount > (fileSize - header.tilesOffset) / TileBytes)
+	{
+		*error = "Not a tiled map or truncated: " + path;
+		valid = false;
+	}
+
+#ifdef _WIN32
+	if (!valid)
+		this->m_file.close();
+#else
+	if (valid)
+	{
+		// Tiles are paged in on first use, in no particular order
+		const auto data = mmap(nullptr, fileSize, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, descriptor, 0);
+		if (data == MAP_FAILED)
+		{
+			*error = "Cannot map " + path;
+			valid = false;
+		}
+		else
+		{
+			madvise(data, fileSize, MADV_RANDOM);
+			this->m_data = static_cast<char*>(data);
+			this->m_size = fileSize;
+		}
+	}
+	close(descriptor);
+#endif
+
+	if (valid)
+		this->m_header = header;
+	return valid;
+}
+
+void TiledMap::Close()
+{
+#ifdef _WIN32
+	if (this->m_file.is_open())
+		this->m_file.close();
+#else
+	if (this->m_data != nullptr)
+	{
+		if (this->m_writable)
+			msync(this->m_data, this->m_size, MS_SYNC);
+		munmap(this->m_data, this->m_size);
+		this->m_data = nullptr;
+		this->m_size = 0;
+	}
+#endif
+
+	ClearCache();
+	this->m_header = TiledMapHeader();
+	this->m_writable = false;
+}
+
+int TiledMap::GetRows() const
+{
+	return this->m_header.rows;
+}
+
+int TiledMap::GetCols() const
+{
+	return this->m_header.cols;
+}
+
+int TiledMap::GetTileRows() const
+{
+	return this->m_header.tileRows;
+}
+
+int TiledMap::GetTileCols() const
+{
+	return this->m_header.tileCols;
+}
+
+std::uint64_t TiledMap::GetTileIndex(const int tileRow, const int tileCol) const
+{
+	// Blocks row by row, tiles in Z-order within a block
+	const auto blockSide = 1 << TILE_BLOCK_SHIFT;
+	const auto blockCols = static_cast<std::uint64_t>((this->m_header.tileCols + blockSide - 1) / blockSide);
+	const auto block = static_cast<std::uint64_t>(tileRow >> TILE_BLOCK_SHIFT) * blockCols + (tileCol >> TILE_BLOCK_SHIFT);
+	const auto mask = blockSide - 1;
+	return (block << (2 * TILE_BLOCK_SHIFT)) | (SpreadBits(tileRow & mask) << 1) | SpreadBits(tileCol & mask);
+}
+
+bool TiledMap::IsWall(const int row, const int col)
+{
+	const auto tile = GetTile(FloorDiv(row, TILE_SIZE), FloorDiv(col, TILE_SIZE));
+	if (tile == nullptr)
+		return true;
+	return (tile[row % TILE_SIZE] >> (col % TILE_SIZE)) & 1;
+}
+
+void TiledMap::SetWall(const int row, const int col, const bool wall)
+{
+	if (!this->m_writable || row < 0 || col < 0 || row >= this->m_header.rows || col >= this->m_header.cols)
+		return;
+
+	const auto tileRow = row / TILE_SIZE;
+	const auto tileCol = col / TILE_SIZE;
+	const auto tile = GetTile(tileRow, tileCol);
+	const auto bit = GridWord(1) << (col % TILE_SIZE);
+	if (wall)
+		tile[row % TILE_SIZE] |= bit;
+	else
+		tile[row % TILE_SIZE] &= ~bit;
+	WriteTileData(GetTileIndex(tileRow, tileCol), tile);
+}
+
+void TiledMap::ReadTile(const int tileRow, const int tileCol, GridWord *words)
+{
+	const auto tile = GetTile(tileRow, tileCol);
+	if (tile == nullptr)
+		std::fill(words, words + TILE_SIZE, ~GridWord(0));
+	else
+		std::copy(tile, tile + TILE_SIZE, words);
+}
+
+void TiledMap::WriteTile(const int tileRow, const int tileCol, const GridWord *words)
+{
+	if (!this->m_writable)
+		return;
+
+	const auto tile = GetTile(tileRow, tileCol);
+	if (tile == nullptr)
+		return;
+
+	// Rows past the bottom edge are all walls
+	const auto rows = std::min(TILE_SIZE, this->m_header.rows - tileRow * TILE_SIZE);
+	const auto edge = GetEdgeMask(tileCol);
+	for (auto row = 0; row < TILE_SIZE; row++)
+		tile[row] = row < rows ? words[row] | edge : ~GridWord(0);
+	WriteTileData(GetTileIndex(tileRow, tileCol), tile);
+}
+
+void TiledMap::LoadWindow(const TiledWindow &window, Grid *grid)
+{
+	grid->Resize(window.rows, window.cols);
+	this->m_windowWords.assign(grid->GetWordCount(), 0);
+
+	// One lookup per tile, each tile row contributes one run of bits to a grid row
+	const auto lastRow = window.row + window.rows - 1;
+	const auto lastCol = window.col + window.cols - 1;
+	for (auto tileRow = FloorDiv(window.row, TILE_SIZE); tileRow <= FloorDiv(lastRow, TILE_SIZE); tileRow++)
+	{
+		for (auto tileCol = FloorDiv(window.col, TILE_SIZE); tileCol <= FloorDiv(lastCol, TILE_SIZE); tileCol++)
+		{
+			const auto tile = GetTile(tileRow, tileCol);
+			const auto firstRow = std::max(window.row, tileRow * TILE_SIZE);
+			const auto endRow = std::min(lastRow + 1, tileRow * TILE_SIZE + TILE_SIZE);
+			const auto firstCol = std::max(window.col, tileCol * TILE_SIZE);
+			const auto count = std::min(lastCol + 1, tileCol * TILE_SIZE + TILE_SIZE) - firstCol;
+			const auto shift = firstCol - tileCol * TILE_SIZE;
+
+			for (auto row = firstRow; row < endRow; row++)
+			{
+				const auto bits = tile == nullptr ? ~GridWord(0) : tile[row - tileRow * TILE_SIZE];
+				OrBits(this->m_windowWords.data(), grid->GetId(row - window.row, firstCol - window.col),
+					(bits >> shift) & LowBits(count), count);
+			}
+		}
+	}
+
+	grid->SetWallWords(this->m_windowWords.data());
+}
+
+void TiledMap::SetCacheCapacity(const std::size_t tiles)
+{
+	ClearCache();
+	this->m_capacity = std::max<std::size_t>(tiles, 1);
+}
+
+const TileCacheStats &TiledMap::GetCacheStats() const
+{
+	return this->m_stats;
+}
+
+void TiledMap::ResetCacheStats()
+{
+	this->m_stats = TileCacheStats();
+}
+
+GridWord *TiledMap::GetTile(const int tileRow, const int tileCol)
+{
+	if (tileRow < 0 || tileCol < 0 || tileRow >= this->m_header.tileRows || tileCol >= this->m_header.tileCols)
+		return nullptr;
+
+	const auto index = GetTileIndex(tileRow, tileCol);
+	const auto cached = this->m_tileSlots.find(index);
+	if (cached != this->m_tileSlots.end())
+	{
+		this->m_stats.hits++;
+		this->m_referenced[cached->second] = 1;
+		return &this->m_slots[cached->second * TILE_SIZE];
+	}
+
+	this->m_stats.misses++;
+	const auto slot = AllocateSlot();
+	const auto words = &this->m_slots[slot * TILE_SIZE];
+	ReadTileData(index, words);
+	this->m_slotTiles[slot] = index;
+	this->m_referenced[slot] = 1;
+	this->m_tileSlots.emplace(index, slot);
+	return words;
+}
+
+std::size_t TiledMap::AllocateSlot()
+{
+	// The cache grows up to its capacity before anything is evicted
+	if (this->m_slotTiles.size() < this->m_capacity)
+	{
+		this->m_slots.resize(this->m_slots.size() + TILE_SIZE);
+		this->m_slotTiles.push_back(0);
+		this->m_referenced.push_back(0);
+		return this->m_slotTiles.size() - 1;
+	}
+
+	// Second chance for tiles used since the clock last passed them
+	while (this->m_referenced[this->m_clock])
+	{
+		this->m_referenced[this->m_clock] = 0;
+		this->m_clock = (this->m_clock + 1) % this->m_slotTiles.size();
+	}
+
+	const auto slot = this->m_clock;
+	this->m_clock = (this->m_clock + 1) % this->m_slotTiles.size();
+	this->m_tileSlots.erase(this->m_slotTiles[slot]);
+	this->m_stats.evictions++;
+	return slot;
+}
+
+void TiledMap::ClearCache()
+{
+	this->m_tileSlots.clear();
+	this->m_slots.clear();
+	this->m_slots.shrink_to_fit();
+	this->m_slotTiles.clear();
+	this->m_referenced.clear();
+	this->m_clock = 0;
+}
+
+void TiledMap::ReadTileData(const std::uint64_t index, GridWord *words)
+{
+	const auto offset = this->m_header.tilesOffset + index * TileBytes;
+#ifdef _WIN32
+	this->m_file.seekg(static_cast<std::streamoff>(offset));
+	this->m_file.read(reinterpret_cast<char*>(words), TileBytes);
+#else
+	std::memcpy(words, this->m_data + offset, TileBytes);
+#endif
+}
+
+void TiledMap::WriteTileData(const std::uint64_t index, const GridWord *words)
+{
+	const auto offset = this->m_header.tilesOffset + index * TileBytes;
+#ifdef _WIN32
+	this->m_file.seekp(static_cast<std::streamoff>(offset));
+	this->m_file.write(reinterpret_cast<const char*>(words), TileBytes);
+#else
+	std::memcpy(this->m_data + offset, words, TileBytes);
+#endif
+}
+
+GridWord TiledMap::GetEdgeMask(const int tileCol) const
+{
+	const auto cols = this->m_header.cols - tileCol * TILE_SIZE;
+	return cols >= TILE_SIZE ? 0 : ~LowBits(cols);
+}
+
+TiledSearchResult SearchTiledMap(TiledMap *map, SearchEngine *engine, Grid *grid,
+	const int startRow, const int startCol, const int goalRow, const int goalCol, const std::uint64_t maxCells)
+{
+	TiledSearchResult result;
+	const auto inside = [map](const int row, const int col)
+	{
+		return row >= 0 && col >= 0 && row < map->GetRows() && col < map->GetCols();
+	};
+	if (!inside(startRow, startCol) || !inside(goalRow, goalCol))
+		return result;
+
+	const auto span = std::max(std::abs(goalRow - startRow), std::abs(goalCol - startCol));
+
+	// Windows are aligned to tiles, so every tile is copied whole
+	const auto align = [](const int value, const int limit, const bool up)
+	{
+		const auto tile = FloorDiv(value, TILE_SIZE) + (up ? 1 : 0);
+		return std::max(0, std::min(limit, tile * TILE_SIZE));
+	};
+
+	for (auto margin = std::max(TILE_SIZE, span / 2); ; margin *= 2)
+	{
+		TiledWindow window;
+		window.row = align(std::min(startRow, goalRow) - margin, map->GetRows(), false);
+		window.col = align(std::min(startCol, goalCol) - margin, map->GetCols(), false);
+		window.rows = align(std::max(startRow, goalRow) + margin, map->GetRows(), true) - window.row;
+		window.cols = align(std::max(startCol, goalCol) + margin, map->GetCols(), true) - window.col;
+
+		// Grid ids count the sentinel border as well
+		const auto cells = static_cast<std::uint64_t>(window.rows) * window.cols;
+		if (cells > maxCells || static_cast<std::uint64_t>(window.rows + 2) * (window.cols + 2) > INT_MAX)
+			break;
+
+		map->LoadWindow(window, grid);
+		grid->SetStart(grid->GetId(startRow - window.row, startCol - window.col));
+		grid->SetGoal(grid->GetId(goalRow - window.row, goalCol - window.col));
+		engine->Start(grid);
+		engine->Run();
+
+		result.windows++;
+		result.windowCells = cells;
+		result.expansions += engine->GetStats().expansions;
+		result.peakFrontier = std::max(result.peakFrontier, engine->GetStats().peakFrontier);
+
+		if (engine->GetResult() != NO_CELL)
+		{
+			result.found = true;
+			for (const auto id : grid->GetPath(engine->GetResult()))
+				result.path.emplace_back(grid->GetRow(id) + window.row, grid->GetCol(id) + window.col);
+			break;
+		}
+
+		// Nothing left to grow into
+		if (window.rows == map->GetRows() && window.cols == map->GetCols())
+			break;
+	}
+	return result;
+}
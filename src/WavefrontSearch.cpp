@@ -0,0 +1,391 @@
+#include "WavefrontSearch.h"
+
+#include <algorithm>
+
+namespace
+{
+	// Splits a signed bit offset into whole words and remaining bits, rounding down
+	BitShift MakeShift(const int offset)
+	{
+		const auto words = offset >= 0 ? offset / 64 : -((-offset + 63) / 64);
+		return { words, offset - words * 64 };
+	}
+
+	// Word of a bitset shifted towards higher ids, bit i of the result is bit i - offset of the input
+	inline GridWord Shifted(const GridWord *bits, const int word, const BitShift shift)
+	{
+		const auto source = word - shift.words;
+		if (shift.bits == 0)
+			return bits[source];
+		return (bits[source] << shift.bits) | (bits[source - 1] >> (64 - shift.bits));
+	}
+
+	// Spreads the set bits of a word through the runs of open cells towards higher bits, in six doublings
+	inline GridWord FillUp(GridWord bits, GridWord open)
+	{
+		for (auto shift = 1; shift < 64; shift *= 2)
+		{
+			bits |= open & (bits << shift);
+			open &= open << shift;
+		}
+		return bits;
+	}
+
+	// Same towards lower bits
+	inline GridWord FillDown(GridWord bits, GridWord open)
+	{
+		for (auto shift = 1; shift < 64; shift *= 2)
+		{
+			bits |= open & (bits >> shift);
+			open &= open >> shift;
+		}
+		return bits;
+	}
+
+	/*
+	 * Neighbor offsets per connectivity policy. Offsets(stride, offsets) lists
+	 * the offsets in the order of the shifts Spread(frontier, walls, word,
+	 * shifts) receives, Spread returns the cells of a word that a frontier cell
+	 * can move to, walls not yet removed.
+	 */
+	template <typename Conn>
+	struct WavefrontRules;
+
+	template <>
+	struct WavefrontRules<FourConnected>
+	{
+		static void Offsets(const int stride, int *offsets)
+		{
+			offsets[0] = stride;
+			offsets[1] = -stride;
+			offsets[2] = 1;
+			offsets[3] = -1;
+		}
+
+		static GridWord Spread(const GridWord *frontier, const GridWord *, const int word, const BitShift *shifts)
+		{
+			return Shifted(frontier, word, shifts[0]) | Shifted(frontier, word, shifts[1])
+				| Shifted(frontier, word, shifts[2]) | Shifted(frontier, word, shifts[3]);
+		}
+	};
+
+	template <>
+	struct WavefrontRules<HexConnected>
+	{
+		static void Offsets(const int stride, int *offsets)
+		{
+			WavefrontRules<FourConnected>::Offsets(stride, offsets);
+			offsets[4] = -stride + 1;
+			offsets[5] = stride - 1;
+		}
+
+		static GridWord Spread(const GridWord *frontier, const GridWord *walls, const int word, const BitShift *shifts)
+		{
+			return WavefrontRules<FourConnected>::Spread(frontier, walls, word, shifts)
+				| Shifted(frontier, word, shifts[4]) | Shifted(frontier, word, shifts[5]);
+		}
+	};
+
+	template <CornerCutting Rule>
+	struct WavefrontRules<EightConnected<Rule>>
+	{
+		static void Offsets(const int stride, int *offsets)
+		{
+			WavefrontRules<FourConnected>::Offsets(stride, offsets);
+			offsets[4] = stride + 1;
+			offsets[5] = stride - 1;
+			offsets[6] = -stride + 1;
+			offsets[7] = -stride - 1;
+		}
+
+		static GridWord Spread(const GridWord *frontier, const GridWord *walls, const int word, const BitShift *shifts)
+		{
+			const auto straight = WavefrontRules<FourConnected>::Spread(frontier, walls, word, shifts);
+			const auto southEast = Shifted(frontier, word, shifts[4]);
+			const auto southWest = Shifted(frontier, word, shifts[5]);
+			const auto northEast = Shifted(frontier, word, shifts[6]);
+			const auto northWest = Shifted(frontier, word, shifts[7]);
+
+			if (Rule == CornerCutting::Allow)
+				return straight | southEast | southWest | northEast | northWest;
+
+			// A diagonal move from x to x + a + b passes x + a and x + b, seen from the target
+			// these are the cells a row and a column back, the walls shifted by b and by a
+			const auto south = ~Shifted(walls, word, shifts[0]);
+			const auto north = ~Shifted(walls, word, shifts[1]);
+			const auto east = ~Shifted(walls, word, shifts[2]);
+			const auto west = ~Shifted(walls, word, shifts[3]);
+
+			return straight | (southEast & south & east) | (southWest & south & west)
+				| (northEast & north & east) | (northWest & north & west);
+		}
+	};
+}
+
+template <typename Conn>
+WavefrontSearch<Conn>::WavefrontSearch(const WavefrontMode mode)
+	: m_mode(mode)
+{
+}
+
+template <typename Conn>
+void WavefrontSearch<Conn>::Start(Grid *grid)
+{
+	SearchEngine::Start(grid);
+
+	// Enough guard words for the largest offset, a row and a cell
+	const auto words = grid->GetWordCount();
+	const auto stride = grid->GetStride();
+	this->m_padding = (stride + 1) / 64 + 2;
+	this->m_frontier.assign(words + 2 * this->m_padding, 0);
+	this->m_next.assign(words + 2 * this->m_padding, 0);
+	this->m_walls.assign(words + 2 * this->m_padding, 0);
+
+	// Bits past the last id count as walls
+	std::copy(grid->GetWallWords(), grid->GetWallWords() + words, this->m_walls.begin() + this->m_padding);
+	if ((grid->GetCapacity() & 63) != 0)
+		this->m_walls[this->m_padding + words - 1] |= ~((GridWord(1) << (grid->GetCapacity() & 63)) - 1);
+
+	int offsets[Conn::Count];
+	WavefrontRules<Conn>::Offsets(stride, offsets);
+	for (auto i = 0; i < Conn::Count; i++)
+		this->m_shifts[i] = MakeShift(offsets[i]);
+
+	// A shifted word takes bits from two source words, so each shift reaches two words
+	this->m_wordShifts.clear();
+	for (const auto &shift : this->m_shifts)
+	{
+		for (auto offset = shift.words; offset <= shift.words + (shift.bits != 0); offset++)
+		{
+			const auto wordShift = MakeShift(offset);
+			if (std::find_if(this->m_wordShifts.begin(), this->m_wordShifts.end(), [&](const BitShift &other)
+				{ return other.words == wordShift.words && other.bits == wordShift.bits; }) == this->m_wordShifts.end())
+				this->m_wordShifts.push_back(wordShift);
+		}
+	}
+
+	const auto activeWords = (words + 63) / 64;
+	this->m_activePadding = this->m_padding / 64 + 2;
+	this->m_active.assign(activeWords + 2 * this->m_activePadding, 0);
+	this->m_nextActive.assign(activeWords + 2 * this->m_activePadding, 0);
+
+	// Starting point
+	const auto start = grid->GetStart();
+	const auto startWord = start >> 6;
+	grid->SetVisited(start, true);
+	grid->SetDistance(start, 0);
+	this->m_frontier[this->m_padding + startWord] = GridWord(1) << (start & 63);
+	this->m_active[this->m_activePadding + (startWord >> 6)] = GridWord(1) << (startWord & 63);
+	this->m_activeBegin = startWord >> 6;
+	this->m_activeEnd = this->m_activeBegin + 1;
+	this->m_frontierSize = 1;
+	this->m_distance = 0;
+
+	if (start == grid->GetGoal())
+	{
+		Finish(start);
+		return;
+	}
+
+	// The whole search happens here, steps have nothing left to do
+	if (this->m_mode == WavefrontMode::Reachability)
+	{
+		this->m_stats.expansions = Flood();
+		const auto goal = grid->GetGoal();
+		Finish(goal != NO_CELL && grid->WasVisited(goal) ? goal : NO_CELL);
+	}
+}
+
+template <typename Conn>
+bool WavefrontSearch<Conn>::Step()
+{
+	if (this->m_finished)
+		return false;
+
+	if (this->m_frontierSize == 0)
+	{
+		Finish(NO_CELL); // Goal NOT found
+		return false;
+	}
+
+	const auto grid = this->m_grid;
+	const auto words = grid->GetWordCount();
+	const auto frontier = this->m_frontier.data() + this->m_padding;
+	const auto next = this->m_next.data() + this->m_padding;
+	const auto walls = this->m_walls.data() + this->m_padding;
+	const auto visited = grid->GetVisitedWords();
+	const auto active = this->m_active.data() + this->m_activePadding;
+	const auto nextActive = this->m_nextActive.data() + this->m_activePadding;
+	const auto shifts = this->m_shifts;
+	const auto distance = this->m_distance + 1;
+
+	this->m_stats.expansions += this->m_frontierSize;
+	if (this->m_trace != nullptr)
+	{
+		for (auto index = this->m_activeBegin; index < this->m_activeEnd; index++)
+		{
+			for (auto wordBits = active[index]; wordBits != 0; wordBits &= wordBits - 1)
+			{
+				const auto word = index * 64 + LowestBit(wordBits);
+				for (auto bits = frontier[word]; bits != 0; bits &= bits - 1)
+					this->m_trace->push_back(word * 64 + LowestBit(bits));
+			}
+		}
+	}
+
+	// The active bitmap spreads by at most its padding
+	const auto begin = std::max(0, this->m_activeBegin - this->m_activePadding + 1);
+	const auto end = std::min((words + 63) / 64, this->m_activeEnd + this->m_activePadding - 1);
+	auto nextBegin = end;
+	auto nextEnd = begin;
+	std::size_t nextSize = 0;
+
+	for (auto index = begin; index < end; index++)
+	{
+		// Words the frontier can reach
+		GridWord candidates = 0;
+		for (const auto &shift : this->m_wordShifts)
+			candidates |= Shifted(active, index, shift);
+
+		GridWord reached = 0;
+		for (; candidates != 0; candidates &= candidates - 1)
+		{
+			// The next level, 64 cells per word operation. Spread only reads the frontier and the
+			// mask only the visited word being written, so new cells can be recorded right away
+			const auto word = index * 64 + LowestBit(candidates);
+			const auto bits = word < words
+				? WavefrontRules<Conn>::Spread(frontier, walls, word, shifts) & ~(walls[word] | visited[word])
+				: 0;
+			next[word] = bits;
+			if (bits == 0)
+				continue;
+
+			// Record the level of every new cell
+			visited[word] |= bits;
+			reached |= GridWord(1) << (word & 63);
+			nextSize += CountBits(bits);
+
+			for (auto remaining = bits; remaining != 0; remaining &= remaining - 1)
+				grid->SetDistance(word * 64 + LowestBit(remaining), distance);
+		}
+
+		nextActive[index] = reached;
+		if (reached != 0)
+		{
+			nextBegin = std::min(nextBegin, index);
+			nextEnd = index + 1;
+		}
+	}
+
+	// Empty the current level, it becomes the buffer of the one after next
+	for (auto index = this->m_activeBegin; index < this->m_activeEnd; index++)
+	{
+		for (auto wordBits = active[index]; wordBits != 0; wordBits &= wordBits - 1)
+			frontier[index * 64 + LowestBit(wordBits)] = 0;
+		active[index] = 0;
+	}
+
+	std::swap(this->m_frontier, this->m_next);
+	std::swap(this->m_active, this->m_nextActive);
+	this->m_activeBegin = nextBegin;
+	this->m_activeEnd = nextEnd;
+	this->m_frontierSize = nextSize;
+	this->m_distance = distance;
+
+	if (nextSize > this->m_stats.peakFrontier)
+		this->m_stats.peakFrontier = nextSize;
+
+	const auto goal = grid->GetGoal();
+	if (goal != NO_CELL && grid->WasVisited(goal))
+	{
+		FillPath(goal);
+		Finish(goal); // Goal found
+		return false;
+	}
+	return true;
+}
+
+template <typename Conn>
+std::size_t WavefrontSearch<Conn>::Flood()
+{
+	const auto grid = this->m_grid;
+	const auto words = grid->GetWordCount();
+	const auto region = this->m_frontier.data() + this->m_padding;
+	const auto walls = this->m_walls.data() + this->m_padding;
+	const auto shifts = this->m_shifts;
+
+	// Moves from the words a sweep already passed reach any distance in its direction
+	const auto update = [&](const int word, const bool up)
+	{
+		const auto open = ~walls[word];
+		const auto reached = region[word] | (WavefrontRules<Conn>::Spread(region, walls, word, shifts) & open);
+		const auto filled = up ? FillUp(reached, open) : FillDown(reached, open);
+		const auto changed = filled != region[word];
+		region[word] = filled;
+		return changed;
+	};
+
+	// Stops once nothing changes, or at the first sweep that reaches the goal
+	const auto goal = grid->GetGoal();
+	const auto reachedGoal = [&] { return goal != NO_CELL && ((region[goal >> 6] >> (goal & 63)) & 1) != 0; };
+	for (auto changed = true; changed && !reachedGoal();)
+	{
+		changed = false;
+		for (auto word = 0; word < words; word++)
+			changed |= update(word, true);
+		if (reachedGoal())
+			break;
+		for (auto word = words - 1; word >= 0; word--)
+			changed |= update(word, false);
+	}
+
+	// The region becomes the visited cells
+	const auto visited = grid->GetVisitedWords();
+	std::size_t cells = 0;
+	for (auto word = 0; word < words; word++)
+	{
+		visited[word] = region[word];
+		cells += CountBits(region[word]);
+		if (this->m_trace != nullptr)
+		{
+			for (auto bits = region[word]; bits != 0; bits &= bits - 1)
+				this->m_trace->push_back(word * 64 + LowestBit(bits));
+		}
+	}
+	return cells;
+}
+
+template <typename Conn>
+std::size_t WavefrontSearch<Conn>::GetAllocatedBytes() const
+{
+	return SearchEngine::GetAllocatedBytes() + GetBufferBytes(this->m_frontier) + GetBufferBytes(this->m_next)
+		+ GetBufferBytes(this->m_walls) + GetBufferBytes(this->m_active) + GetBufferBytes(this->m_nextActive)
+		+ GetBufferBytes(this->m_wordShifts);
+}
+
+template <typename Conn>
+void WavefrontSearch<Conn>::FillPath(const int goal)
+{
+	const auto grid = this->m_grid;
+	const auto start = grid->GetStart();
+
+	// Moves are symmetric, so a neighbor one level closer is a valid parent
+	for (auto current = goal; current != start;)
+	{
+		const auto distance = grid->GetDistance(current) - 1;
+		auto parent = NO_CELL;
+		Conn::ForEach(grid, current, [&](const int next, bool)
+		{
+			if (!grid->WasVisited(next) || grid->GetDistance(next) != distance)
+				return true;
+
+			parent = next;
+			return false;
+		});
+
+		grid->SetPrevious(current, parent);
+		current = parent;
+	}
+}
+
+INSTANTIATE_ENGINE(WavefrontSearch)